@@ -13,11 +13,28 @@
 // =============================================================================
 
 // Includes --------------------------------------------------------------------
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 #include "Arena/ArenaApi.h"
 #include "IMX501Utils.h"
 
+// The SSSE3 path is picked at run time, x86 builds only need to compile it
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define IMX501_UTILS_SSSE3      1
+#include <tmmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define IMX501_UTILS_TARGET_SSSE3
+#else
+#include <cpuid.h>
+#define IMX501_UTILS_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+#else
+#define IMX501_UTILS_SSSE3      0
+#endif
+
 // Macros ----------------------------------------------------------------------
 #define FPK_INFO_SIGNATURE      0x4443554C  // 'L' 'U' 'C' 'D'
 #define FPK_INFO_CHIP_ID        501         // IMX501
@@ -26,6 +43,96 @@
 // Namespace -------------------------------------------------------------------
 namespace ArenaExample {
 
+// ><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><>
+//  Local functions
+// ><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><>
+typedef void (*InterleaveFunc)(const uint8_t *inR, const uint8_t *inG, const uint8_t *inB,
+                               size_t inNum, uint8_t inOffset, uint8_t *outBGR);
+
+// -----------------------------------------------------------------------------
+//  InterleavePlanes
+//    Writes inNum BGR pixels from the R, G and B planes, XORing inOffset in
+// -----------------------------------------------------------------------------
+static void InterleavePlanes(const uint8_t *inR, const uint8_t *inG, const uint8_t *inB,
+                             size_t inNum, uint8_t inOffset, uint8_t *outBGR)
+{
+  for (size_t n = 0; n < inNum; n++)
+  {
+    outBGR[0] = inB[n] ^ inOffset;
+    outBGR[1] = inG[n] ^ inOffset;
+    outBGR[2] = inR[n] ^ inOffset;
+    outBGR += 3;
+  }
+}
+
+#if IMX501_UTILS_SSSE3
+// -----------------------------------------------------------------------------
+//  InterleavePlanesSSSE3
+//    16 pixels at a time, each 16 byte block of the output is put together
+//    from the three planes with one shuffle each
+// -----------------------------------------------------------------------------
+IMX501_UTILS_TARGET_SSSE3
+static void InterleavePlanesSSSE3(const uint8_t *inR, const uint8_t *inG, const uint8_t *inB,
+                                  size_t inNum, uint8_t inOffset, uint8_t *outBGR)
+{
+  const __m128i offset = _mm_set1_epi8((char )inOffset);
+  const __m128i b0 = _mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5);
+  const __m128i g0 = _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1);
+  const __m128i r0 = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+  const __m128i b1 = _mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1);
+  const __m128i g1 = _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10);
+  const __m128i r1 = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1);
+  const __m128i b2 = _mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1);
+  const __m128i g2 = _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1);
+  const __m128i r2 = _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15);
+
+  size_t n = 0;
+  for (; n + 16 <= inNum; n += 16)
+  {
+    __m128i r = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(inR + n)), offset);
+    __m128i g = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(inG + n)), offset);
+    __m128i b = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(inB + n)), offset);
+    _mm_storeu_si128((__m128i *)outBGR,
+      _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(b, b0), _mm_shuffle_epi8(g, g0)), _mm_shuffle_epi8(r, r0)));
+    _mm_storeu_si128((__m128i *)(outBGR + 16),
+      _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(b, b1), _mm_shuffle_epi8(g, g1)), _mm_shuffle_epi8(r, r1)));
+    _mm_storeu_si128((__m128i *)(outBGR + 32),
+      _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(b, b2), _mm_shuffle_epi8(g, g2)), _mm_shuffle_epi8(r, r2)));
+    outBGR += 48;
+  }
+  InterleavePlanes(inR + n, inG + n, inB + n, inNum - n, inOffset, outBGR);
+}
+
+// -----------------------------------------------------------------------------
+//  HasSSSE3
+// -----------------------------------------------------------------------------
+static bool HasSSSE3()
+{
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+  return (info[2] & (1 << 9)) != 0;
+#else
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0)
+    return false;
+  return (ecx & bit_SSSE3) != 0;
+#endif
+}
+#endif
+
+// -----------------------------------------------------------------------------
+//  SelectInterleaveFunc
+// -----------------------------------------------------------------------------
+static InterleaveFunc SelectInterleaveFunc()
+{
+#if IMX501_UTILS_SSSE3
+  if (HasSSSE3())
+    return InterleavePlanesSSSE3;
+#endif
+  return InterleavePlanes;
+}
+
 // ><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><>
 //  IMX501Utils class
 // ><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><><>
@@ -51,9 +158,13 @@ IMX501Utils::IMX501Utils(/*Arena::IDevice *inDevice, bool inVerboseMode*/)
   mChunkBuf = NULL;
   mTensorBuf = NULL;
   mInputImageBuf = NULL;
+  mTensorBufSize = 0;
+  mInputImageBufSize = 0;
 
   mInputTensorsPtr = NULL;
   mInputTensorsSize = 0;
+  mTensorLineWidth = 0;
+  mTensorLineStride = 0;
   mOutputTensorsPtr = NULL;
   mOutputTensorsSize = 0;
 
@@ -61,9 +172,16 @@ IMX501Utils::IMX501Utils(/*Arena::IDevice *inDevice, bool inVerboseMode*/)
   mInputImageWidth = 0;
   mInputImageHeight = 0;
   mInputImageType = InputImageType::IMAGE_UNKNOWN;
+  mInputImageExtracted = false;
 
   mApParams = NULL;
+  mTensorLayout.valid = false;
+  memset(&mTensorLayout.inputImage, 0, sizeof(mTensorLayout.inputImage));
   mDataExtracted = false;
+  mChunkStatus = ChunkStatus::CHUNK_NOT_INITIALIZED;
+
+  mMetadataLoaded = false;
+  mNetworkFingerprint = 0;
 }
 
 // -----------------------------------------------------------------------------
@@ -73,12 +191,7 @@ IMX501Utils::~IMX501Utils()
 {
   if (mLabelData != 0)
     delete[] mLabelData;
-  if (mChunkBuf != 0)
-    delete[] mChunkBuf;
-  if (mTensorBuf != 0)
-    delete[] mTensorBuf;
-  if (mInputImageBuf != 0)
-    delete[] mInputImageBuf;
+  FreeBuffers();
 }
 
 // -----------------------------------------------------------------------------
@@ -131,44 +244,37 @@ void IMX501Utils::InitCameraToOutputDNN(bool inEnableNoRawOutput, bool inEnableS
       printf("Enable: Done\n");
   }
 
-  SetBooleanNode(mNodeMap, "GammaEnable", true);
-  SetFloatNode(mNodeMap, "Gamma", 0.45);
-
-  RetrieveFPKinfo(mNodeMap, &mFPKinfo);
-  if (mVerboseMode)
-    DumpFPKinfo(&mFPKinfo);
-  if (ValidateFPKinfo(&mFPKinfo) == false)
-    throw std::runtime_error("Received invalid fpk_info");
-
-  mLabelData = RetrieveLabelData(mNodeMap, &mLabelDataSize);
-  if (mLabelDataSize != 0)
-    MakeLabelList(mLabelData, mLabelDataSize, &mLabelList);
-
-  mChunkWidth = (size_t)mFPKinfo.dnn[0].dd_ch7_x;
-  mChunkHeight = (size_t)mFPKinfo.dnn[0].dd_ch7_y + (size_t)mFPKinfo.dnn[0].dd_ch8_y;
-  mReceiveBufSize = mChunkWidth * mChunkHeight;
-  mChunkBuf = new uint8_t[mReceiveBufSize];
-  if (mChunkBuf == NULL)
-    throw std::runtime_error("mChunkBuf == NULL");
-
-  mTensorBuf = new uint8_t[mReceiveBufSize];
-  if (mTensorBuf == NULL)
+  // Every write goes to the camera, so Gamma is only set when it differs
+  GenApi::CBooleanPtr pGammaEnable = mNodeMap->GetNode("GammaEnable");
+  if (pGammaEnable == NULL || pGammaEnable->GetValue() != true)
+    SetBooleanNode(mNodeMap, "GammaEnable", true);
+  GenApi::CFloatPtr pGamma = mNodeMap->GetNode("Gamma");
+  if (pGamma == NULL || fabs(pGamma->GetValue() - 0.45) > 0.001)
+    SetFloatNode(mNodeMap, "Gamma", 0.45);
+
+  // The files are read through the FileAccess nodes, which takes seconds
+  uint64_t fingerprint = GetNetworkFingerprint();
+  if (mMetadataLoaded == false || fingerprint != mNetworkFingerprint)
   {
-    delete[] mChunkBuf;
-    mChunkBuf = NULL;
-    throw std::runtime_error("mTensorBuf == NULL");
+    RetrieveFPKinfo(mNodeMap, &mFPKinfo);
+    if (mVerboseMode)
+      DumpFPKinfo(&mFPKinfo);
+    if (ValidateFPKinfo(&mFPKinfo) == false)
+      throw std::runtime_error("Received invalid fpk_info");
+
+    if (mLabelData != 0)
+      delete[] mLabelData;
+    mLabelData = NULL;
+    mLabelList.clear();
+    mLabelData = RetrieveLabelData(mNodeMap, &mLabelDataSize);
+    if (mLabelDataSize != 0)
+      MakeLabelList(mLabelData, mLabelDataSize, &mLabelList);
+
+    mNetworkFingerprint = fingerprint;
+    mMetadataLoaded = true;
   }
 
-  mInputImageBuf = new uint8_t[mReceiveBufSize];
-  if (mInputImageBuf == NULL)
-  {
-    delete[] mChunkBuf;
-    mChunkBuf = NULL;
-    delete[] mTensorBuf;
-    mTensorBuf = NULL;
-    throw std::runtime_error("mInputImageBuf == NULL");
-  }
-  mInputImageType = (InputImageType )mFPKinfo.dnn[0].input_tensor_format;
+  AllocateBuffers();
 
   if (inEnableNoRawOutput != false)
   {
@@ -178,59 +284,94 @@ void IMX501Utils::InitCameraToOutputDNN(bool inEnableNoRawOutput, bool inEnableS
 }
 
 // -----------------------------------------------------------------------------
-//  SetChunkData
+//  InitFromRecordedData
 // -----------------------------------------------------------------------------
-void IMX501Utils::SetChunkData(Arena::IChunkData *inChunkData)
+void IMX501Utils::InitFromRecordedData(const void *inFPKinfo, size_t inFPKinfoSize,
+                                       const uint8_t *inLabelData, size_t inLabelDataSize,
+                                       uint64_t inNetworkFingerprint)
 {
   mDataExtracted = false;
-  if (mDevice == NULL || inChunkData == NULL ||
-      mChunkBuf == NULL || mTensorBuf == NULL || mInputImageBuf == NULL)
-    throw std::runtime_error("Necessary object or buffer is NULL");
 
-  if (inChunkData->IsIncomplete())
-    throw std::runtime_error("inChunkData->IsIncomplete() returned true");
+  if (inFPKinfo == NULL || inFPKinfoSize < sizeof(fpk_info))
+    throw std::runtime_error("Recorded fpk_info is too small");
 
-  memset(mChunkBuf, 0, mReceiveBufSize);
-  memset(mTensorBuf, 0, mReceiveBufSize);
-  memset(mInputImageBuf, 0, mReceiveBufSize);
-
-  int64_t dataSize;
-  GetChunkNeuralNetworkData(inChunkData, mChunkBuf, mReceiveBufSize, &dataSize);
+  memcpy(&mFPKinfo, inFPKinfo, sizeof(fpk_info));
   if (mVerboseMode)
+    DumpFPKinfo(&mFPKinfo);
+  if (ValidateFPKinfo(&mFPKinfo) == false)
+    throw std::runtime_error("Received invalid fpk_info");
+
+  if (mLabelData != 0)
+    delete[] mLabelData;
+  mLabelData = NULL;
+  mLabelDataSize = 0;
+  mLabelList.clear();
+  if (inLabelData != NULL && inLabelDataSize != 0)
   {
-    printf("[InputTensor]\n");
-    DumpTensorHeader(GetInputTensorHeader());
-    printf("[OutputTensor]\n");
-    DumpTensorHeader(GetOutputTensorHeader());
+    mLabelData = new uint8_t[inLabelDataSize];
+    memcpy(mLabelData, inLabelData, inLabelDataSize);
+    mLabelDataSize = inLabelDataSize;
+    MakeLabelList(mLabelData, mLabelDataSize, &mLabelList);
   }
-  ExtractTensorData(&mFPKinfo, GetInputTensorHeader(),
-                    mChunkBuf, mReceiveBufSize,
-                    mTensorBuf);
-  ExtractTensors(&mFPKinfo, GetInputTensorHeader(),
-                mTensorBuf, mReceiveBufSize,
-                 &mInputTensorsPtr, &mInputTensorsSize,
-                 &mOutputTensorsPtr, &mOutputTensorsSize);
 
-  mApParams = apParams::fb::GetFBApParams(GetInputTensorAPParameterBufPtr());
-  if (mVerboseMode)
+  mNetworkFingerprint = inNetworkFingerprint;
+  mMetadataLoaded = true;
+
+  AllocateBuffers();
+}
+
+// -----------------------------------------------------------------------------
+//  SetChunkData
+// -----------------------------------------------------------------------------
+IMX501Utils::ChunkStatus IMX501Utils::SetChunkData(Arena::IChunkData *inChunkData)
+{
+  mDataExtracted = false;
+  mInputImageExtracted = false;
+  if (mChunkBuf == NULL || mTensorBuf == NULL || mInputImageBuf == NULL)
+    mChunkStatus = ChunkStatus::CHUNK_NOT_INITIALIZED;
+  else if (inChunkData == NULL)
+    mChunkStatus = ChunkStatus::CHUNK_MISSING;
+  else if (inChunkData->IsIncomplete())
+    mChunkStatus = ChunkStatus::CHUNK_INCOMPLETE;
+  else
   {
-    printf("[InputTensor]\n");
-    DumpAPparameter(mApParams);
+    int64_t dataSize;
+    mChunkStatus = GetChunkNeuralNetworkData(inChunkData, mChunkBuf, mReceiveBufSize, &dataSize);
+    if (mChunkStatus == ChunkStatus::CHUNK_OK)
+    {
+      // Only a short chunk leaves bytes of the previous one behind
+      if ((size_t)dataSize < mReceiveBufSize)
+        memset(mChunkBuf + dataSize, 0, mReceiveBufSize - (size_t)dataSize);
+      mChunkStatus = ExtractChunkData();
+    }
   }
+  return mChunkStatus;
+}
 
-  ExtractInputImage(&mFPKinfo,
-                    mApParams, mInputTensorsPtr, mInputTensorsSize,
-                    mInputImageBuf, &mInputImageSize,
-                    &mInputImageWidth, &mInputImageHeight);
-
-  if (mVerboseMode)
+// -----------------------------------------------------------------------------
+//  SetChunkData
+// -----------------------------------------------------------------------------
+IMX501Utils::ChunkStatus IMX501Utils::SetChunkData(const uint8_t *inData, size_t inDataSize)
+{
+  mDataExtracted = false;
+  mInputImageExtracted = false;
+  if (mChunkBuf == NULL || mTensorBuf == NULL || mInputImageBuf == NULL)
+    mChunkStatus = ChunkStatus::CHUNK_NOT_INITIALIZED;
+  else if (inData == NULL)
+    mChunkStatus = ChunkStatus::CHUNK_MISSING;
+  else if (inDataSize == 0)
+    mChunkStatus = ChunkStatus::CHUNK_EMPTY;
+  else if (inDataSize > mReceiveBufSize)
+    mChunkStatus = ChunkStatus::CHUNK_TOO_LARGE;
+  else
   {
-    const apParams::fb::FBApParams  *params;
-    params = apParams::fb::GetFBApParams(GetOutputTensorAPParameterBufPtr());
-    printf("[OutputTensor]\n");
-    DumpAPparameter(params);
+    memcpy(mChunkBuf, inData, inDataSize);
+    // Only a short chunk leaves bytes of the previous one behind
+    if (inDataSize < mReceiveBufSize)
+      memset(mChunkBuf + inDataSize, 0, mReceiveBufSize - inDataSize);
+    mChunkStatus = ExtractChunkData();
   }
-  mDataExtracted = true;
+  return mChunkStatus;
 }
 
 // -----------------------------------------------------------------------------
@@ -238,6 +379,7 @@ void IMX501Utils::SetChunkData(Arena::IChunkData *inChunkData)
 // -----------------------------------------------------------------------------
 bool IMX501Utils::ProcessChunkData(Arena::IChunkData *inChunkData)
 {
+  // Only the GenApi access throws, invalid data is reported by the status
   try
   {
     SetChunkData(inChunkData);
@@ -262,9 +404,71 @@ bool IMX501Utils::ProcessChunkData(Arena::IChunkData *inChunkData)
     return false;
   }
 
+  if (mChunkStatus != ChunkStatus::CHUNK_OK)
+  {
+    if (IsVerboseMode())
+      printf("Error: %s\n", GetChunkStatusStr(mChunkStatus));
+    return false;
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+//  ProcessChunkData
+// -----------------------------------------------------------------------------
+bool IMX501Utils::ProcessChunkData(const uint8_t *inData, size_t inDataSize)
+{
+  if (SetChunkData(inData, inDataSize) != ChunkStatus::CHUNK_OK)
+  {
+    if (IsVerboseMode())
+      printf("Error: %s\n", GetChunkStatusStr(mChunkStatus));
+    return false;
+  }
   return true;
 }
 
+// -----------------------------------------------------------------------------
+//  GetChunkStatus
+// -----------------------------------------------------------------------------
+IMX501Utils::ChunkStatus IMX501Utils::GetChunkStatus()
+{
+  return mChunkStatus;
+}
+
+// -----------------------------------------------------------------------------
+//  GetChunkStatusStr
+// -----------------------------------------------------------------------------
+const char *IMX501Utils::GetChunkStatusStr(ChunkStatus inStatus)
+{
+  switch (inStatus)
+  {
+    case ChunkStatus::CHUNK_OK:
+      return "OK";
+    case ChunkStatus::CHUNK_NOT_INITIALIZED:
+      return "No network description";
+    case ChunkStatus::CHUNK_INCOMPLETE:
+      return "Incomplete chunk data";
+    case ChunkStatus::CHUNK_MISSING:
+      return "Missing chunk data [ChunkDeepNeuralNetwork]";
+    case ChunkStatus::CHUNK_EMPTY:
+      return "ChunkDeepNeuralNetworkLength is 0";
+    case ChunkStatus::CHUNK_TOO_LARGE:
+      return "ChunkDeepNeuralNetworkLength is bigger than the receive buffer";
+    case ChunkStatus::CHUNK_INPUT_TENSOR_INVALID:
+      return "Input tensor is invalid (valid_flag == 0)";
+    case ChunkStatus::CHUNK_OUTPUT_TENSOR_INVALID:
+      return "Output tensor is invalid (valid_flag == 0)";
+    case ChunkStatus::CHUNK_BAD_LINE_LENGTH:
+      return "max_length_of_line does not fit the chunk lines";
+    case ChunkStatus::CHUNK_BAD_INPUT_TENSOR:
+      return "Unknown input tensor format";
+    case ChunkStatus::CHUNK_BAD_AP_PARAMETER:
+      return "AP parameter is broken";
+    default:
+      return "Unknown status";
+  }
+}
+
 // -----------------------------------------------------------------------------
 //  GetInputTensorHeader
 // -----------------------------------------------------------------------------
@@ -299,12 +503,28 @@ size_t IMX501Utils::GetInputTensorsBufSize()
   return mInputTensorsSize;
 }
 
+// -----------------------------------------------------------------------------
+//  GetTensorLineWidth
+// -----------------------------------------------------------------------------
+size_t IMX501Utils::GetTensorLineWidth()
+{
+  return mTensorLineWidth;
+}
+
+// -----------------------------------------------------------------------------
+//  GetTensorLineStride
+// -----------------------------------------------------------------------------
+size_t IMX501Utils::GetTensorLineStride()
+{
+  return mTensorLineStride;
+}
+
 // -----------------------------------------------------------------------------
 //  GetInputTensorNum
 // -----------------------------------------------------------------------------
 uint32_t IMX501Utils::GetInputTensorNum()
 {
-  return mApParams->networks()->Get(0)->inputTensors()->size();
+  return (uint32_t )mTensorLayout.inputTensors.size();
 }
 
 // -----------------------------------------------------------------------------
@@ -312,14 +532,10 @@ uint32_t IMX501Utils::GetInputTensorNum()
 // -----------------------------------------------------------------------------
 bool IMX501Utils::GetInputTensorInfo(uint32_t inIndex, input_tensor_info *outInfo)
 {
-  if (inIndex >= mApParams->networks()->Get(0)->inputTensors()->size())
+  if (inIndex >= mTensorLayout.inputTensors.size())
     return false;
 
-  outInfo->id = mApParams->networks()->Get(0)->inputTensors()->Get(inIndex)->id();
-  outInfo->numOfDimensions = mApParams->networks()->Get(0)->inputTensors()->Get(inIndex)->numOfDimensions();
-  outInfo->shift = mApParams->networks()->Get(0)->inputTensors()->Get(inIndex)->shift();
-  outInfo->scale = mApParams->networks()->Get(0)->inputTensors()->Get(inIndex)->scale();
-  outInfo->format = mApParams->networks()->Get(0)->inputTensors()->Get(inIndex)->format();
+  *outInfo = mTensorLayout.inputTensors[inIndex].info;
   return true;
 }
 
@@ -328,15 +544,12 @@ bool IMX501Utils::GetInputTensorInfo(uint32_t inIndex, input_tensor_info *outInf
 // -----------------------------------------------------------------------------
 bool IMX501Utils::GetInputTensorDimensionInfo(uint32_t inIndex, uint32_t inDim, dimension_info *outInfo)
 {
-  if (inIndex >= mApParams->networks()->Get(0)->inputTensors()->size())
+  if (inIndex >= mTensorLayout.inputTensors.size())
     return false;
-  if (inDim >= mApParams->networks()->Get(0)->inputTensors()->Get(inIndex)->numOfDimensions())
+  if (inDim >= mTensorLayout.inputTensors[inIndex].info.numOfDimensions)
     return false;
 
-  outInfo->id = mApParams->networks()->Get(0)->inputTensors()->Get(inIndex)->dimensions()->Get(inDim)->id();
-  outInfo->size = mApParams->networks()->Get(0)->inputTensors()->Get(inIndex)->dimensions()->Get(inDim)->size();
-  outInfo->serializationIndex = mApParams->networks()->Get(0)->inputTensors()->Get(inIndex)->dimensions()->Get(inDim)->serializationIndex();
-  outInfo->padding = mApParams->networks()->Get(0)->inputTensors()->Get(inIndex)->dimensions()->Get(inDim)->padding();
+  *outInfo = mTensorLayout.dimensions[mTensorLayout.inputTensors[inIndex].firstDimension + inDim];
   return true;
 }
 
@@ -383,7 +596,7 @@ size_t IMX501Utils::GetOutputTensorsBufSize()
 // -----------------------------------------------------------------------------
 uint32_t IMX501Utils::GetOutputTensorNum()
 {
-  return mApParams->networks()->Get(0)->outputTensors()->size();
+  return (uint32_t )mTensorLayout.outputTensors.size();
 }
 
 // -----------------------------------------------------------------------------
@@ -391,15 +604,10 @@ uint32_t IMX501Utils::GetOutputTensorNum()
 // -----------------------------------------------------------------------------
 bool IMX501Utils::GetOutputTensorInfo(uint32_t inIndex, output_tensor_info *outInfo)
 {
-  if (inIndex >= mApParams->networks()->Get(0)->outputTensors()->size())
+  if (inIndex >= mTensorLayout.outputTensors.size())
     return false;
 
-  outInfo->id = mApParams->networks()->Get(0)->outputTensors()->Get(inIndex)->id();
-  outInfo->numOfDimensions = mApParams->networks()->Get(0)->outputTensors()->Get(inIndex)->numOfDimensions();
-  outInfo->bitsPerElement = mApParams->networks()->Get(0)->outputTensors()->Get(inIndex)->bitsPerElement();
-  outInfo->shift = mApParams->networks()->Get(0)->outputTensors()->Get(inIndex)->shift();
-  outInfo->scale = mApParams->networks()->Get(0)->outputTensors()->Get(inIndex)->scale();
-  outInfo->format = mApParams->networks()->Get(0)->outputTensors()->Get(inIndex)->format();
+  *outInfo = mTensorLayout.outputTensors[inIndex].info;
   return true;
 }
 
@@ -408,9 +616,9 @@ bool IMX501Utils::GetOutputTensorInfo(uint32_t inIndex, output_tensor_info *outI
 // -----------------------------------------------------------------------------
 double IMX501Utils::GetOutputTensorScale(uint32_t inIndex)
 {
-  if (inIndex >= mApParams->networks()->Get(0)->outputTensors()->size())
+  if (inIndex >= mTensorLayout.outputTensors.size())
     return 0;
-  return mApParams->networks()->Get(0)->outputTensors()->Get(inIndex)->scale();
+  return mTensorLayout.outputTensors[inIndex].info.scale;
 }
 
 // -----------------------------------------------------------------------------
@@ -418,15 +626,12 @@ double IMX501Utils::GetOutputTensorScale(uint32_t inIndex)
 // -----------------------------------------------------------------------------
 bool IMX501Utils::GetOutputTensorDimensionInfo(uint32_t inIndex, uint32_t inDim, dimension_info *outInfo)
 {
-  if (inIndex >= mApParams->networks()->Get(0)->outputTensors()->size())
+  if (inIndex >= mTensorLayout.outputTensors.size())
     return false;
-  if (inDim >= mApParams->networks()->Get(0)->outputTensors()->Get(inIndex)->numOfDimensions())
+  if (inDim >= mTensorLayout.outputTensors[inIndex].info.numOfDimensions)
     return false;
 
-  outInfo->id = mApParams->networks()->Get(0)->outputTensors()->Get(inIndex)->dimensions()->Get(inDim)->id();
-  outInfo->size = mApParams->networks()->Get(0)->outputTensors()->Get(inIndex)->dimensions()->Get(inDim)->size();
-  outInfo->serializationIndex = mApParams->networks()->Get(0)->outputTensors()->Get(inIndex)->dimensions()->Get(inDim)->serializationIndex();
-  outInfo->padding = mApParams->networks()->Get(0)->outputTensors()->Get(inIndex)->dimensions()->Get(inDim)->padding();
+  *outInfo = mTensorLayout.dimensions[mTensorLayout.outputTensors[inIndex].firstDimension + inDim];
   return true;
 }
 
@@ -435,19 +640,9 @@ bool IMX501Utils::GetOutputTensorDimensionInfo(uint32_t inIndex, uint32_t inDim,
 // -----------------------------------------------------------------------------
 size_t  IMX501Utils::GetOutputTensorSize(uint32_t inIndex)
 {
-  output_tensor_info  info;
-  if (GetOutputTensorInfo(inIndex, &info) == false)
+  if (inIndex >= mTensorLayout.outputTensors.size())
     return 0;
-
-  dimension_info dimInfo;
-  size_t  tensorSize = 1;
-  for (uint32_t i = 0; i < info.numOfDimensions; i++)
-  {
-    GetOutputTensorDimensionInfo(inIndex, i, &dimInfo);
-    tensorSize *= ((size_t)dimInfo.size + (size_t)dimInfo.padding);
-  }
-  tensorSize *= ((size_t)info.bitsPerElement / 8);
-  return tensorSize;
+  return mTensorLayout.outputTensors[inIndex].size;
 }
 
 // -----------------------------------------------------------------------------
@@ -455,25 +650,12 @@ size_t  IMX501Utils::GetOutputTensorSize(uint32_t inIndex)
 // -----------------------------------------------------------------------------
 const void *IMX501Utils::GetOutputTensorPtr(uint32_t inIndex)
 {
-  const tensor_header *header = GetOutputTensorHeader();
-  if (header == NULL)
+  if (mOutputTensorsPtr == NULL)
     return NULL;
-  if (inIndex >= mApParams->networks()->Get(0)->outputTensors()->size())
+  if (inIndex >= mTensorLayout.outputTensors.size())
     return NULL;
-  size_t  offset = 0;
-
-  for (uint32_t i = 0; i < inIndex; i++)
-  {
-    size_t tensorSize = GetOutputTensorSize(i);
-    if (tensorSize == 0)
-      return NULL;
-    size_t lineNum = tensorSize / header->max_length_of_line;
-    if ((tensorSize % header->max_length_of_line) != 0)
-      lineNum++;
-    tensorSize = lineNum * header->max_length_of_line;
-    offset += tensorSize;
-  }
 
+  size_t  offset = mTensorLayout.outputTensors[inIndex].offset;
   if (offset > mOutputTensorsSize)
     return NULL;
   return &(mOutputTensorsPtr[offset]);
@@ -484,9 +666,32 @@ const void *IMX501Utils::GetOutputTensorPtr(uint32_t inIndex)
 // -----------------------------------------------------------------------------
 const uint8_t *IMX501Utils::GetInputImagePtr()
 {
+  if (!mDataExtracted)
+    return NULL;
+  if (!mInputImageExtracted)
+  {
+    ExtractInputImage(&mTensorLayout.inputImage, mInputTensorsPtr,
+                      mTensorLineWidth, mTensorLineStride, mInputImageBuf);
+    mInputImageExtracted = true;
+  }
   return mInputImageBuf;
 }
 
+// -----------------------------------------------------------------------------
+//  CopyInputImage
+// -----------------------------------------------------------------------------
+bool IMX501Utils::CopyInputImage(uint8_t *outBuf, size_t inBufSize)
+{
+  if (!mDataExtracted || outBuf == NULL || inBufSize < mInputImageSize)
+    return false;
+  if (mInputImageExtracted)
+    memcpy(outBuf, mInputImageBuf, mInputImageSize);
+  else
+    ExtractInputImage(&mTensorLayout.inputImage, mInputTensorsPtr,
+                      mTensorLineWidth, mTensorLineStride, outBuf);
+  return true;
+}
+
 // -----------------------------------------------------------------------------
 //  GetInputImageSize
 // -----------------------------------------------------------------------------
@@ -567,6 +772,99 @@ std::string IMX501Utils::GetLabelAndScoreStr(size_t inIndex, double inScore)
   return str;
 }
 
+// -----------------------------------------------------------------------------
+//  GetFPKinfoPtr
+// -----------------------------------------------------------------------------
+const void *IMX501Utils::GetFPKinfoPtr()
+{
+  return &mFPKinfo;
+}
+
+// -----------------------------------------------------------------------------
+//  GetFPKinfoSize
+// -----------------------------------------------------------------------------
+size_t IMX501Utils::GetFPKinfoSize()
+{
+  return sizeof(mFPKinfo);
+}
+
+// -----------------------------------------------------------------------------
+//  GetLabelDataPtr
+// -----------------------------------------------------------------------------
+const uint8_t *IMX501Utils::GetLabelDataPtr()
+{
+  return mLabelData;
+}
+
+// -----------------------------------------------------------------------------
+//  GetLabelDataSize
+// -----------------------------------------------------------------------------
+size_t IMX501Utils::GetLabelDataSize()
+{
+  return mLabelDataSize;
+}
+
+// -----------------------------------------------------------------------------
+//  GetNetworkFingerprint
+// -----------------------------------------------------------------------------
+uint64_t IMX501Utils::GetNetworkFingerprint()
+{
+  if (mDevice == NULL)
+    return mNetworkFingerprint;
+
+  static const char *fileNames[] = {
+    "DeepNeuralNetworkNetwork",
+    "DeepNeuralNetworkInfo",
+    "DeepNeuralNetworkClassification"
+  };
+  GenApi::INodeMap *pNodeMap = mDevice->GetNodeMap();
+  uint64_t hash = 14695981039346656037ULL;  // FNV-1a
+  for (size_t i = 0; i < sizeof(fileNames) / sizeof(fileNames[0]); i++)
+  {
+    int64_t fileSize = 0;
+    try
+    {
+      fileSize = GetFileSize(pNodeMap, fileNames[i]);
+    }
+    catch (GenICam::GenericException&)
+    {
+      // A file the camera does not expose does not change the fingerprint
+    }
+    for (int b = 0; b < 8; b++)
+    {
+      hash ^= (uint64_t)((fileSize >> (b * 8)) & 0xFF);
+      hash *= 1099511628211ULL;
+    }
+  }
+
+  // The tensor layout depends on fpk_info, which is small enough to read every time
+  fpk_info info;
+  memset(&info, 0, sizeof(info));
+  try
+  {
+    if (GetFileSize(pNodeMap, "DeepNeuralNetworkInfo") >= (int64_t )sizeof(fpk_info))
+      RetrieveFPKinfo(pNodeMap, &info);
+  }
+  catch (GenICam::GenericException&)
+  {
+  }
+  const uint8_t *bytes = (const uint8_t *)&info;
+  for (size_t i = 0; i < sizeof(info); i++)
+  {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+// -----------------------------------------------------------------------------
+//  DiscardNetworkData
+// -----------------------------------------------------------------------------
+void IMX501Utils::DiscardNetworkData()
+{
+  mMetadataLoaded = false;
+}
+
 // -----------------------------------------------------------------------------
 // Public static member functions -------------------------------------------
 // -----------------------------------------------------------------------------
@@ -604,6 +902,268 @@ void IMX501Utils::UploadFileToCamera(Arena::IDevice* inDevice,
 }
 
 
+// -----------------------------------------------------------------------------
+// Protected member functions --------------------------------------------------
+// -----------------------------------------------------------------------------
+//  AllocateBuffers
+// -----------------------------------------------------------------------------
+void IMX501Utils::AllocateBuffers()
+{
+  mChunkWidth = (size_t)mFPKinfo.dnn[0].dd_ch7_x;
+  mChunkHeight = (size_t)mFPKinfo.dnn[0].dd_ch7_y + (size_t)mFPKinfo.dnn[0].dd_ch8_y;
+  mInputImageType = (InputImageType )mFPKinfo.dnn[0].input_tensor_format;
+
+  // The tensor layout depends on fpk_info, it is built again with the next chunk
+  mTensorLayout.valid = false;
+
+  // The buffers are kept as long as the network needs the same size.
+  // mTensorBuf only ever holds the output tensor lines.
+  size_t tensorBufSize = mChunkWidth * (size_t)mFPKinfo.dnn[0].dd_ch8_y;
+  if (mChunkBuf != NULL && mTensorBuf != NULL && mInputImageBuf != NULL &&
+      mReceiveBufSize == mChunkWidth * mChunkHeight &&
+      mTensorBufSize == tensorBufSize)
+    return;
+
+  FreeBuffers();
+  mReceiveBufSize = mChunkWidth * mChunkHeight;
+  mChunkBuf = new uint8_t[mReceiveBufSize];
+  if (mChunkBuf == NULL)
+    throw std::runtime_error("mChunkBuf == NULL");
+
+  mTensorBufSize = tensorBufSize;
+  mTensorBuf = new uint8_t[mTensorBufSize];
+  if (mTensorBuf == NULL)
+  {
+    delete[] mChunkBuf;
+    mChunkBuf = NULL;
+    throw std::runtime_error("mTensorBuf == NULL");
+  }
+
+  mInputImageBufSize = mReceiveBufSize;
+  mInputImageBuf = new uint8_t[mInputImageBufSize];
+  if (mInputImageBuf == NULL)
+  {
+    delete[] mChunkBuf;
+    mChunkBuf = NULL;
+    delete[] mTensorBuf;
+    mTensorBuf = NULL;
+    throw std::runtime_error("mInputImageBuf == NULL");
+  }
+}
+
+// -----------------------------------------------------------------------------
+//  FreeBuffers
+// -----------------------------------------------------------------------------
+void IMX501Utils::FreeBuffers()
+{
+  mDataExtracted = false;
+  if (mChunkBuf != 0)
+    delete[] mChunkBuf;
+  mChunkBuf = NULL;
+  if (mTensorBuf != 0)
+    delete[] mTensorBuf;
+  mTensorBuf = NULL;
+  if (mInputImageBuf != 0)
+    delete[] mInputImageBuf;
+  mInputImageBuf = NULL;
+  mReceiveBufSize = 0;
+  mTensorBufSize = 0;
+  mInputImageBufSize = 0;
+  mInputTensorsPtr = NULL;
+  mOutputTensorsPtr = NULL;
+}
+
+// -----------------------------------------------------------------------------
+//  ExtractChunkData
+// -----------------------------------------------------------------------------
+IMX501Utils::ChunkStatus IMX501Utils::ExtractChunkData()
+{
+  const tensor_header *inputHeader = GetInputTensorHeader();
+  const tensor_header *outputHeader = GetOutputTensorHeader();
+  if (mVerboseMode)
+  {
+    printf("[InputTensor]\n");
+    DumpTensorHeader(inputHeader);
+    printf("[OutputTensor]\n");
+    DumpTensorHeader(outputHeader);
+  }
+  if (inputHeader->valid_flag == 0)
+    return ChunkStatus::CHUNK_INPUT_TENSOR_INVALID;
+  if (outputHeader->valid_flag == 0)
+    return ChunkStatus::CHUNK_OUTPUT_TENSOR_INVALID;
+
+  // The tensors stay where they are in mChunkBuf, only the line padding
+  // after max_length_of_line bytes has to be stepped over
+  size_t lineStride = mChunkWidth;
+  size_t lineWidth = inputHeader->max_length_of_line;
+  if (lineWidth == 0 || lineWidth > lineStride)
+    return ChunkStatus::CHUNK_BAD_LINE_LENGTH;
+  mTensorLineWidth = lineWidth;
+  mTensorLineStride = lineStride;
+
+  // skip input tensor header
+  size_t inputLineNum = (size_t)mFPKinfo.dnn[0].dd_ch7_y;
+  mInputTensorsPtr = mChunkBuf + lineStride;
+  mInputTensorsSize = lineWidth * (inputLineNum - 1);
+
+  // skip output tensor header. The network specific parsers read the output
+  // tensors as arrays, so their few lines are compacted when they are padded.
+  size_t outputLineNum = (size_t)mFPKinfo.dnn[0].dd_ch8_y;
+  const uint8_t *outputLines = mChunkBuf + lineStride * (inputLineNum + 1);
+  if (lineWidth == lineStride)
+  {
+    mOutputTensorsPtr = outputLines;
+  }
+  else
+  {
+    CompactTensorLines(outputLines, outputLineNum - 1, lineWidth, lineStride, mTensorBuf);
+    mOutputTensorsPtr = mTensorBuf;
+  }
+  mOutputTensorsSize = lineWidth * (outputLineNum - 1);
+
+  // The AP parameter is only read again when the network changes
+  ChunkStatus status = UpdateTensorLayout();
+  if (status != ChunkStatus::CHUNK_OK)
+    return status;
+  if (mVerboseMode)
+  {
+    printf("[InputTensor]\n");
+    DumpAPparameter(mApParams);
+  }
+
+  // Only the layout here, the image itself is extracted when it is asked for
+  mInputImageSize = mTensorLayout.inputImage.width * mTensorLayout.inputImage.height * 3;
+  if (mInputImageSize > mInputImageBufSize)
+    return ChunkStatus::CHUNK_BAD_INPUT_TENSOR;
+  mInputImageWidth = (int32_t )mTensorLayout.inputImage.width;
+  mInputImageHeight = (int32_t )mTensorLayout.inputImage.height;
+
+  if (mVerboseMode)
+  {
+    const apParams::fb::FBApParams  *params;
+    params = apParams::fb::GetFBApParams(GetOutputTensorAPParameterBufPtr());
+    printf("[OutputTensor]\n");
+    DumpAPparameter(params);
+  }
+  mDataExtracted = true;
+  return ChunkStatus::CHUNK_OK;
+}
+
+// -----------------------------------------------------------------------------
+//  UpdateTensorLayout
+// -----------------------------------------------------------------------------
+IMX501Utils::ChunkStatus IMX501Utils::UpdateTensorLayout()
+{
+  const tensor_header *inputHeader = GetInputTensorHeader();
+  const tensor_header *outputHeader = GetOutputTensorHeader();
+  mApParams = apParams::fb::GetFBApParams(GetInputTensorAPParameterBufPtr());
+  if (mTensorLayout.valid &&
+      mTensorLayout.networkId == inputHeader->network_id &&
+      mTensorLayout.apParameterSize == inputHeader->size_of_ap_parameter &&
+      mTensorLayout.inputLineLength == inputHeader->max_length_of_line &&
+      mTensorLayout.outputLineLength == outputHeader->max_length_of_line)
+    return ChunkStatus::CHUNK_OK;
+
+  mTensorLayout.valid = false;
+  mTensorLayout.inputTensors.clear();
+  mTensorLayout.outputTensors.clear();
+  mTensorLayout.dimensions.clear();
+  if (outputHeader->max_length_of_line == 0)
+    return ChunkStatus::CHUNK_BAD_LINE_LENGTH;
+
+  // The AP parameter is on the header line, the input tensor starts on the next one
+  size_t apParameterSize = inputHeader->size_of_ap_parameter;
+  if (sizeof(tensor_header) + apParameterSize > mTensorLineStride)
+    return ChunkStatus::CHUNK_BAD_AP_PARAMETER;
+  flatbuffers::Verifier verifier((const uint8_t *)GetInputTensorAPParameterBufPtr(), apParameterSize);
+  if (apParams::fb::VerifyFBApParamsBuffer(verifier) == false)
+    return ChunkStatus::CHUNK_BAD_AP_PARAMETER;
+
+  // The accessors take tensor 0 of network 0 for granted
+  if (mApParams->networks() == NULL || mApParams->networks()->size() == 0)
+    return ChunkStatus::CHUNK_BAD_AP_PARAMETER;
+  const apParams::fb::FBNetwork *network = mApParams->networks()->Get(0);
+  if (network->inputTensors() == NULL || network->inputTensors()->size() == 0 ||
+      network->outputTensors() == NULL)
+    return ChunkStatus::CHUNK_BAD_AP_PARAMETER;
+
+  for (uint32_t i = 0; i < network->inputTensors()->size(); i++)
+  {
+    const apParams::fb::FBInputTensor *tensor = network->inputTensors()->Get(i);
+    if (tensor->dimensions() == NULL || tensor->numOfDimensions() > tensor->dimensions()->size())
+      return ChunkStatus::CHUNK_BAD_AP_PARAMETER;
+
+    input_tensor_layout entry;
+    entry.info.id = tensor->id();
+    entry.info.numOfDimensions = tensor->numOfDimensions();
+    entry.info.shift = tensor->shift();
+    entry.info.scale = tensor->scale();
+    entry.info.format = tensor->format();
+    entry.firstDimension = mTensorLayout.dimensions.size();
+    for (uint32_t j = 0; j < entry.info.numOfDimensions; j++)
+    {
+      dimension_info dimInfo;
+      dimInfo.id = tensor->dimensions()->Get(j)->id();
+      dimInfo.size = tensor->dimensions()->Get(j)->size();
+      dimInfo.serializationIndex = tensor->dimensions()->Get(j)->serializationIndex();
+      dimInfo.padding = tensor->dimensions()->Get(j)->padding();
+      mTensorLayout.dimensions.push_back(dimInfo);
+    }
+    mTensorLayout.inputTensors.push_back(entry);
+  }
+
+  // Each output tensor starts on a new line. The tensors after one of size 0
+  // cannot be located.
+  size_t lineLength = outputHeader->max_length_of_line;
+  size_t offset = 0;
+  for (uint32_t i = 0; i < network->outputTensors()->size(); i++)
+  {
+    const apParams::fb::FBOutputTensor *tensor = network->outputTensors()->Get(i);
+    if (tensor->dimensions() == NULL || tensor->numOfDimensions() > tensor->dimensions()->size())
+      return ChunkStatus::CHUNK_BAD_AP_PARAMETER;
+
+    output_tensor_layout entry;
+    entry.info.id = tensor->id();
+    entry.info.numOfDimensions = tensor->numOfDimensions();
+    entry.info.bitsPerElement = tensor->bitsPerElement();
+    entry.info.shift = tensor->shift();
+    entry.info.scale = tensor->scale();
+    entry.info.format = tensor->format();
+    entry.firstDimension = mTensorLayout.dimensions.size();
+    entry.size = 1;
+    for (uint32_t j = 0; j < entry.info.numOfDimensions; j++)
+    {
+      dimension_info dimInfo;
+      dimInfo.id = tensor->dimensions()->Get(j)->id();
+      dimInfo.size = tensor->dimensions()->Get(j)->size();
+      dimInfo.serializationIndex = tensor->dimensions()->Get(j)->serializationIndex();
+      dimInfo.padding = tensor->dimensions()->Get(j)->padding();
+      mTensorLayout.dimensions.push_back(dimInfo);
+      entry.size *= ((size_t)dimInfo.size + (size_t)dimInfo.padding);
+    }
+    entry.size *= ((size_t)entry.info.bitsPerElement / 8);
+    entry.offset = offset;
+    mTensorLayout.outputTensors.push_back(entry);
+
+    if (entry.size == 0)
+      offset = SIZE_MAX;
+    else if (offset != SIZE_MAX)
+      offset += ((entry.size + lineLength - 1) / lineLength) * lineLength;
+  }
+
+  ChunkStatus status = GetInputImageLayout(&mFPKinfo, mApParams, mInputTensorsSize,
+                                           &mTensorLayout.inputImage);
+  if (status != ChunkStatus::CHUNK_OK)
+    return status;
+
+  mTensorLayout.networkId = inputHeader->network_id;
+  mTensorLayout.apParameterSize = inputHeader->size_of_ap_parameter;
+  mTensorLayout.inputLineLength = inputHeader->max_length_of_line;
+  mTensorLayout.outputLineLength = outputHeader->max_length_of_line;
+  mTensorLayout.valid = true;
+  return ChunkStatus::CHUNK_OK;
+}
+
 // -----------------------------------------------------------------------------
 // Protected static member functions -------------------------------------------
 // -----------------------------------------------------------------------------
@@ -733,7 +1293,7 @@ void IMX501Utils::DumpFPKinfo(const fpk_info *inInfo)
 // -----------------------------------------------------------------------------
 //  GetChunkNeuralNetworkData
 // -----------------------------------------------------------------------------
-void IMX501Utils::GetChunkNeuralNetworkData(Arena::IChunkData *inChunkData,
+IMX501Utils::ChunkStatus IMX501Utils::GetChunkNeuralNetworkData(Arena::IChunkData *inChunkData,
                               uint8_t *outBuf, size_t  inBufSize,
                               int64_t *outDataSize)
 {
@@ -742,23 +1302,24 @@ void IMX501Utils::GetChunkNeuralNetworkData(Arena::IChunkData *inChunkData,
       !GenApi::IsAvailable(pChunkDeepNeuralNetworkLength) ||
       !GenApi::IsReadable(pChunkDeepNeuralNetworkLength))
   {
-    throw GenICam::GenericException("missing chunk data [ChunkDeepNeuralNetworkLength]", __FILE__, __LINE__);
+    return ChunkStatus::CHUNK_MISSING;
   }
   *outDataSize = pChunkDeepNeuralNetworkLength->GetValue();
   if (*outDataSize == 0)
-    throw GenICam::GenericException("ChunkDeepNeuralNetworkLength is 0", __FILE__, __LINE__);
+    return ChunkStatus::CHUNK_EMPTY;
   if (*outDataSize > (int64_t )inBufSize)
-    throw GenICam::GenericException("ChunkDeepNeuralNetworkLength is bigger than inBufSize", __FILE__, __LINE__);
+    return ChunkStatus::CHUNK_TOO_LARGE;
 
   GenApi::CRegisterPtr pChunkDeepNeuralNetwork = inChunkData->GetChunk("ChunkDeepNeuralNetwork");
   if (!pChunkDeepNeuralNetwork ||
       !GenApi::IsAvailable(pChunkDeepNeuralNetwork) ||
       !GenApi::IsReadable(pChunkDeepNeuralNetwork))
   {
-    throw GenICam::GenericException("missing chunk data [ChunkDeepNeuralNetwork]", __FILE__, __LINE__);
+    return ChunkStatus::CHUNK_MISSING;
   }
 
   pChunkDeepNeuralNetwork->Get(outBuf, *outDataSize);
+  return ChunkStatus::CHUNK_OK;
 }
 
 // -----------------------------------------------------------------------------
@@ -843,80 +1404,38 @@ void IMX501Utils::DumpAPparameter(const apParams::fb::FBApParams *inParameter)
 }
 
 // -----------------------------------------------------------------------------
-//  ExtractTensorData
+//  CompactTensorLines
 // -----------------------------------------------------------------------------
-void IMX501Utils::ExtractTensorData(const fpk_info *inInfo, const tensor_header *inHeader,
-                                           const uint8_t *inChunkBuf, size_t inReceiveBufSize,
-                                           uint8_t *inTensorBuf)
+void IMX501Utils::CompactTensorLines(const uint8_t *inLines, size_t inLineNum,
+                                     size_t inLineWidth, size_t inLineStride,
+                                     uint8_t *outBuf)
 {
-  size_t lineLen = (size_t)inInfo->dnn[0].dd_ch7_x;
-  size_t lineNum = (size_t)inInfo->dnn[0].dd_ch7_y + (size_t)inInfo->dnn[0].dd_ch8_y;
-  size_t dataWidth = inHeader->max_length_of_line;
-
-  // sanity check
-  if (inChunkBuf == NULL || inTensorBuf == NULL ||
-      lineLen * lineNum > inReceiveBufSize ||
-      dataWidth > lineLen)
-  {
-    throw std::runtime_error("ExtractTensorData was called with wrong parameters");
-  }
-
-  for (int i = 0; i < lineNum; i++)
+  for (size_t i = 0; i < inLineNum; i++)
   {
-    memcpy(inTensorBuf, inChunkBuf, dataWidth);
-    inChunkBuf += lineLen;
-    inTensorBuf += dataWidth;
+    memcpy(outBuf, inLines, inLineWidth);
+    inLines += inLineStride;
+    outBuf += inLineWidth;
   }
 }
 
 // -----------------------------------------------------------------------------
-//  ExtractTensors
+//  GetInputImageLayout
 // -----------------------------------------------------------------------------
-void IMX501Utils::ExtractTensors(const fpk_info *inInfo, const tensor_header *inHeader,
-                                        uint8_t *inTensorBuf, size_t inReceiveBufSize,
-                                        uint8_t **outInputTensorPtr, size_t *outInputTensorsSize,
-                                        uint8_t **outOutputTensorPtr, size_t *outOutputTensorsSize)
-{
-  size_t lineLen = (size_t)inInfo->dnn[0].dd_ch7_x;
-  size_t lineNum = (size_t)inInfo->dnn[0].dd_ch7_y + (size_t)inInfo->dnn[0].dd_ch8_y;
-  size_t dataWidth = inHeader->max_length_of_line;
-
-  // sanity check
-  if (inTensorBuf == NULL ||
-      lineLen * lineNum > inReceiveBufSize ||
-      dataWidth > lineLen)
-  {
-    throw std::runtime_error("ExtractTensors was called with wrong parameters");
-  }
-
-  // skip input tensor header
-  *outInputTensorPtr    = &(inTensorBuf[dataWidth * 1]);
-  *outInputTensorsSize   = dataWidth * ((size_t)inInfo->dnn[0].dd_ch7_y - 1);
-
-  // skip output tensor header
-  *outOutputTensorPtr   = &(inTensorBuf[dataWidth * ((size_t)inInfo->dnn[0].dd_ch7_y + 1)]);
-  *outOutputTensorsSize  = dataWidth * ((size_t)inInfo->dnn[0].dd_ch8_y - 1);
-}
-
-// -----------------------------------------------------------------------------
-//  ExtractInputImage
-// -----------------------------------------------------------------------------
-void IMX501Utils::ExtractInputImage(const fpk_info* inInfo,
+IMX501Utils::ChunkStatus IMX501Utils::GetInputImageLayout(const fpk_info* inInfo,
                                     const apParams::fb::FBApParams *inParameter,
-                                    const uint8_t *inInputTensorPtr, size_t inInputTensorSize,
-                                    uint8_t *mInputImageBuf, size_t *outInputImageSize,
-                                    int32_t *outInputImageWidth, int32_t *outInputImageHeight)
+                                    size_t inInputTensorSize,
+                                    input_image_layout *outLayout)
 {
   // sanity check
-  if (inInputTensorPtr == NULL)
-    throw std::runtime_error("ExtractInputImage was called with wrong parameters");
+  if (inParameter == NULL)
+    return ChunkStatus::CHUNK_BAD_INPUT_TENSOR;
 
   // format check
   if (inParameter->networks()->Get(0)->inputTensors()->Get(0)->numOfDimensions() != 3)
-    throw std::runtime_error("Unknown input tensor format");
+    return ChunkStatus::CHUNK_BAD_INPUT_TENSOR;
 
   // Note: we need to get the dimension from serializationIndex
-  size_t width, height, x_padding, y_padding;
+  size_t width = 0, height = 0, x_padding = 0, y_padding = 0;
   for (int i = 0; i < 3; i++)
   {
     int index = inParameter->networks()->Get(0)->inputTensors()->Get(0)->dimensions()->Get(i)->serializationIndex();
@@ -931,6 +1450,8 @@ void IMX501Utils::ExtractInputImage(const fpk_info* inInfo,
       y_padding = (size_t)inParameter->networks()->Get(0)->inputTensors()->Get(0)->dimensions()->Get(i)->padding();
     }
   }
+  if (width == 0 || height == 0)
+    return ChunkStatus::CHUNK_BAD_INPUT_TENSOR;
 
   // input tensor size sanity check
   size_t  inputTensorSize = (width + x_padding) * height * 3 + (width + x_padding) * y_padding * 2;
@@ -938,47 +1459,69 @@ void IMX501Utils::ExtractInputImage(const fpk_info* inInfo,
   {
     printf("\n\nDEBUG: %zd, %zd, %zd, %zd\n", width, height, x_padding, y_padding);
     printf("DEBUG: inputTensorSize:%zd, inInputTensorSize:%zd\n", inputTensorSize, inInputTensorSize);
-    throw std::runtime_error("InputTensor size mismatch");
+    return ChunkStatus::CHUNK_BAD_INPUT_TENSOR;
   }
 
-  *outInputImageSize = width * height * 3;
-  const uint8_t *src = inInputTensorPtr;
-  uint8_t *dst = mInputImageBuf;
-  for (size_t i = 0; i < 3; i++)
+  outLayout->width = width;
+  outLayout->height = height;
+  outLayout->x_padding = x_padding;
+  outLayout->y_padding = y_padding;
+
+  // Signed tensors are stored with an offset of 0x80
+  outLayout->offset = 0x00;
+  if (inInfo->dnn[0].input_tensor_norm_k[0] == 0x0400 &&
+      inInfo->dnn[0].input_tensor_norm_k[1] == 0x0000 &&
+      inInfo->dnn[0].input_tensor_norm_k[2] == 0x1800)
+  //if (inInfo->dnn[0].input_tensor_norm_yadd != 0)
+    outLayout->offset = 0x80;
+  return ChunkStatus::CHUNK_OK;
+}
+
+// -----------------------------------------------------------------------------
+//  ExtractInputImage
+// -----------------------------------------------------------------------------
+void IMX501Utils::ExtractInputImage(const input_image_layout *inLayout,
+                                    const uint8_t *inInputTensorPtr,
+                                    size_t inLineWidth, size_t inLineStride,
+                                    uint8_t *outInputImageBuf,
+                                    bool inAllowSIMD)
+{
+  // inAllowSIMD false takes the scalar loop, for comparing the two
+  static const InterleaveFunc selected = SelectInterleaveFunc();
+  const InterleaveFunc interleave = inAllowSIMD ? selected : InterleavePlanes;
+
+  // The planes are R, G and B, each line followed by x_padding and each
+  // plane by y_padding lines. planeOffset is where a line of a plane starts
+  // in the tensor without the chunk line padding.
+  size_t planeSize = (inLayout->width + inLayout->x_padding) * inLayout->height +
+                     inLayout->width * inLayout->y_padding;
+  size_t lineSize = inLayout->width + inLayout->x_padding;
+  uint8_t *dst = outInputImageBuf;
+  for (size_t y = 0; y < inLayout->height; y++)
   {
-    for (size_t y = 0; y < height; y++)
+    size_t planeOffset[3];
+    for (int i = 0; i < 3; i++)
+      planeOffset[i] = planeSize * i + lineSize * y;
+
+    // A run ends where one of the planes reaches the end of a chunk line
+    size_t x = 0;
+    while (x < inLayout->width)
     {
-      for (size_t x = 0; x < width; x++)
+      const uint8_t *src[3];
+      size_t run = inLayout->width - x;
+      for (int i = 0; i < 3; i++)
       {
-        uint8_t val = *src;
-        if (inInfo->dnn[0].input_tensor_norm_k[0] == 0x0400 &&
-            inInfo->dnn[0].input_tensor_norm_k[1] == 0x0000 &&
-            inInfo->dnn[0].input_tensor_norm_k[2] == 0x1800)
-        //if (inInfo->dnn[0].input_tensor_norm_yadd != 0)
-        {
-          if (val >= 0x80)
-            val = val - 0x80;
-          else
-            val = val + 0x80;
-        }
-        //
-        if (i == 0)
-          dst[x * 3 + 2 + width * 3 * y] = val;
-        if (i == 1)
-          dst[x * 3 + 1 + width * 3 * y] = val;
-        if (i == 2)
-          dst[x * 3 + 0 + width * 3 * y] = val;
-        src++;
+        size_t col = planeOffset[i] % inLineWidth;
+        src[i] = inInputTensorPtr + (planeOffset[i] / inLineWidth) * inLineStride + col;
+        run = std::min(run, inLineWidth - col);
       }
-      if (x_padding != 0)
-        src += x_padding;
+      interleave(src[0], src[1], src[2], run, inLayout->offset, dst);
+      for (int i = 0; i < 3; i++)
+        planeOffset[i] += run;
+      dst += run * 3;
+      x += run;
     }
-    if (y_padding != 0)
-      src += (width * y_padding);
   }
-  
-  *outInputImageWidth  = (int32_t )width;
-  *outInputImageHeight = (int32_t )height;
 }
 
 // -----------------------------------------------------------------------------
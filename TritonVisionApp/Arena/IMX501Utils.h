@@ -123,6 +123,24 @@ public:
     CAMERA_FILE_TYPE_UNKNOWN = 0xFFFF         /*!< 0xFFFF: Unknown Camera File Type*/
   };
 
+  /**
+  * This enum represents the result of parsing a chunk data.
+  */
+  enum class ChunkStatus
+  {
+    CHUNK_OK = 0,                 /*!< 0:The tensors were extracted */
+    CHUNK_NOT_INITIALIZED,        /*!< 1:No network description, InitCameraToOutputDNN() or InitFromRecordedData() was not called */
+    CHUNK_INCOMPLETE,             /*!< 2:The chunk data of the frame is incomplete */
+    CHUNK_MISSING,                /*!< 3:The frame has no ChunkDeepNeuralNetwork chunk */
+    CHUNK_EMPTY,                  /*!< 4:ChunkDeepNeuralNetworkLength is 0 */
+    CHUNK_TOO_LARGE,              /*!< 5:The chunk is larger than the network describes */
+    CHUNK_INPUT_TENSOR_INVALID,   /*!< 6:valid_flag of the input tensor header is 0 */
+    CHUNK_OUTPUT_TENSOR_INVALID,  /*!< 7:valid_flag of the output tensor header is 0 */
+    CHUNK_BAD_LINE_LENGTH,        /*!< 8:max_length_of_line is 0 or longer than a chunk line */
+    CHUNK_BAD_INPUT_TENSOR,       /*!< 9:The input tensor cannot be converted to an image */
+    CHUNK_BAD_AP_PARAMETER        /*!< 10:The AP parameter fails the flatbuffers verification or describes no tensors */
+  };
+
   // Constructors and Destructor -----------------------------------------------
   /**
   * @fn IMX501Utils(Arena::IDevice *inDevice, bool inVerboseMode = false)
@@ -180,12 +198,51 @@ public:
   * up the camera.
   * The function needs to be called once after creating the IMX501Utils
   * object for the initialization.
+  * Calling it again is cheap: the fpk_info and the label text are only
+  * downloaded again when GetNetworkFingerprint() changed, the internal
+  * buffers are kept while their size stays the same and settings that
+  * already have the requested value are not written.
   * Wether to enable the no raw output streaming mode or the sensor
   * ISP manual mode or not can be specified as arguments.
   * These input parameters are also optional.
   */
   void  InitCameraToOutputDNN(bool inEnableNoRawOutput = false, bool inEnableSensorISPManualMode = false);
  
+  /**
+  * @fn void  InitFromRecordedData(const void *inFPKinfo, size_t inFPKinfoSize, const uint8_t *inLabelData, size_t inLabelDataSize, uint64_t inNetworkFingerprint)
+  *
+  * @param inFPKinfo
+  *   - Type: const void*
+  *   - Pointer to the content of fpk_info.dat
+  * @param inFPKinfoSize
+  *   - Type: size_t
+  *   - Size of the content of fpk_info.dat
+  * @param inLabelData
+  *   - Type: const uint8_t*
+  *   - Pointer to the content of label.txt (optional)
+  * @param inLabelDataSize
+  *   - Type: size_t
+  *   - Size of the content of label.txt
+  * @param inNetworkFingerprint
+  *   - Type: uint64_t
+  *   - GetNetworkFingerprint() of the network the data belongs to (optional)
+  *
+  * @return
+  *   - none
+  *
+  * <B> InitFromRecordedData </B> prepares the internal buffers from
+  * a fpk_info.dat and a label text file that were saved beforehand,
+  * instead of downloading them from a camera.
+  * After the call, recorded chunk data can be passed to
+  * SetChunkData(const uint8_t*, size_t) without any camera attached.
+  * With a camera attached and the fingerprint of its current network,
+  * a following InitCameraToOutputDNN() uses this data instead of
+  * downloading it again.
+  */
+  void  InitFromRecordedData(const void *inFPKinfo, size_t inFPKinfoSize,
+                             const uint8_t *inLabelData, size_t inLabelDataSize,
+                             uint64_t inNetworkFingerprint = 0);
+ 
   /**
   * @fn void  SetChunkData(Arena::IChunkData *inChunkData)
   *
@@ -194,15 +251,40 @@ public:
   *   - Pointer to the IChunkData object of ArenaSDK
   *
   * @return
-  *   - none
+  *   - Type: ChunkStatus
+  *   - CHUNK_OK if the tensors were extracted
   *
   * <B> SetChunkData </B> sets a received chunk data from the camera to
   * the IMX501Utils object.
   * The object will extract an Input tensor and Output tensors from
   * the specified chunk data. The extract process in the function includes
   * the denormalization of the input tensor also.
+  * The chunk is copied once into the object, the tensors are views
+  * of that copy. Invalid chunk data is reported by the returned status,
+  * only errors of the GenApi access are thrown.
   */
-  void  SetChunkData(Arena::IChunkData *inChunkData);
+  ChunkStatus  SetChunkData(Arena::IChunkData *inChunkData);
+
+  /**
+  * @fn void  SetChunkData(const uint8_t *inData, size_t inDataSize)
+  *
+  * @param inData
+  *   - Type: const uint8_t*
+  *   - Pointer to the content of the ChunkDeepNeuralNetwork chunk
+  * @param inDataSize
+  *   - Type: size_t
+  *   - Size of the content (same as ChunkDeepNeuralNetworkLength)
+  *
+  * @return
+  *   - Type: ChunkStatus
+  *   - CHUNK_OK if the tensors were extracted
+  *
+  * <B> SetChunkData </B> works like SetChunkData(Arena::IChunkData*),
+  * but takes the bytes of the ChunkDeepNeuralNetwork chunk that were
+  * already read from the camera or loaded from a file.
+  * The function does not throw.
+  */
+  ChunkStatus  SetChunkData(const uint8_t *inData, size_t inDataSize);
 
   /**
   * @fn bool  ProcessChunkData(Arena::IChunkData *inChunkData)
@@ -225,6 +307,51 @@ public:
   */
   bool  ProcessChunkData(Arena::IChunkData *inChunkData);
 
+  /**
+  * @fn bool  ProcessChunkData(const uint8_t *inData, size_t inDataSize)
+  *
+  * @param inData
+  *   - Type: const uint8_t*
+  *   - Pointer to the content of the ChunkDeepNeuralNetwork chunk
+  * @param inDataSize
+  *   - Type: size_t
+  *   - Size of the content
+  *
+  * @return
+  *   - True if the function ends with success
+  *   - Otherwise, false
+  *
+  * <B> ProcessChunkData </B> calls SetChunkData(const uint8_t*, size_t)
+  * and returns whether it succeeded. GetChunkStatus() tells why it did not.
+  */
+  bool  ProcessChunkData(const uint8_t *inData, size_t inDataSize);
+
+  /**
+  * @fn ChunkStatus  GetChunkStatus()
+  *
+  * @return
+  *   - Type: ChunkStatus
+  *   - Result of the last SetChunkData or ProcessChunkData
+  *
+  * <B> GetChunkStatus </B> returns the result of parsing the last chunk data.
+  * An exception thrown by SetChunkData(Arena::IChunkData*) leaves the
+  * status of the previous chunk data.
+  */
+  ChunkStatus  GetChunkStatus();
+
+  /**
+  * @fn const char*  GetChunkStatusStr(ChunkStatus inStatus)
+  *
+  * @param inStatus
+  *   - Type: ChunkStatus
+  *   - Status to describe
+  *
+  * @return
+  *   - Type: const char*
+  *   - Short description of the status
+  */
+  static const char  *GetChunkStatusStr(ChunkStatus inStatus);
+
   // ---------------------------------------------------------------------------
   /**
   * @fn uint8_t*  GetInputImagePtr()
@@ -239,9 +366,31 @@ public:
   * Please note that the pixel format of the returned buffer is BGR
   * to maintain a simplicity on the windows platform, when the image
   * format is RGB.
+  * The image is only extracted by the first call after SetChunkData(),
+  * NULL is returned when there is no valid chunk data.
   */
   const uint8_t *GetInputImagePtr();
 
+  /**
+  * @fn bool  CopyInputImage(uint8_t *outBuf, size_t inBufSize)
+  *
+  * @param outBuf
+  *   - Type: uint8_t*
+  *   - Buffer for the image
+  *
+  * @param inBufSize
+  *   - Type: size_t
+  *   - Size of outBuf, at least GetInputImageSize()
+  *
+  * @return
+  *   - Type: bool
+  *   - false when there is no valid chunk data or outBuf is too small
+  *
+  * <B> CopyInputImage </B> extracts the same image as GetInputImagePtr()
+  * straight into a buffer of the caller.
+  */
+  bool  CopyInputImage(uint8_t *outBuf, size_t inBufSize);
+
   /**
   * @fn size_t  GetInputImageSize()
   *
@@ -371,6 +520,8 @@ public:
   * <B> GetOutputTensorPtr </B> returns the pointer to the beginning of the
   * specified output tensor. Please note that output tensor denormalization
   * is not applied to data pointed by the returned pointer.
+  * The tensor information accessors only read the tensor layout, which is
+  * built once for each network from the AP parameter.
   */
   const void *GetOutputTensorPtr(uint32_t inIndex);
 
@@ -436,6 +587,83 @@ public:
   */
   std::string GetLabelAndScoreStr(size_t inIndex, double inScore);
 
+  /**
+  * @fn const void*  GetFPKinfoPtr()
+  *
+  * @return
+  *   - Type: void*
+  *   - Pointer to the fpk_info retrieved from the camera
+  *
+  * <B> GetFPKinfoPtr </B> returns the pointer to the content of fpk_info.dat.
+  * Saving it together with chunk data allows InitFromRecordedData to parse
+  * the chunk data later.
+  */
+  const void *GetFPKinfoPtr();
+
+  /**
+  * @fn size_t  GetFPKinfoSize()
+  *
+  * @return
+  *   - Type: size_t
+  *   - Size of the fpk_info
+  *
+  * <B> GetFPKinfoSize </B> returns the size of the buffer returned by
+  * GetFPKinfoPtr().
+  */
+  size_t GetFPKinfoSize();
+
+  /**
+  * @fn const uint8_t*  GetLabelDataPtr()
+  *
+  * @return
+  *   - Type: uint8_t*
+  *   - Pointer to the label text file, NULL if the camera has none
+  *
+  * <B> GetLabelDataPtr </B> returns the pointer to the content of
+  * the label text file retrieved from the camera.
+  */
+  const uint8_t *GetLabelDataPtr();
+
+  /**
+  * @fn size_t  GetLabelDataSize()
+  *
+  * @return
+  *   - Type: size_t
+  *   - Size of the label text file
+  *
+  * <B> GetLabelDataSize </B> returns the size of the buffer returned by
+  * GetLabelDataPtr().
+  */
+  size_t GetLabelDataSize();
+
+  /**
+  * @fn uint64_t  GetNetworkFingerprint()
+  *
+  * @return
+  *   - Type: uint64_t
+  *   - Fingerprint of the network files stored in the camera
+  *
+  * <B> GetNetworkFingerprint </B> hashes the sizes of the network,
+  * fpk_info and label files of the camera and the content of fpk_info.
+  * Only the 256 bytes of fpk_info are downloaded, so it is much faster
+  * than downloading the label file and the network.
+  * Without a camera the fingerprint of the loaded data is returned.
+  */
+  uint64_t GetNetworkFingerprint();
+
+  /**
+  * @fn void  DiscardNetworkData()
+  *
+  * @return
+  *   - none
+  *
+  * <B> DiscardNetworkData </B> marks the fpk_info and the label text
+  * as outdated, e.g. when the network id in the chunk data does not
+  * match them. They stay usable until the next InitCameraToOutputDNN(),
+  * which downloads them again whatever the fingerprint.
+  */
+  void DiscardNetworkData();
+
   // ---------------------------------------------------------------------------
   /**
   * @fn const tensor_header*  GetInputTensorHeader()
@@ -471,6 +699,9 @@ public:
   *
   * <B> GetInputTensorsBufPtr </B> returns the pointer to the buffer of
   * the input tensor.
+  * The input tensor is not copied out of the chunk data, so it is
+  * strided: lines of GetTensorLineWidth() bytes that start
+  * GetTensorLineStride() bytes apart.
   */
   const void *GetInputTensorsBufPtr();
 
@@ -482,10 +713,28 @@ public:
   *   - Size of the input tensor buffer
   *
   * <B> GetInputTensorsBufSize </B> returns the size of the buffer, which
-  * stores the input tensor.
+  * stores the input tensor. The line padding is not included.
   */
   size_t  GetInputTensorsBufSize();
 
+  /**
+  * @fn size_t  GetTensorLineWidth()
+  *
+  * @return
+  *   - Type: size_t
+  *   - Bytes of tensor data in a line (max_length_of_line)
+  */
+  size_t  GetTensorLineWidth();
+
+  /**
+  * @fn size_t  GetTensorLineStride()
+  *
+  * @return
+  *   - Type: size_t
+  *   - Bytes from the start of a line to the start of the next (dd_ch7_x)
+  */
+  size_t  GetTensorLineStride();
+
   /**
   * @fn uint32_t GetInputTensorNum()
   *
@@ -572,6 +821,9 @@ public:
   *
   * <B> GetInputTensorsBufPtr </B> returns the pointer to the buffer of
   * the output tensor.
+  * Unlike the input tensor, the output tensors are contiguous: they are a
+  * view of the chunk data when its lines have no padding, otherwise
+  * their few lines are compacted.
   */
   const void *GetOutputTensorsBufPtr();
 
@@ -690,6 +942,45 @@ protected:
     fpk_dnn_info      dnn[1];                         // offset 128 (0)
   } fpk_info;
 
+  // Where the planes of the input image are in the input tensor
+  typedef struct
+  {
+    size_t  width;
+    size_t  height;
+    size_t  x_padding;    // After each line
+    size_t  y_padding;    // Lines after each plane
+    uint8_t offset;       // XORed into every element, 0x80 for signed tensors
+  } input_image_layout;
+
+  typedef struct
+  {
+    input_tensor_info info;
+    size_t  firstDimension;   // Index in tensor_layout::dimensions
+  } input_tensor_layout;
+
+  typedef struct
+  {
+    output_tensor_info info;
+    size_t  offset;           // From the beginning of the output tensors
+    size_t  size;
+    size_t  firstDimension;   // Index in tensor_layout::dimensions
+  } output_tensor_layout;
+
+  // Everything the accessors need from the AP parameter, so that the
+  // flatbuffer is only verified and walked when the network changes
+  typedef struct
+  {
+    bool      valid;
+    uint16_t  networkId;          // Key, from the tensor headers
+    uint16_t  apParameterSize;
+    uint16_t  inputLineLength;
+    uint16_t  outputLineLength;   // max_length_of_line the offsets are aligned to
+    std::vector<input_tensor_layout>   inputTensors;
+    std::vector<output_tensor_layout>  outputTensors;
+    std::vector<dimension_info>  dimensions;
+    input_image_layout  inputImage;
+  } tensor_layout;
+
   // Member variables ----------------------------------------------------------
   bool  mVerboseMode;
   Arena::IDevice  *mDevice;
@@ -705,47 +996,63 @@ protected:
   size_t  mReceiveBufSize;
 
   uint8_t *mChunkBuf;
-  uint8_t *mTensorBuf;
+  uint8_t *mTensorBuf;          // Compacted output tensors, only used when the lines are padded
   uint8_t *mInputImageBuf;
+  size_t  mTensorBufSize;
+  size_t  mInputImageBufSize;
 
-  uint8_t *mInputTensorsPtr;
+  const uint8_t *mInputTensorsPtr;  // View of mChunkBuf
   size_t  mInputTensorsSize;
+  size_t  mTensorLineWidth;
+  size_t  mTensorLineStride;
 
   size_t  mInputImageSize;
   int32_t mInputImageWidth;
   int32_t mInputImageHeight;
   InputImageType mInputImageType;
+  bool  mInputImageExtracted;   // mInputImageBuf holds the image of the current chunk
 
-  uint8_t *mOutputTensorsPtr;
+  const uint8_t *mOutputTensorsPtr;
   size_t  mOutputTensorsSize;
 
   bool  mDataExtracted;
+  ChunkStatus  mChunkStatus;
   const apParams::fb::FBApParams  *mApParams;
+  tensor_layout  mTensorLayout;
+
+  bool  mMetadataLoaded;
+  uint64_t  mNetworkFingerprint;
 
   // Protected static member functions -----------------------------------------
+  // Protected member functions ------------------------------------------------
+  void AllocateBuffers();
+  void FreeBuffers();
+  ChunkStatus ExtractChunkData();
+  ChunkStatus UpdateTensorLayout();
+
   static void RetrieveFPKinfo(GenApi::INodeMap *inNodeMap, fpk_info *outInfo);
   static uint8_t *RetrieveLabelData(GenApi::INodeMap *inNodeMap, size_t *outDataSize);
   static void MakeLabelList(const uint8_t *inLabelData, size_t inDataSize,
                                   std::vector<std::string> *outList);
   static bool ValidateFPKinfo(const fpk_info *inInfo);
   static void DumpFPKinfo(const fpk_info *inInfo);
-  static void GetChunkNeuralNetworkData(Arena::IChunkData *inChunkData,
+  static ChunkStatus GetChunkNeuralNetworkData(Arena::IChunkData *inChunkData,
                               uint8_t *outBuf, size_t  inBufSize,
                               int64_t *outDataSize);
   static void DumpTensorHeader(const tensor_header *inHeader);
   static void DumpAPparameter(const apParams::fb::FBApParams *inParameter);
-  static void ExtractTensorData(const fpk_info *inInfo, const tensor_header *inHeader,
-                                           const uint8_t *inChunkBuf, size_t inReceiveBufSize,
-                                           uint8_t *inTensorBuf);
-  static void ExtractTensors(const fpk_info *inInfo, const tensor_header *inHeader,
-                                        uint8_t *inTensorBuf, size_t inReceiveBufSize,
-                                        uint8_t **outInputTensorPtr, size_t *outInputTensorSize,
-                                        uint8_t **outOutputTensorPtr, size_t *outOutputTensorSize);
-  static void ExtractInputImage(const fpk_info* inInfo,
+  static void CompactTensorLines(const uint8_t *inLines, size_t inLineNum,
+                                 size_t inLineWidth, size_t inLineStride,
+                                 uint8_t *outBuf);
+  static ChunkStatus GetInputImageLayout(const fpk_info* inInfo,
                         const apParams::fb::FBApParams *inParameter,
-                        const uint8_t *inInputTensorPtr, size_t inInputTensorSize,
-                        uint8_t *mInputImageBuf, size_t *outInputImageSize,
-                        int32_t *outInputImageWidth, int32_t *outInputImageHeight);
+                        size_t inInputTensorSize,
+                        input_image_layout *outLayout);
+  static void ExtractInputImage(const input_image_layout *inLayout,
+                        const uint8_t *inInputTensorPtr,
+                        size_t inLineWidth, size_t inLineStride,
+                        uint8_t *outInputImageBuf,
+                        bool inAllowSIMD = true);
   static void ReadFile(GenApi::INodeMap *inNodeMap,
                               const char *inFileName,
                               void *inFileBuf, size_t inFileSize,
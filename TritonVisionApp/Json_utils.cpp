@@ -16,6 +16,8 @@ void from_json(const json& j, ROI& p) {
     p.offset_y = j.at("Offset_y").get<int>();
     p.width = j.at("Width").get<int>();
     p.height = j.at("Height").get<int>();
+    p.dwell_frames = j.value("DwellFrames", 1);
+    p.priority = j.value("Priority", 1);
 }
 
 void to_json(ordered_json& j, const ROI& p) {
@@ -24,7 +26,9 @@ void to_json(ordered_json& j, const ROI& p) {
         { "Offset_x", p.offset_x},
         { "Offset_y", p.offset_y},
         { "Width", p.width},
-        { "Height", p.height}
+        { "Height", p.height},
+        { "DwellFrames", p.dwell_frames},
+        { "Priority", p.priority}
     };
 }
 
@@ -46,13 +50,45 @@ void from_json(const json& j, Data& p) {
     p.detection_threshold = j.at("DetectionThreshold").get<float>();
     p.num_of_pattern = j.at("NumOfPattern").get<int>();
     p.pattern_list = j.at("PatternList").get<std::vector<ConnectorPattern>>();
+    p.device_serials = j.value("DeviceSerials", std::vector<std::string>());
+    p.acquisition_policy = j.value("AcquisitionPolicy", std::string("NewestOnly"));
+    p.stream_buffer_count = j.value("StreamBufferCount", 0);
+    p.max_lag_ms = j.value("MaxLagMs", 100);
+    p.pixel_format = j.value("PixelFormat", std::string("Default"));
+    p.tensor_offset = j.value("TensorOffset", -1);
+    p.raw_history_depth = j.value("RawHistoryDepth", 4);
+    p.roi_tracking = j.value("RoiTracking", false);
+    p.roi_tracking_margin = j.value("RoiTrackingMargin", 200);
+    p.raw_on_demand = j.value("RawOnDemand", false);
+    p.frame_budget_ms = j.value("FrameBudgetMs", 0.0);
+    p.exposure_control = j.value("ExposureControl", false);
+    p.min_exposure_us = j.value("MinExposureUs", 100.0);
+    p.max_exposure_us = j.value("MaxExposureUs", 20000.0);
+    p.max_gain_db = j.value("MaxGainDb", 12.0);
+    p.replay_path = j.value("ReplayPath", std::string());
 }
 
 void to_json(ordered_json& j, const Data& p) {
     j = ordered_json{
         { "DetectionThreshold", p.detection_threshold},
         { "NumOfPattern", p.num_of_pattern},
-        { "PatternList", p.pattern_list}
+        { "PatternList", p.pattern_list},
+        { "DeviceSerials", p.device_serials},
+        { "AcquisitionPolicy", p.acquisition_policy},
+        { "StreamBufferCount", p.stream_buffer_count},
+        { "MaxLagMs", p.max_lag_ms},
+        { "PixelFormat", p.pixel_format},
+        { "TensorOffset", p.tensor_offset},
+        { "RawHistoryDepth", p.raw_history_depth},
+        { "RoiTracking", p.roi_tracking},
+        { "RoiTrackingMargin", p.roi_tracking_margin},
+        { "RawOnDemand", p.raw_on_demand},
+        { "FrameBudgetMs", p.frame_budget_ms},
+        { "ExposureControl", p.exposure_control},
+        { "MinExposureUs", p.min_exposure_us},
+        { "MaxExposureUs", p.max_exposure_us},
+        { "MaxGainDb", p.max_gain_db},
+        { "ReplayPath", p.replay_path}
     };
 }
 
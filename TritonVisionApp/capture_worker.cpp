@@ -0,0 +1,87 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file capture_worker.cpp
+* @brief Capture/processing thread that publishes finished frames to the UI
+* @date 2026/10
+*/
+
+#include "./capture_worker.h"
+
+#include <chrono>
+
+CaptureWorker::CaptureWorker(Producer producer) : producer_(std::move(producer)) {
+}
+
+CaptureWorker::~CaptureWorker() {
+    Stop();
+}
+
+void CaptureWorker::Start() {
+    if (running_.exchange(true))
+        return;
+    thread_ = std::thread(&CaptureWorker::Run_, this);
+}
+
+void CaptureWorker::Stop() {
+    running_ = false;
+    if (thread_.joinable())
+        thread_.join();
+}
+
+bool CaptureWorker::IsRunning() const {
+    return running_;
+}
+
+bool CaptureWorker::GetLatestFrame(FrameResult& frame) {
+    return ring_.ReadLatest(frame);
+}
+
+uint64_t CaptureWorker::GetProducedCount() const {
+    return produced_;
+}
+
+uint64_t CaptureWorker::GetDroppedCount() const {
+    return dropped_;
+}
+
+void CaptureWorker::Run_() {
+    while (running_) {
+        // Frames go to scratch_ while the UI has not drained the ring. The newest
+        // one then takes the place of the oldest, so the UI never falls behind.
+        FrameResult* slot = ring_.BeginWrite();
+        bool is_full = (slot == nullptr);
+        if (is_full)
+            slot = &scratch_;
+
+        slot->has_image_12m = false;
+        slot->has_inference = false;
+        slot->has_overlay = false;
+        slot->has_input_tensor = false;
+        slot->has_detail = false;
+        slot->num_detections = 0;
+        slot->latency_ms = 0.0;
+        slot->dnn_frame_count = -1;
+        slot->barcodes.clear();
+
+        if (!producer_(*slot)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        slot->sequence = ++produced_;
+        if (is_full) {
+            if (ring_.DropOldest())
+                dropped_++;
+            FrameResult* free_slot = ring_.BeginWrite();
+            if (free_slot == nullptr) {
+                // The UI is still in the only slot that was freed, the new frame is dropped
+                dropped_++;
+                continue;
+            }
+            // The old slot buffers are recycled through scratch_
+            std::swap(*free_slot, scratch_);
+        }
+        ring_.EndWrite();
+    }
+}
@@ -0,0 +1,97 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/**
+* @file capture_worker.h
+* @brief Capture/processing thread that publishes finished frames to the UI
+* @date 2026/10
+*/
+
+#ifndef CAPTURE_WORKER_H_
+#define CAPTURE_WORKER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "./frame_ring.h"
+
+// Everything the UI needs from one processed frame.
+struct FrameResult {
+    uint64_t sequence = 0;          // Counter assigned by CaptureWorker
+    uint64_t stream_generation = 0; // Incremented on each StartStream()
+    int op_mode = 0;
+    int roi_id = 0;
+    uint64_t roi_ticket = 0;        // Ticket of the last staged ROI in effect for this frame
+    uint64_t dnn_roi_ticket = 0;    // Same for the frame the output tensor was inferred on, 0 when it is not known
+    uint64_t frame_id = 0;
+    uint64_t device_timestamp_ns = 0;
+    uint64_t capture_timestamp_ns = 0; // Exposure on the host steady clock, 0 when unknown
+    double latency_ms = 0.0;           // Exposure to the end of processing, 0 when unknown
+    int dnn_frame_count = -1;          // frame_count of the input tensor, -1 without tensors
+
+    bool has_image_12m = false;     // image_12m holds a new full frame
+    bool has_inference = false;     // num_detections/barcodes are new
+    bool has_overlay = false;       // raw_cropped is new, may be deferred by the processing governor
+    bool has_input_tensor = false;  // input_tensor/detections are new, may be deferred as well
+    bool has_detail = false;        // detail_image holds a new full-resolution region
+    int num_detections = 0;         // Barcode detections above the threshold
+    int preview_decimation = 1;     // Sensor pixels per pixel of image_12m and raw_cropped
+
+    cv::Mat image_12m;
+    cv::Mat raw_cropped;
+    cv::Mat input_tensor;
+    cv::Mat detections;
+    cv::Rect detail_region;         // Region of the frame in detail_image, in sensor pixels
+    cv::Mat detail_image;
+    std::vector<std::string> barcodes;
+};
+
+// Capture-to-result latency of one device
+struct LatencyStats {
+    double last_ms = 0.0;
+    double mean_ms = 0.0;
+    double max_ms = 0.0;   // Since the stream started
+    uint64_t frames = 0;
+    uint64_t skipped = 0;  // Frames the camera produced that were never processed
+    double hold_ms = 0.0;  // Mean time a camera buffer is held before it is requeued
+};
+
+const size_t kFrameRingSize = 4;
+
+class CaptureWorker {
+public:
+    // Fills the given frame and returns true, or returns false when no frame was produced.
+    using Producer = std::function<bool(FrameResult&)>;
+
+    explicit CaptureWorker(Producer producer);
+    ~CaptureWorker();
+
+    void Start();
+    void Stop();
+    bool IsRunning() const;
+
+    // Called from the UI thread. Swaps the newest published frame into frame.
+    bool GetLatestFrame(FrameResult& frame);
+
+    uint64_t GetProducedCount() const;
+    // Frames dropped from a full ring before the UI read them
+    uint64_t GetDroppedCount() const;
+
+private:
+    void Run_();
+
+    Producer producer_;
+    FrameRing<FrameResult, kFrameRingSize> ring_;
+    FrameResult scratch_; // Filled while the ring is full, then takes the place of the oldest frame
+    std::thread thread_;
+    std::atomic<bool> running_{ false };
+    std::atomic<uint64_t> produced_{ 0 };
+    std::atomic<uint64_t> dropped_{ 0 };
+};
+
+#endif
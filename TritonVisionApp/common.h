@@ -27,6 +27,7 @@ const int kResizedHeight480 = 480;
 const int kInputtensorWidth = 256;
 const int kInputtensorHeight = 256;
 const int kNumOfRoi = 1;
+const int kNumOfAggregatedResults = 64; // Results of all cameras scanned for the UI
 
 // Status
 static const char* kStreamStatus[] = {
@@ -36,6 +37,31 @@ static const char* kStreamStatus[] = {
                 "Stopped"
 };
 
+static const char* kStartupStage[] = {
+                "Waiting",
+                "Connecting",
+                "Loading network",
+                "Configuring ROI",
+                "Ready",
+                "Failed"
+};
+
+static const char* kAcquisitionPolicy[] = {
+                "Oldest First",
+                "Newest Only",
+                "Bounded Lag"
+};
+const int kNumOfAcquisitionPolicy = 3;
+
+// "Default" keeps the format set in the camera, BayerRG8 and Mono8 keep the pipeline on one channel
+static const char* kPixelFormat[] = {
+                "Default",
+                "BGR8",
+                "BayerRG8",
+                "Mono8"
+};
+const int kNumOfPixelFormat = 4;
+
 // [Style] Window title
 static const char* kWindowTitle = "Barcode Detector for Triton Smart";
 
@@ -81,6 +107,8 @@ static const char* kConfigFile = "roi.json";
 
 // Export normal image path
 static const char* kDataImagePath = ".\\export-barcode\\";
+static const char* kRecordingPath = ".\\recordings\\";
+static const char* kNetworkCachePath = ".\\cache\\";
 
 struct  ROI {
     int id;
@@ -88,6 +116,8 @@ struct  ROI {
     int offset_y;
     int width;
     int height;
+    int dwell_frames = 1; // Frames the ROI scheduler stays on this ROI
+    int priority = 1;     // Relative visit frequency in the ROI scheduler
 };
 
 struct ConnectorPattern {
@@ -100,6 +130,22 @@ struct Data {
     float detection_threshold = 0.6f;
     int num_of_pattern = 1;
     std::vector<ConnectorPattern> pattern_list;
+    std::vector<std::string> device_serials; // Cameras to open, empty opens every camera
+    std::string acquisition_policy = "NewestOnly"; // OldestFirst, NewestOnly or BoundedLag
+    int stream_buffer_count = 0; // 0 keeps the driver default
+    int max_lag_ms = 100; // Oldest frame age processed with BoundedLag
+    std::string pixel_format = "Default"; // One of kPixelFormat
+    int tensor_offset = -1; // Frames the DNN output lags the RAW image, -1 follows the tensor frame counters
+    int raw_history_depth = 4; // Earlier RAW frames kept to pair late DNN outputs with
+    bool roi_tracking = false; // Shrink the RAW image to the recent detections
+    int roi_tracking_margin = 200; // Sensor pixels kept around the detections
+    bool raw_on_demand = false; // Stream only the DNN chunk until a detection fetches its RAW region
+    double frame_budget_ms = 0.0; // Processing time per frame, 0 processes everything
+    bool exposure_control = false; // Tune exposure time and gain from the barcode regions
+    double min_exposure_us = 100.0;
+    double max_exposure_us = 20000.0;
+    double max_gain_db = 12.0;
+    std::string replay_path; // Replay manifest or recording directory to use instead of the cameras, empty uses the cameras
 };
 
 #endif
\ No newline at end of file
@@ -9,55 +9,157 @@
 
 #include "./device_handler.h"
 
-inline int ceil_roi(int x) {
-    return x - (x % 4);
+#include <chrono>
+#include <thread>
+
+ArenaDeviceHandler::ArenaDeviceHandler(Arena::ISystem* pSystem, Arena::IDevice* pDevice, const std::string& serial, ResultAggregator* aggregator, const std::function<void(StartupStage)>& on_stage)
+    : pSystem_(pSystem),
+      pDevice_(pDevice),
+      serial_(serial),
+      aggregator_(aggregator),
+      frame_context_(image_pool_),
+      paired_context_(image_pool_),
+      capture_worker_([this](FrameResult& frame) { return Process(frame); }) {
+    util_.SetValue(pDevice_, false);
+
+    if (on_stage)
+        on_stage(StartupStage::LoadingNetwork);
+    InitNetwork_();
+    if (on_stage)
+        on_stage(StartupStage::ConfiguringRoi);
+    pNodeMap = pDevice_->GetNodeMap();
+    frame_source_.reset(new ArenaFrameSource(pDevice_));
+    node_access_.reset(new GenApiNodeAccess(pNodeMap));
+    roi_switcher_.reset(new RoiSwitcher(*node_access_, kDnnRoiNodes_, kRawRoiNodes_));
+
+    ROI full_roi = { 0, kInitRoiOffestX_, kInitRoiOffsetY_, kInitRoiWidth_, kInitRoiHeight_ };
+    RoiSwitcher::WriteRoi(*node_access_, roi_switcher_->GetRawNodes(), full_roi);
+    RoiSwitcher::WriteRoi(*node_access_, roi_switcher_->GetDnnNodes(), full_roi);
+    raw_roi_ = full_roi;
+    current_roi_ = full_roi;
+
 }
 
-ArenaDeviceHandler::ArenaDeviceHandler() {
-    pSystem_ = Arena::OpenSystem();
-    pSystem_->UpdateDevices(100);
-    std::vector<Arena::DeviceInfo> deviceInfos = pSystem_->GetDevices();
-    if (deviceInfos.size() == 0)
-        throw std::runtime_error("deviceInfos.size() == 0");
-    pDevice_ = pSystem_->CreateDevice(deviceInfos[0]);
-    util_.SetValue(pDevice_, false);
+// Runs the same pipeline on a recording. ROI changes are accepted and reported as usual,
+// but the recorded frames keep the ROI they were captured with.
+ArenaDeviceHandler::ArenaDeviceHandler(const std::string& replay_path, ResultAggregator* aggregator)
+    : pSystem_(nullptr),
+      pDevice_(nullptr),
+      serial_("Replay"),
+      aggregator_(aggregator),
+      pNodeMap(nullptr),
+      frame_context_(image_pool_),
+      paired_context_(image_pool_),
+      capture_worker_([this](FrameResult& frame) { return Process(frame); }) {
+    ReplayFrameSource* replay = new ReplayFrameSource(replay_path);
+    frame_source_.reset(replay);
+    util_.SetValue(nullptr, false);
+    util_.InitFromRecordedData(replay->GetFpkInfo().data(), replay->GetFpkInfo().size(), replay->GetLabels().data(), replay->GetLabels().size());
+    node_access_.reset(new MemoryNodeAccess());
+    roi_switcher_.reset(new RoiSwitcher(*node_access_, kDnnRoiNodes_, kRawRoiNodes_));
+    raw_roi_ = { 0, kInitRoiOffestX_, kInitRoiOffsetY_, kInitRoiWidth_, kInitRoiHeight_ };
+    current_roi_ = raw_roi_;
+}
+
+// The network description is taken from the disk cache while the camera still has the
+// network it was cached for, otherwise it is read from the camera and cached
+void ArenaDeviceHandler::InitNetwork_() {
+    NetworkMetadataCache cache(kNetworkCachePath);
+    uint64_t fingerprint = util_.GetNetworkFingerprint();
+    std::vector<uint8_t> fpk_info;
+    std::vector<uint8_t> labels;
+    bool is_cached = cache.Load(serial_, fingerprint, fpk_info, labels);
+    network_fingerprint_ = fingerprint;
+    network_id_ = is_cached ? cache.LoadNetworkId(serial_, fingerprint) : -1;
+    if (is_cached) {
+        try {
+            util_.InitFromRecordedData(fpk_info.data(), fpk_info.size(), labels.data(), labels.size(), fingerprint);
+        }
+        catch (std::exception& ex) {
+            printf("Ignoring the cached network description of %s: %s\n", serial_.c_str(), ex.what());
+            is_cached = false;
+        }
+    }
 
     util_.InitCameraToOutputDNN(); // To get 30fps, we need to set inEnableNoRawOutput to true
-    pNodeMap = pDevice_->GetNodeMap();
 
-    SetNodeParam_(kNodeNameRAWRoiOffsetX_, 0);
-    SetNodeParam_(kNodeNameRAWRoiOffsetY_, 0);
-    SetNodeParam_(kNodeNameRAWRoiWidth_, kInitRoiWidth_);
-    SetNodeParam_(kNodeNameRAWRoiHeight_, kInitRoiHeight_);
-    SetNodeParam_(kNodeNameRAWRoiOffsetX_, kInitRoiOffestX_);
-    SetNodeParam_(kNodeNameRAWRoiOffsetY_, kInitRoiOffsetY_);
+    if (!is_cached && !cache.Store(serial_, fingerprint, util_.GetFPKinfoPtr(), util_.GetFPKinfoSize(), util_.GetLabelDataPtr(), util_.GetLabelDataSize()))
+        printf("Couldn't cache the network description of %s\n", serial_.c_str());
+}
 
-    SetNodeParam_(kNodeNameRoiOffsetX_, 0);
-    SetNodeParam_(kNodeNameRoiOffsetY_, 0);
-    SetNodeParam_(kNodeNameRoiWidth_, kInitRoiWidth_);
-    SetNodeParam_(kNodeNameRoiHeight_, kInitRoiHeight_);
-    SetNodeParam_(kNodeNameRoiOffsetX_, kInitRoiOffestX_);
-    SetNodeParam_(kNodeNameRoiOffsetY_, kInitRoiOffsetY_);
+// The first chunk tells which network the description belongs to. Returns false when it
+// is not the network the description was cached with: the entry is removed and the
+// description read from the camera again before the next frame.
+bool ArenaDeviceHandler::CheckNetworkId_(const int network_id) {
+    NetworkMetadataCache cache(kNetworkCachePath);
+    if (network_id_ < 0) {
+        network_id_ = network_id;
+        cache.StoreNetworkId(serial_, network_fingerprint_, network_id);
+        return true;
+    }
+    printf("The network of %s changed from id %d to %d, reading its description again\n", serial_.c_str(), network_id_, network_id);
+    cache.Remove(serial_, network_fingerprint_);
+    util_.DiscardNetworkData();
+    reload_network_ = true;
+    return false;
+}
 
+// Called with device_mutex_ held, between two frames
+void ArenaDeviceHandler::ReloadNetwork_() {
+    reload_network_ = false;
+    frame_source_->StopStream();
+    try {
+        InitNetwork_();
+    }
+    catch (std::exception& ex) {
+        printf("Couldn't read the network description of %s: %s\n", serial_.c_str(), ex.what());
+    }
+    frame_source_->StartStream();
 }
+
 ArenaDeviceHandler::~ArenaDeviceHandler() {
-    pSystem_->DestroyDevice(pDevice_);
-    Arena::CloseSystem(pSystem_);
+    StopCapture();
+    StopStream();
+    frame_source_.reset();
+    if (pDevice_ != nullptr)
+        pSystem_->DestroyDevice(pDevice_);
+}
+
+const std::string& ArenaDeviceHandler::GetSerial() const {
+    return serial_;
 }
 int ArenaDeviceHandler::GetOperationMode() {
     return op_mode_;
 }
 void ArenaDeviceHandler::StartStream(const int op_mode) {
+    std::lock_guard<std::recursive_mutex> lock(device_mutex_);
     if (is_stream_ != true) {
         op_mode_ = op_mode;
-        util_.InitCameraToOutputDNN();
-        pDevice_->StartStream();
+        stream_roi_id_ = pointer_roi_;
+        stream_start_time_ = std::chrono::steady_clock::now();
+        first_frame_ms_ = -1.0;
+        sequence_tracker_.Reset();
+        frame_pairer_.Reset();
+        roi_tracker_.Reset(current_roi_, raw_roi_);
+        tracking_ticket_ = 0;
+        sequence_events_ = 0;
+        // Only re-checks the network, its description stays cached in util_
+        if (pDevice_ != nullptr)
+            util_.InitCameraToOutputDNN();
+        ApplyStagedRoi_(false);
+        frame_source_->StartStream();
+        {
+            std::lock_guard<std::mutex> lock(latency_mutex_);
+            latency_stats_.max_ms = 0.0;
+        }
+        stream_generation_++;
         is_stream_ = true;
     }
 }
 void ArenaDeviceHandler::StopStream() {
+    std::lock_guard<std::recursive_mutex> lock(device_mutex_);
     if (is_stream_ != false) {
-        pDevice_->StopStream();
+        frame_source_->StopStream();
         is_stream_ = false;
     }
 }
@@ -65,59 +167,348 @@ bool ArenaDeviceHandler::GetStreamStatus() {
     return is_stream_;
 }
 
-void ArenaDeviceHandler::SetNodeParam_(const GENICAM_NAMESPACE::gcstring& node_name, const int node_value) {
-    pNode = pNodeMap->GetNode(node_name);
-    if (pNode == NULL)
-        throw std::runtime_error("Couldn't find the node");
-    pNode->SetValue(node_value);
+void ArenaDeviceHandler::StartCapture() {
+    capture_worker_.Start();
 }
 
-void ArenaDeviceHandler::SetDnnRoi(const ROI& roi) {
+void ArenaDeviceHandler::StopCapture() {
+    capture_worker_.Stop();
+}
+
+bool ArenaDeviceHandler::GetLatestFrame(FrameResult& frame) {
+    return capture_worker_.GetLatestFrame(frame);
+}
+
+// Blocks until a frame of the current stream arrives. Frames captured before the
+// last StartStream() are skipped.
+bool ArenaDeviceHandler::WaitForFrame(FrameResult& frame, const int timeout_ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (GetLatestFrame(frame) && frame.stream_generation == stream_generation_)
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+uint64_t ArenaDeviceHandler::GetStreamGeneration() const {
+    return stream_generation_;
+}
+
+uint64_t ArenaDeviceHandler::GetDroppedFrameCount() const {
+    return capture_worker_.GetDroppedCount();
+}
+
+ImagePool& ArenaDeviceHandler::GetImagePool() {
+    return image_pool_;
+}
+
+// Frames are published at the smallest decimation that still covers width pixels
+void ArenaDeviceHandler::SetPreviewWidth(const int width) {
+    preview_width_ = width;
+}
+
+// Region that is published at full resolution in op_mode 0/2. An empty ROI disables it.
+void ArenaDeviceHandler::SetDetailRegion(const ROI& roi) {
+    std::lock_guard<std::mutex> lock(detail_mutex_);
+    detail_region_ = cv::Rect(roi.offset_x, roi.offset_y, roi.width, roi.height);
+}
+
+// Stages an ROI change that the capture thread applies between two frames, so the
+// stream keeps running. Returns the ticket to pass to WaitForRoi(), or 0 if the ROI is invalid.
+uint64_t ArenaDeviceHandler::StageRoi(const RoiRequest& request) {
+    if (request.has_dnn && ((request.dnn_roi.offset_x + request.dnn_roi.width > kSensorWidth) || (request.dnn_roi.offset_y + request.dnn_roi.height > kSensorHeight)))
+        return 0;
+    if (request.has_raw && ((request.raw_roi.offset_x + request.raw_roi.width > kSensorWidth) || (request.raw_roi.offset_y + request.raw_roi.height > kSensorHeight)))
+        return 0;
+    return roi_switcher_->Stage(request);
+}
+
+// Blocks until a frame captured with the staged ROI of the given ticket (or a later one) arrives
+bool ArenaDeviceHandler::WaitForRoi(FrameResult& frame, const uint64_t ticket, const int timeout_ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (GetLatestFrame(frame) && frame.roi_ticket >= ticket)
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+RoiSwitchRecord ArenaDeviceHandler::GetLastRoiSwitch() {
+    return roi_switcher_->GetLastRecord();
+}
+
+RoiSwitchStats ArenaDeviceHandler::GetRoiSwitchStats() {
+    return roi_switcher_->GetStats();
+}
+
+// Cycles the DNN and RAW ROIs over rois while streaming inference
+void ArenaDeviceHandler::StartSchedule(const std::vector<ROI>& rois) {
+    std::lock_guard<std::recursive_mutex> lock(device_mutex_);
+    roi_scheduler_.SetSchedule(rois);
+    if (rois.empty())
+        return;
+    if (op_mode_ != 1)
+        StopStream();
+    StartStream(1);
+    StageNextScheduledRoi_();
+}
+
+void ArenaDeviceHandler::StopSchedule() {
+    roi_scheduler_.Clear();
+}
+
+RoiScheduler& ArenaDeviceHandler::GetScheduler() {
+    return roi_scheduler_;
+}
+
+// Records every complete frame of the stream, see FrameRecorder for the format
+bool ArenaDeviceHandler::StartRecording(const std::string& directory) {
+    return recorder_.Start(directory, util_.GetFPKinfoPtr(), util_.GetFPKinfoSize(), util_.GetLabelDataPtr(), util_.GetLabelDataSize());
+}
+
+void ArenaDeviceHandler::StopRecording() {
+    recorder_.Stop();
+}
+
+FrameRecorder& ArenaDeviceHandler::GetRecorder() {
+    return recorder_;
+}
+
+// A running stream is restarted so that the buffer count takes effect
+void ArenaDeviceHandler::SetAcquisitionSettings(const AcquisitionSettings& settings) {
+    std::lock_guard<std::recursive_mutex> lock(device_mutex_);
+    frame_source_->SetAcquisitionSettings(settings);
+    if (is_stream_) {
+        frame_source_->StopStream();
+        // Frame ids start over and queued outputs are dropped with the stream, as in StartStream()
+        sequence_tracker_.Reset();
+        frame_pairer_.Reset();
+        // A format the camera does not have only shows up here, the stream goes on with the previous settings
+        if (!TryStartStream_("apply the acquisition settings to")) {
+            frame_source_->SetAcquisitionSettings(acquisition_settings_);
+            if (!TryStartStream_("restart the stream of"))
+                is_stream_ = false;
+            return;
+        }
+    }
+    acquisition_settings_ = settings;
+}
+
+bool ArenaDeviceHandler::TryStartStream_(const char* action) {
+    try {
+        frame_source_->StartStream();
+        return true;
+    }
+    catch (GenICam::GenericException& ge) {
+        printf("Couldn't %s %s: %s\n", action, serial_.c_str(), ge.what());
+    }
+    catch (std::exception& ex) {
+        printf("Couldn't %s %s: %s\n", action, serial_.c_str(), ex.what());
+    }
+    return false;
+}
+
+AcquisitionSettings ArenaDeviceHandler::GetAcquisitionSettings() {
+    std::lock_guard<std::recursive_mutex> lock(device_mutex_);
+    return acquisition_settings_;
+}
+
+LatencyStats ArenaDeviceHandler::GetLatencyStats() {
+    std::lock_guard<std::mutex> lock(latency_mutex_);
+    latency_stats_.skipped = frame_source_->GetSkippedCount();
+    return latency_stats_;
+}
+
+double ArenaDeviceHandler::GetTimeToFirstFrameMs() const {
+    return first_frame_ms_;
+}
+
+// Snapshot taken by the capture thread, so the UI never touches the node map while it streams
+StreamStatistics ArenaDeviceHandler::GetStreamStatistics() {
+    std::lock_guard<std::mutex> lock(latency_mutex_);
+    return stream_statistics_;
+}
+
+SequenceStats ArenaDeviceHandler::GetSequenceStats() {
+    return sequence_tracker_.GetStats();
+}
+
+void ArenaDeviceHandler::SetPairingSettings(const PairingSettings& settings) {
+    frame_pairer_.SetSettings(settings);
+}
+
+PairingSettings ArenaDeviceHandler::GetPairingSettings() {
+    return frame_pairer_.GetSettings();
+}
+
+PairingStats ArenaDeviceHandler::GetPairingStats() {
+    return frame_pairer_.GetStats();
+}
+
+void ArenaDeviceHandler::SetGovernorSettings(const GovernorSettings& settings) {
+    governor_.SetSettings(settings);
+}
+
+GovernorSettings ArenaDeviceHandler::GetGovernorSettings() {
+    return governor_.GetSettings();
+}
+
+GovernorStats ArenaDeviceHandler::GetGovernorStats() {
+    return governor_.GetStats();
+}
+
+// Turning the controller on takes exposure and gain over from the camera. The values
+// last written stay in effect when it is turned off.
+void ArenaDeviceHandler::SetExposureSettings(const ExposureSettings& settings) {
+    std::lock_guard<std::recursive_mutex> lock(device_mutex_);
+    exposure_controller_.SetSettings(settings);
+    if (!settings.enabled)
+        return;
+    try {
+        if (!exposure_controller_.Attach(*node_access_))
+            printf("Couldn't turn the automatic exposure of %s off\n", serial_.c_str());
+    }
+    catch (GenICam::GenericException& ge) {
+        printf("Couldn't take over the exposure of %s: %s\n", serial_.c_str(), ge.what());
+    }
+    catch (std::exception& ex) {
+        printf("Couldn't take over the exposure of %s: %s\n", serial_.c_str(), ex.what());
+    }
+}
+
+ExposureSettings ArenaDeviceHandler::GetExposureSettings() {
+    return exposure_controller_.GetSettings();
+}
+
+ExposureStats ArenaDeviceHandler::GetExposureStats() {
+    return exposure_controller_.GetStats();
+}
+
+// Turning tracking off opens the RAW image to the DNN ROI again
+void ArenaDeviceHandler::SetRoiTracking(const RoiTrackingSettings& settings) {
+    bool was_enabled = roi_tracker_.IsEnabled();
+    roi_tracker_.SetSettings(settings);
+    if (was_enabled && !roi_tracker_.IsEnabled()) {
+        RoiRequest request;
+        request.roi_id = pointer_roi_;
+        request.has_raw = true;
+        request.raw_roi = GetDnnRoi();
+        StageRoi(request);
+    }
+}
+
+RoiTrackingSettings ArenaDeviceHandler::GetRoiTracking() {
+    return roi_tracker_.GetSettings();
+}
+
+RoiTrackingStats ArenaDeviceHandler::GetRoiTrackingStats() {
+    return roi_tracker_.GetStats();
+}
+
+ROI ArenaDeviceHandler::GetRawRoi() {
+    std::lock_guard<std::recursive_mutex> lock(device_mutex_);
+    return raw_roi_;
+}
+
+// Capture thread. Follows the barcodes of this frame with the RAW window, one window at a
+// time: the next is only staged once the previous one is in effect.
+void ArenaDeviceHandler::TrackRawRoi_() {
+    if (!roi_tracker_.IsEnabled() || roi_scheduler_.IsActive())
+        return;
+    ROI window;
+    if (roi_tracker_.OnFrame(tracked_rects_, roi_ticket_ >= tracking_ticket_, window)) {
+        RoiRequest request;
+        request.roi_id = stream_roi_id_;
+        request.has_raw = true;
+        request.raw_roi = window;
+        tracking_ticket_ = StageRoi(request);
+    }
+}
 
+// Compares the frame id with the frame_count of both tensors. Events are logged at most
+// once per kSequenceLogInterval_ so that a stalled IMX500 does not flood the console.
+void ArenaDeviceHandler::CheckSequence_(const RawFrame& raw, const bool has_chunk, FrameResult& frame) {
+    const ArenaExample::IMX501Utils::tensor_header* input_header = has_chunk ? util_.GetInputTensorHeader() : nullptr;
+    const ArenaExample::IMX501Utils::tensor_header* output_header = has_chunk ? util_.GetOutputTensorHeader() : nullptr;
+    bool has_tensors = (input_header != nullptr && output_header != nullptr && input_header->valid_flag != 0 && output_header->valid_flag != 0);
+    if (has_tensors)
+        frame.dnn_frame_count = input_header->frame_count;
+
+    sequence_events_ |= sequence_tracker_.OnFrame(raw.frame_id, raw.source_skips, has_tensors,
+        has_tensors ? input_header->frame_count : 0, has_tensors ? output_header->frame_count : 0);
+    auto now = std::chrono::steady_clock::now();
+    if (sequence_events_ == FrameSequenceTracker::kNone || now - last_sequence_log_ < kSequenceLogInterval_)
+        return;
+
+    SequenceStats stats = sequence_tracker_.GetStats();
+    printf("Frame sequence of %s at frame %llu: camera gaps %llu (skipped by policy %llu), DNN gaps %llu, duplicates %llu, lagging %llu, input/output mismatches %llu, standby %llu\n",
+        serial_.c_str(), (unsigned long long)raw.frame_id, (unsigned long long)stats.camera_gaps, (unsigned long long)stats.source_skips, (unsigned long long)stats.dnn_gaps,
+        (unsigned long long)stats.dnn_duplicates, (unsigned long long)stats.dnn_lagging, (unsigned long long)stats.mismatches, (unsigned long long)stats.standby);
+    sequence_events_ = FrameSequenceTracker::kNone;
+    last_sequence_log_ = now;
+}
+
+void ArenaDeviceHandler::StageNextScheduledRoi_() {
+    RoiRequest request;
+    request.roi_id = roi_scheduler_.PickNext(request.dnn_roi);
+    if (request.roi_id < 0)
+        return;
+    // The RAW image follows the DNN ROI so that detections map onto it for decoding
+    request.has_dnn = true;
+    request.has_raw = true;
+    request.raw_roi = request.dnn_roi;
+    roi_scheduler_.OnStaged(request.roi_id, StageRoi(request));
+}
+
+// Called with device_mutex_ held, between two frames
+void ArenaDeviceHandler::ApplyStagedRoi_(const bool is_streaming) {
+    roi_switcher_->ApplyPending(is_streaming,
+        [this]() { frame_source_->StopStream(); },
+        [this]() { frame_source_->StartStream(); });
+}
+
+int ArenaDeviceHandler::GetPreviewDecimation_(const int image_width) const {
+    int preview_width = preview_width_;
+    if (preview_width <= 0)
+        return 1;
+    return std::max(1, image_width / preview_width);
+}
+
+void ArenaDeviceHandler::SetDnnRoi(const ROI& roi) {
+    std::lock_guard<std::recursive_mutex> lock(device_mutex_);
     if ((roi.offset_x + roi.width <= kSensorWidth) && (roi.offset_y + roi.height <= kSensorHeight)) {
         StopStream();
-        SetNodeParam_(kNodeNameRoiOffsetX_, ceil_roi(kInitRoiOffestX_));
-        SetNodeParam_(kNodeNameRoiOffsetY_, ceil_roi(kInitRoiOffsetY_));
-        SetNodeParam_(kNodeNameRoiWidth_, ceil_roi(roi.width));
-        SetNodeParam_(kNodeNameRoiHeight_, ceil_roi(roi.height));
-        SetNodeParam_(kNodeNameRoiOffsetX_, ceil_roi(roi.offset_x));
-        SetNodeParam_(kNodeNameRoiOffsetY_, ceil_roi(roi.offset_y));
+        RoiSwitcher::WriteRoi(*node_access_, roi_switcher_->GetDnnNodes(), roi);
         //StartStream(GetOperationMode());
         current_roi_ = roi; // Store the current ROI
     }
 }
 
 void ArenaDeviceHandler::SetRawRoi(const ROI& roi) {
+    std::lock_guard<std::recursive_mutex> lock(device_mutex_);
 	if ((roi.offset_x + roi.width <= kSensorWidth) && (roi.offset_y + roi.height <= kSensorHeight)) {
 		StopStream();
-		SetNodeParam_(kNodeNameRAWRoiOffsetX_, ceil_roi(kInitRoiOffestX_));
-		SetNodeParam_(kNodeNameRAWRoiOffsetY_, ceil_roi(kInitRoiOffsetY_));
-		SetNodeParam_(kNodeNameRAWRoiWidth_, ceil_roi(roi.width));
-		SetNodeParam_(kNodeNameRAWRoiHeight_, ceil_roi(roi.height));
-		SetNodeParam_(kNodeNameRAWRoiOffsetX_, ceil_roi(roi.offset_x));
-		SetNodeParam_(kNodeNameRAWRoiOffsetY_, ceil_roi(roi.offset_y));
-		
+		RoiSwitcher::WriteRoi(*node_access_, roi_switcher_->GetRawNodes(), roi);
+		raw_roi_ = roi;
 	}
 }
 
 void ArenaDeviceHandler::ResetDnnRoi() {
+    std::lock_guard<std::recursive_mutex> lock(device_mutex_);
     StopStream();
-    SetNodeParam_(kNodeNameRoiOffsetX_, 0);
-    SetNodeParam_(kNodeNameRoiOffsetY_, 0);
-    SetNodeParam_(kNodeNameRoiWidth_, kInitRoiWidth_);
-    SetNodeParam_(kNodeNameRoiHeight_, kInitRoiHeight_);
-    SetNodeParam_(kNodeNameRoiOffsetX_, kInitRoiOffestX_);
-    SetNodeParam_(kNodeNameRoiOffsetY_, kInitRoiOffsetY_);
+    ROI full_roi = { 0, kInitRoiOffestX_, kInitRoiOffsetY_, kInitRoiWidth_, kInitRoiHeight_ };
+    RoiSwitcher::WriteRoi(*node_access_, roi_switcher_->GetDnnNodes(), full_roi);
+    current_roi_ = full_roi;
 }
 
 void ArenaDeviceHandler::ResetRawRoi() {
+    std::lock_guard<std::recursive_mutex> lock(device_mutex_);
 	StopStream();
-	SetNodeParam_(kNodeNameRAWRoiOffsetX_, 0);
-	SetNodeParam_(kNodeNameRAWRoiOffsetY_, 0);
-	SetNodeParam_(kNodeNameRAWRoiWidth_, kInitRoiWidth_);
-	SetNodeParam_(kNodeNameRAWRoiHeight_, kInitRoiHeight_);
-	SetNodeParam_(kNodeNameRAWRoiOffsetX_, kInitRoiOffestX_);
-	SetNodeParam_(kNodeNameRAWRoiOffsetY_, kInitRoiOffsetY_);
+	ROI full_roi = { 0, kInitRoiOffestX_, kInitRoiOffsetY_, kInitRoiWidth_, kInitRoiHeight_ };
+	RoiSwitcher::WriteRoi(*node_access_, roi_switcher_->GetRawNodes(), full_roi);
+	raw_roi_ = full_roi;
 }
 
 ROI  ArenaDeviceHandler::GetDnnRoi() const {
@@ -125,10 +516,12 @@ ROI  ArenaDeviceHandler::GetDnnRoi() const {
 }
 
 std::string ArenaDeviceHandler::GetBarcode() {
+	std::lock_guard<std::mutex> lock(barcode_mutex_);
 	return barcode_;
 }
 
 void ArenaDeviceHandler::SetBarcode(std::string& barcode) {
+	std::lock_guard<std::mutex> lock(barcode_mutex_);
 	barcode_ = barcode;
 }
 
@@ -149,164 +542,411 @@ void ArenaDeviceHandler::SetPointerRoi(const int roi_id) {
     pointer_roi_ = roi_id;
 }
 
-// Function to extract image data within the bounding box
-std::vector<uint8_t> ArenaDeviceHandler::ExtractBoundingBoxData(Arena::IImage* pImage, const ArenaExample::ObjectDetectionUtils::rect_uint32& rect)
-{
-    std::vector<uint8_t> buffer;
-    int width = pImage->GetWidth();
-    int height = pImage->GetHeight();
-    int bytesPerPixel = pImage->GetBitsPerPixel() / 8;
-    const uint8_t* imageData = static_cast<const uint8_t*>(pImage->GetData());
 
-    for (uint32_t y = rect.top; y < rect.bottom; ++y)
-    {
-        for (uint32_t x = rect.left; x < rect.right; ++x)
-        {
-            int index = (y * width + x) * bytesPerPixel;
-            for (int b = 0; b < bytesPerPixel; ++b)
-            {
-                buffer.push_back(imageData[index + b]);
-            }
-        }
+// Runs on the capture thread. Acquires one image, parses the inference results,
+// decodes the barcodes and stores everything the UI needs into frame.
+bool ArenaDeviceHandler::Process(FrameResult& frame) {
+    if (is_stream_ != true) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return false;
     }
 
-    return buffer;
-}
+    std::lock_guard<std::recursive_mutex> lock(device_mutex_);
+    if (is_stream_ != true)
+        return false;
 
+    if (reload_network_)
+        ReloadNetwork_();
+    ApplyStagedRoi_(true);
 
-void ArenaDeviceHandler::Process(cv::Mat& original, cv::Mat& raw_cropped, cv::Mat& input_tensor, cv::Mat& detections) {
-    Arena::IImage* pImage;
     ArenaExample::BrainBuilderDetectorUtils outputUtil(&util_);
-    try
-    {
-        pImage = pDevice_->GetImage(kTimeOut_);
+    RawFrame raw;
+    if (!frame_source_->Acquire(raw, kCaptureTimeOut_)) {
+        if (frame_source_->IsConnected() == false) {
+            printf("The camera was disconnected\n");
+        }
+        return false;
     }
-    catch (GenICam::TimeoutException)
-    {
-        if (pDevice_->IsConnected() != false) {
-            printf("pDevice_->IsConnected() != false\n");
-            return;
+
+    RoiSwitchRecord roi_switch;
+    if (roi_switcher_->OnFrame(raw.frame_id, raw.timestamp_ns, roi_switch)) {
+        // The ticket completes even when the request was dropped, so that waiters and the tracker go on
+        roi_ticket_ = roi_switch.ticket;
+        if (roi_switch.failed) {
+            printf("Couldn't apply ROI %d to %s: %s\n", roi_switch.request.roi_id, serial_.c_str(), roi_switcher_->GetStats().last_error.c_str());
+            if (roi_scheduler_.IsActive())
+                StageNextScheduledRoi_();
         }
-        else
-        {
-            printf("The camera was disconnected\n");
-            return;
+        else {
+            stream_roi_id_ = roi_switch.request.roi_id;
+            roi_ticket_frame_id_ = roi_switch.effective_frame_id;
+            if (roi_switch.request.has_raw)
+                raw_roi_ = roi_switch.request.raw_roi;
+            if (roi_switch.request.has_dnn) {
+                current_roi_ = roi_switch.request.dnn_roi;
+                roi_tracker_.Reset(current_roi_, raw_roi_);
+            }
         }
     }
-    if (pImage != NULL)
+
+    frame.op_mode = op_mode_;
+    frame.roi_id = stream_roi_id_;
+    frame.roi_ticket = roi_ticket_;
+    frame.dnn_roi_ticket = roi_ticket_;
+    frame.stream_generation = stream_generation_;
+    frame.frame_id = raw.frame_id;
+    frame.device_timestamp_ns = raw.timestamp_ns;
+    frame.capture_timestamp_ns = raw.host_timestamp_ns;
+
+    // The camera buffer is only held while the chunk and the pixels that later stages need
+    // are copied out. Decoding and drawing work on the copies after it has been requeued.
+    auto acquired = std::chrono::steady_clock::now();
+    governor_.BeginFrame(acquired);
+    double overlay_ms = 0.0;
+    bool has_chunk = false;
+    bool has_tensor = false;
+    int decimation = 1;
+    detections_.clear();
+    tracked_rects_.clear();
+    // Mono and Bayer streams stay on one channel from the buffer to the textures
+    // Taken from the frame, the settings may name a format the camera did not take
+    bool is_gray = IsSingleChannelFormat(raw.pixel_format);
+    // The image the output tensor was computed on, decoded and drawn on in place of the current one
+    FrameContext* paired_context = &frame_context_;
+    cv::Point paired_offset(0, 0);  // Of the paired image in the current RAW image
+    int input_frame_count = -1;
+    // Streaming only the DNN chunk, the RAW image is a placeholder until a detection fetches it
+    bool has_raw_image = !roi_tracker_.IsIdleImage(raw.width, raw.height);
+    if (raw.is_complete)
     {
-        if (pImage->IsIncomplete() == false)
+        if (recorder_.IsRecording())
+            recorder_.Record(raw, stream_roi_id_, current_roi_);
+
+        // Every view below is derived from this buffer at most once
+        frame_context_.Reset(raw.data, raw.width, raw.height, raw.pixel_format);
+
+        // The UI only shows downscaled images, so only a decimated preview is converted
+        decimation = GetPreviewDecimation_(frame_context_.GetWidth());
+        frame.preview_decimation = decimation;
+
+        if ((op_mode_ == 0 || op_mode_ == 2) && has_raw_image) {
+            const cv::Mat& image_12m = is_gray ? frame_context_.GetPreviewGray(decimation) : frame_context_.GetPreviewBgr(decimation);
+            image_pool_.Reshape(frame.image_12m, image_12m.rows, image_12m.cols, image_12m.type());
+            image_12m.copyTo(frame.image_12m);
+            frame.has_image_12m = true;
+
+            cv::Rect detail_region;
+            {
+                std::lock_guard<std::mutex> lock(detail_mutex_);
+                detail_region = detail_region_ & cv::Rect(0, 0, frame_context_.GetWidth(), frame_context_.GetHeight());
+            }
+            if (!detail_region.empty()) {
+                const cv::Mat& detail_image = is_gray ? frame_context_.GetRegionGray(detail_region) : frame_context_.GetRegionBgr(detail_region);
+                image_pool_.Reshape(frame.detail_image, detail_region.height, detail_region.width, detail_image.type());
+                detail_image.copyTo(frame.detail_image);
+                frame.detail_region = detail_region;
+                frame.has_detail = true;
+            }
+        }
+
+        if (op_mode_ < 2) // Get input tensor and inference results
         {
-            Arena::IChunkData* pChunkData = pImage->AsChunkData();
-            if (pChunkData != NULL)
+            // util_ keeps its own copy of the chunk
+            has_chunk = util_.ProcessChunkData(raw.chunk, raw.chunk_size);
+            if (has_chunk && pDevice_ != nullptr) {
+                // A chunk of another network would be parsed with the wrong layout and labels
+                const ArenaExample::IMX501Utils::tensor_header* header = util_.GetInputTensorHeader();
+                if (header != nullptr && header->valid_flag != 0 && header->network_id != network_id_ && !CheckNetworkId_(header->network_id))
+                    has_chunk = false;
+            }
+            if (has_chunk)
             {
-                if (pChunkData->IsIncomplete() == false)
+                const ArenaExample::IMX501Utils::tensor_header* input_header = util_.GetInputTensorHeader();
+                const ArenaExample::IMX501Utils::tensor_header* output_header = util_.GetOutputTensorHeader();
+                // Counters of a tensor the IMX500 did not fill say nothing about the pairing
+                if (input_header != nullptr && input_header->valid_flag != 0)
+                    input_frame_count = input_header->frame_count;
+                int output_frame_count = (output_header != nullptr && output_header->valid_flag != 0) ? output_header->frame_count : -1;
+
+                // A box is only as tight as its image is right: the padding covers the DNN
+                // scaling, the wider one also some motion when the image is uncertain
+                int padding = kPairedDecodePadding_;
+                const HistoryFrame* history_frame = nullptr;
+                ROI raw_window = raw_roi_;
+                // Boxes are relative to the DNN ROI the output was inferred on, which a switch may have replaced since
+                ROI dnn_roi = current_roi_;
+                bool can_place_boxes = true;
+                FramePairer::Result pairing = frame_pairer_.Pair(raw.frame_id, raw.timestamp_ns, input_frame_count, output_frame_count, history_frame);
+                if (history_frame != nullptr) {
+                    dnn_roi = history_frame->dnn_roi;
+                    frame.dnn_roi_ticket = history_frame->roi_ticket;
+                }
+                else if (pairing == FramePairer::kMissing && raw.frame_id < roi_ticket_frame_id_ + (uint64_t)frame_pairer_.GetStats().offset) {
+                    // Inferred before the last switch on a frame that is no longer known
+                    can_place_boxes = false;
+                    frame.dnn_roi_ticket = 0;
+                }
+                if (pairing == FramePairer::kHistory) {
+                    paired_context_.Reset(history_frame->raw.data(), history_frame->width, history_frame->height, history_frame->pixel_format);
+                    paired_context = &paired_context_;
+                    raw_window = history_frame->raw_roi;
+                    paired_offset = cv::Point(raw_window.offset_x - raw_roi_.offset_x, raw_window.offset_y - raw_roi_.offset_y);
+                }
+                else if (pairing == FramePairer::kMissing) {
+                    padding = kUnpairedDecodePadding_;
+                }
+
+                // The overlay is only admitted after decoding, when the buffer is back with the
+                // camera, so the previews it may use are derived while the pixels are still here.
+                // Streaming RAW, the current one already was for image_12m.
+                if (has_raw_image) {
+                    auto overlay_start = std::chrono::steady_clock::now();
+                    if (is_gray)
+                        frame_context_.GetPreviewGray(decimation);
+                    else
+                        frame_context_.GetPreviewBgr(decimation);
+                    if (paired_context == &paired_context_) {
+                        if (is_gray)
+                            paired_context_.GetPreviewGray(decimation);
+                        else
+                            paired_context_.GetPreviewBgr(decimation);
+                    }
+                    overlay_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - overlay_start).count();
+                }
+
+                has_tensor = outputUtil.ProcessOutputTensor();
+                if (has_tensor)
                 {
-                    if (op_mode_ == 0 || op_mode_ == 2) {
-                        int width_12M = (int)pImage->GetWidth();
-                        int height_12M = (int)pImage->GetHeight();
-
-                        Arena::IImage* pImage_12M = Arena::ImageFactory::Convert(pImage, BGR8);
-                        cv::Mat image_12m = cv::Mat((int)pImage_12M->GetHeight(), (int)pImage_12M->GetWidth(), CV_8UC3, (void*)pImage_12M->GetData());
-                        image_12m.copyTo(original);
-                        Arena::ImageFactory::Destroy(pImage_12M);
+                    int width_12M_crop = paired_context->GetWidth();
+                    int height_12M_crop = paired_context->GetHeight();
+                    // The DNN ROI need not be the RAW window. A recording does not say where
+                    // its RAW image was, there both are taken to match.
+                    if (raw_window.width != width_12M_crop || raw_window.height != height_12M_crop) {
+                        dnn_roi = { 0, 0, 0, width_12M_crop, height_12M_crop };
+                        raw_window = dnn_roi;
                     }
-                  
-					ROI set_roi = GetDnnRoi();
 
-                    if (op_mode_ < 2) // Get input tensor and inference results
+                    int num = can_place_boxes ? outputUtil.GetObjectNum(detection_threshold_) : 0;
+                    for (int i = 0; i < num; i++)
                     {
-                        if (util_.ProcessChunkData(pChunkData))
-                        {
-                            int width_12M_crop = (int)pImage->GetWidth();
-                            int height_12M_crop = (int)pImage->GetHeight();
-
-                            Arena::IImage* pImage_12M_crop = Arena::ImageFactory::Convert(pImage, BGR8);
-                            cv::Mat image_12m_crop = cv::Mat((int)pImage_12M_crop->GetHeight(), (int)pImage_12M_crop->GetWidth(), CV_8UC3, (void*)pImage_12M_crop->GetData());
-                            cv::Mat detection_12m_copy = image_12m_crop.clone();
-
-                            input_tensor = cv::Mat((int)util_.GetInputImageHeight(), (int)util_.GetInputImageWidth(), CV_8UC3, (void*)util_.GetInputImagePtr());
-                            cv::Mat detection_copy = input_tensor.clone();
-
-                            //std::cout << util_->GetOutputTensorSize(0);
-                            if (outputUtil.ProcessOutputTensor())
-                            {
-                                outputUtil.DumpOutputTensor();
-
-                                int num = outputUtil.GetObjectNum(detection_threshold_);
-                                for (int i = 0; i < num; i++)
-                                {
-                                    ArenaExample::ObjectDetectionUtils::object_info info;
-                                    ArenaExample::ObjectDetectionUtils::rect_uint32 rect;
-                                    outputUtil.GetObjectInfo(i, &info);
-                                    rect = outputUtil.ToInputImageRect(info.location);
-                                    std::string label = util_.GetLabelStr(info.index);
-
-                                    if (label.find("barcode") != std::string::npos)
-                                    {
-                                        cv::rectangle(detection_copy, cv::Rect(rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top), cv::Scalar(0, 0, 255), 2);
-                                        cv::putText(detection_copy, label, cv::Point(rect.left, rect.top - 8), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 0), 1, cv::LINE_AA);
-
-                                        auto rect_12m = outputUtil.ToRect_uint32(info.location, width_12M_crop, height_12M_crop);
-
-										//Make the rect_12m a bit bigger to make sure the barcode is fully included
-										rect_12m.left = std::max(0, (int)rect_12m.left - 10);
-										rect_12m.top = std::max(0, (int)rect_12m.top - 10);
-										rect_12m.right = std::min(width_12M_crop, (int)rect_12m.right + 10);
-										rect_12m.bottom = std::min(height_12M_crop, (int)rect_12m.bottom + 10);
-
-                                        bool canDecode = false;
-
-                                        std::vector<uint8_t> buffer = ExtractBoundingBoxData(pImage_12M_crop, rect_12m);
-
-                                        // Save buffer as JPG for debugging
-                                        cv::Mat buffer_image(rect_12m.bottom - rect_12m.top, rect_12m.right - rect_12m.left, CV_8UC3);
-                                        std::memcpy(buffer_image.data, buffer.data(), buffer.size());
-                                        //cv::imwrite("buffer_image.jpg", buffer_image);
-
-                                        std::string result = DecodeWithRotation(buffer_image);
-                                        std::cout << "Barcode detected: " << result << "\n";
-
-                                        if (!result.empty())
-                                        {
-                                            canDecode = true;
-                                            SetBarcode(result);
-                                            cv::putText(detection_12m_copy, result, cv::Point(rect_12m.left, rect_12m.bottom + 60), cv::FONT_HERSHEY_SIMPLEX, 2, cv::Scalar(255, 0, 0), 2, cv::LINE_AA);
-                                        }
-
-                                        if (canDecode) {
-                                            cv::rectangle(detection_12m_copy, cv::Rect(rect_12m.left, rect_12m.top, rect_12m.right - rect_12m.left, rect_12m.bottom - rect_12m.top), cv::Scalar(0, 255, 0), 8);
-                                        }
-                                        else {
-                                            cv::rectangle(detection_12m_copy, cv::Rect(rect_12m.left, rect_12m.top, rect_12m.right - rect_12m.left, rect_12m.bottom - rect_12m.top), cv::Scalar(0, 0, 255), 8);
-                                        }
-
-                                        cv::putText(detection_12m_copy, label, cv::Point(rect_12m.left, rect_12m.top - 15), cv::FONT_HERSHEY_SIMPLEX, 2, cv::Scalar(0, 0, 0), 2, cv::LINE_AA);
-
-                                    }
-                                }
-
-                                detections = detection_copy;
-
-                            }
-                            else
-                            {
-                                printf("outputUtil_->ProcessOutputTensor() returned false\nNetwork mismatch?\n");
-                            }
-
-                            detection_12m_copy.copyTo(raw_cropped);
-                            Arena::ImageFactory::Destroy(pImage_12M_crop);
-                        }
-
+                        ArenaExample::ObjectDetectionUtils::object_info info;
+                        outputUtil.GetObjectInfo(i, &info);
+                        std::string label = util_.GetLabelStr(info.index);
+                        if (label.find("barcode") == std::string::npos)
+                            continue;
+
+                        // DNN ROI -> sensor -> RAW image
+                        auto rect_dnn = outputUtil.ToRect_uint32(info.location, dnn_roi.width, dnn_roi.height);
+                        cv::Rect rect_sensor(dnn_roi.offset_x + rect_dnn.left, dnn_roi.offset_y + rect_dnn.top, rect_dnn.right - rect_dnn.left, rect_dnn.bottom - rect_dnn.top);
+                        tracked_rects_.push_back(rect_sensor);
+
+                        //Make the rect_12m a bit bigger to make sure the barcode is fully included
+                        cv::Rect rect_12m(rect_sensor.x - raw_window.offset_x - padding, rect_sensor.y - raw_window.offset_y - padding,
+                            rect_sensor.width + 2 * padding, rect_sensor.height + 2 * padding);
+
+                        Detection detection;
+                        detection.label = label;
+                        detection.rect = outputUtil.ToInputImageRect(info.location);
+                        detection.sensor_rect = rect_sensor;
+                        // Empty when the barcode is outside of the RAW window or there is no RAW image yet
+                        if (paired_context == &paired_context_ || has_raw_image)
+                            detection.region = rect_12m & cv::Rect(0, 0, width_12M_crop, height_12M_crop);
+                        detection.is_reused = governor_.FindDecodedTrack(rect_sensor, detection.result);
+                        // Only the decoding regions are read out of the RAW image
+                        if (!detection.region.empty() && !detection.is_reused)
+                            paired_context->GetRegionGray(detection.region);
+                        detections_.push_back(detection);
                     }
+                }
+                // The history slot may be overwritten by Push() below
+                if (paired_context == &paired_context_)
+                    paired_context_.Detach();
+            }
+        }
+        // Later outputs are decoded within the DNN ROI of this frame, an idle image has nothing to decode
+        ROI history_window = { current_roi_.id, current_roi_.offset_x - kUnpairedDecodePadding_, current_roi_.offset_y - kUnpairedDecodePadding_,
+            current_roi_.width + 2 * kUnpairedDecodePadding_, current_roi_.height + 2 * kUnpairedDecodePadding_ };
+        if (!has_raw_image)
+            history_window.width = 0;
+        frame_pairer_.Push(raw, input_frame_count, raw_roi_, current_roi_, roi_ticket_, history_window);
+        frame_context_.Detach();
+    }
+    frame_source_->Release(raw);
+    if (raw.is_complete && first_frame_ms_ < 0.0) {
+        first_frame_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - stream_start_time_).count();
+        printf("First frame of %s %.0f ms after the stream started\n", serial_.c_str(), (double)first_frame_ms_);
+    }
+    double hold_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - acquired).count();
+    if (raw.is_complete)
+        CheckSequence_(raw, has_chunk, frame);
+
+    if (has_chunk)
+    {
+        if (has_tensor)
+        {
+            outputUtil.DumpOutputTensor();
+
+            // Decoding comes first, the images for the UI only get what is left of the budget
+            int row_step = governor_.GetRowStep();
+            int max_rotations = governor_.GetMaxRotations();
+            for (Detection& detection : detections_)
+            {
+                frame.num_detections++;
+                if (detection.region.empty() || detection.is_reused || !governor_.Admit(ProcessingGovernor::kDecode))
+                    continue;
+
+                auto decode_start = std::chrono::steady_clock::now();
+                // Binarized from the gray region copied out before the buffer was requeued
+                const std::vector<uint8_t>& binary_image = paired_context->GetRegionBinary(detection.region);
+                detection.result = DecodeBinaryWithRotation(binary_image, detection.region.width, detection.region.height, row_step, max_rotations);
+                governor_.EndStage(ProcessingGovernor::kDecode, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - decode_start).count());
+                std::cout << "Barcode detected: " << detection.result << "\n";
+                if (!detection.result.empty())
+                    governor_.AddDecodedTrack(detection.sensor_rect, detection.result);
+                if (exposure_controller_.IsEnabled())
+                    exposure_controller_.OnRegion(paired_context->GetRegionGray(detection.region), !detection.result.empty());
+            }
+            for (const Detection& detection : detections_)
+            {
+                if (detection.result.empty())
+                    continue;
+                std::string result = detection.result;
+                SetBarcode(result);
+                frame.barcodes.push_back(result);
+            }
+        }
+        else
+        {
+            printf("outputUtil_->ProcessOutputTensor() returned false\nNetwork mismatch?\n");
+        }
 
+        if (governor_.Admit(ProcessingGovernor::kInputTensor))
+        {
+            auto input_start = std::chrono::steady_clock::now();
+            // util_ only extracts the image when asked, straight into the frame the UI gets
+            int input_height = (int)util_.GetInputImageHeight();
+            int input_width = (int)util_.GetInputImageWidth();
+            image_pool_.Reshape(frame.input_tensor, input_height, input_width, CV_8UC3);
+            image_pool_.Reshape(frame.detections, input_height, input_width, CV_8UC3);
+            // Fails when the chunk held no input tensor or its image does not fit, the UI keeps the last one
+            frame.has_input_tensor = util_.CopyInputImage(frame.input_tensor.data, frame.input_tensor.total() * frame.input_tensor.elemSize());
+            if (frame.has_input_tensor)
+            {
+                frame.input_tensor.copyTo(frame.detections);
+                cv::Mat& detection_copy = frame.detections;
+                for (const Detection& detection : detections_)
+                {
+                    const ArenaExample::ObjectDetectionUtils::rect_uint32& rect = detection.rect;
+                    cv::rectangle(detection_copy, cv::Rect(rect.left, rect.top, rect.right - rect.left, rect.bottom - rect.top), cv::Scalar(0, 0, 255), 2);
+                    cv::putText(detection_copy, detection.label, cv::Point(rect.left, rect.top - 8), cv::FONT_HERSHEY_SIMPLEX, 0.5, cv::Scalar(0, 0, 0), 1, cv::LINE_AA);
                 }
             }
-            else
+            governor_.EndStage(ProcessingGovernor::kInputTensor, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - input_start).count());
+        }
+
+        // Only what decoding left of the budget goes to the overlay
+        if (has_raw_image && governor_.Admit(ProcessingGovernor::kOverlay))
+        {
+            auto overlay_start = std::chrono::steady_clock::now();
+            const cv::Mat& preview = is_gray ? frame_context_.GetPreviewGray(decimation) : frame_context_.GetPreviewBgr(decimation);
+            image_pool_.Reshape(frame.raw_cropped, preview.rows, preview.cols, preview.type());
+            preview.copyTo(frame.raw_cropped);
+            // The history only holds the DNN window, it is shown over the current image
+            if (paired_context == &paired_context_) {
+                const cv::Mat& paired_preview = is_gray ? paired_context_.GetPreviewGray(decimation) : paired_context_.GetPreviewBgr(decimation);
+                cv::Point origin(paired_offset.x / decimation, paired_offset.y / decimation);
+                cv::Rect target = cv::Rect(origin, paired_preview.size()) & cv::Rect(0, 0, frame.raw_cropped.cols, frame.raw_cropped.rows);
+                if (!target.empty())
+                    paired_preview(target - origin).copyTo(frame.raw_cropped(target));
+            }
+            cv::Mat& detection_12m_copy = frame.raw_cropped;
+            int thickness_12m = std::max(1, 8 / decimation);
+            // A one-channel preview only takes the first component, so decoded boxes are white and the rest black
+            const cv::Scalar decoded_color = is_gray ? cv::Scalar(255) : cv::Scalar(0, 255, 0);
+            const cv::Scalar failed_color = is_gray ? cv::Scalar(0) : cv::Scalar(0, 0, 255);
+            const cv::Scalar result_color = is_gray ? cv::Scalar(255) : cv::Scalar(255, 0, 0);
+            int text_thickness_12m = std::max(1, 2 / decimation);
+            double font_scale_12m = 2.0 / decimation;
+
+            for (const Detection& detection : detections_)
             {
-                printf("no chunk data\n");
+                if (detection.region.empty())
+                    continue;
+                // Regions of a paired image are relative to its window
+                cv::Rect region = detection.region + paired_offset;
+
+                // Overlays are drawn in preview coordinates
+                cv::Rect rect_preview(region.x / decimation, region.y / decimation, region.width / decimation, region.height / decimation);
+
+                bool canDecode = !detection.result.empty();
+                if (canDecode) {
+                    cv::putText(detection_12m_copy, detection.result, cv::Point(rect_preview.x, rect_preview.br().y + 60 / decimation), cv::FONT_HERSHEY_SIMPLEX, font_scale_12m, result_color, text_thickness_12m, cv::LINE_AA);
+                    cv::rectangle(detection_12m_copy, rect_preview, decoded_color, thickness_12m);
+                }
+                else {
+                    cv::rectangle(detection_12m_copy, rect_preview, failed_color, thickness_12m);
+                }
+
+                cv::putText(detection_12m_copy, detection.label, cv::Point(rect_preview.x, rect_preview.y - 15 / decimation), cv::FONT_HERSHEY_SIMPLEX, font_scale_12m, cv::Scalar(0, 0, 0), text_thickness_12m, cv::LINE_AA);
             }
+            frame.has_overlay = true;
+            overlay_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - overlay_start).count();
+            governor_.EndStage(ProcessingGovernor::kOverlay, overlay_ms);
         }
+
+        frame.has_inference = true;
     }
-    pDevice_->RequeueBuffer(pImage);
-}
\ No newline at end of file
+
+    if (roi_scheduler_.OnFrame(frame))
+        StageNextScheduledRoi_();
+    if (has_tensor)
+        TrackRawRoi_();
+    if (has_tensor && exposure_controller_.IsEnabled()) {
+        try {
+            exposure_controller_.OnFrame(*node_access_);
+        }
+        catch (GenICam::GenericException& ge) {
+            printf("Couldn't adjust the exposure of %s: %s\n", serial_.c_str(), ge.what());
+        }
+        catch (std::exception& ex) {
+            printf("Couldn't adjust the exposure of %s: %s\n", serial_.c_str(), ex.what());
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(latency_mutex_);
+        latency_stats_.hold_ms = (latency_stats_.hold_ms > 0.0) ? latency_stats_.hold_ms + kLatencySmoothing_ * (hold_ms - latency_stats_.hold_ms) : hold_ms;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_stream_statistics_ >= kStreamStatisticsInterval_) {
+        StreamStatistics statistics = frame_source_->GetStreamStatistics();
+        std::lock_guard<std::mutex> lock(latency_mutex_);
+        stream_statistics_ = statistics;
+        last_stream_statistics_ = now;
+    }
+
+    if (raw.host_timestamp_ns != 0) {
+        uint64_t now_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        frame.latency_ms = ((int64_t)now_ns - (int64_t)raw.host_timestamp_ns) / 1e6;
+        std::lock_guard<std::mutex> lock(latency_mutex_);
+        latency_stats_.last_ms = frame.latency_ms;
+        latency_stats_.mean_ms = (latency_stats_.frames > 0) ? latency_stats_.mean_ms + kLatencySmoothing_ * (frame.latency_ms - latency_stats_.mean_ms) : frame.latency_ms;
+        latency_stats_.max_ms = std::max(latency_stats_.max_ms, frame.latency_ms);
+        latency_stats_.frames++;
+    }
+    governor_.EndFrame();
+
+    if (aggregator_ != nullptr && frame.has_inference) {
+        DeviceResult result;
+        result.serial = serial_;
+        result.device_timestamp_ns = raw.timestamp_ns;
+        result.frame_id = raw.frame_id;
+        result.roi_id = frame.roi_id;
+        result.latency_ms = frame.latency_ms;
+        result.num_detections = frame.num_detections;
+        result.barcodes = frame.barcodes;
+        aggregator_->Push(std::move(result));
+    }
+
+    return frame.has_image_12m || frame.has_inference;
+}
@@ -19,18 +19,92 @@
 #include "BrainBuilderDetectorUtils.h"
 #include "ean13_reader.h"
 #include "./common.h"
+#include "./capture_worker.h"
+#include "./frame_source.h"
+#include "./frame_recorder.h"
+#include "./frame_sequence.h"
+#include "./frame_pairer.h"
+#include "./raw_roi_tracker.h"
+#include "./processing_governor.h"
+#include "./exposure_controller.h"
+#include "./network_cache.h"
+#include "./image_pool.h"
+#include "./frame_context.h"
+#include "./node_access.h"
+#include "./roi_switcher.h"
+#include "./roi_scheduler.h"
+#include "./result_aggregator.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
 
+// Where a camera is in its startup. Index into kStartupStage.
+enum class StartupStage {
+    Waiting,
+    Connecting,
+    LoadingNetwork,
+    ConfiguringRoi,
+    Ready,
+    Failed,
+};
+
 class ArenaDeviceHandler {
 public:
-    ArenaDeviceHandler();
+    // Takes over pDevice once constructed and destroys it through pSystem. on_stage is called from the
+    // constructor as the camera goes through its startup stages.
+    ArenaDeviceHandler(Arena::ISystem* pSystem, Arena::IDevice* pDevice, const std::string& serial, ResultAggregator* aggregator, const std::function<void(StartupStage)>& on_stage = nullptr);
+    // Replays the manifest or recording directory at replay_path instead of opening a camera
+    ArenaDeviceHandler(const std::string& replay_path, ResultAggregator* aggregator);
     ~ArenaDeviceHandler();
+    const std::string& GetSerial() const;
     //void SetOperationMode(const int op_mode);
     int GetOperationMode();
     bool GetStreamStatus();
     ROI current_roi_;
-    void Process(cv::Mat& image_12m, cv::Mat& raw_cropped, cv::Mat& input_tensor, cv::Mat& detections);
-    std::vector<uint8_t> ExtractBoundingBoxData(Arena::IImage* pImage, const ArenaExample::ObjectDetectionUtils::rect_uint32& rect);
+    bool Process(FrameResult& frame);
+    void StartCapture();
+    void StopCapture();
+    bool GetLatestFrame(FrameResult& frame);
+    bool WaitForFrame(FrameResult& frame, const int timeout_ms);
+    uint64_t GetStreamGeneration() const;
+    uint64_t GetDroppedFrameCount() const;
+    ImagePool& GetImagePool();
+    void SetPreviewWidth(const int width);
+    void SetDetailRegion(const ROI& roi);
+    uint64_t StageRoi(const RoiRequest& request);
+    bool WaitForRoi(FrameResult& frame, const uint64_t ticket, const int timeout_ms);
+    RoiSwitchRecord GetLastRoiSwitch();
+    RoiSwitchStats GetRoiSwitchStats();
+    void StartSchedule(const std::vector<ROI>& rois);
+    void StopSchedule();
+    RoiScheduler& GetScheduler();
+    void SetAcquisitionSettings(const AcquisitionSettings& settings);
+    AcquisitionSettings GetAcquisitionSettings();
+    LatencyStats GetLatencyStats();
+    // From the last StartStream() to its first complete frame, negative until that arrived
+    double GetTimeToFirstFrameMs() const;
+    StreamStatistics GetStreamStatistics();
+    // Frame id and tensor frame_count checks since the last StartStream()
+    SequenceStats GetSequenceStats();
+    void SetPairingSettings(const PairingSettings& settings);
+    PairingSettings GetPairingSettings();
+    PairingStats GetPairingStats();
+    void SetGovernorSettings(const GovernorSettings& settings);
+    GovernorSettings GetGovernorSettings();
+    GovernorStats GetGovernorStats();
+    void SetExposureSettings(const ExposureSettings& settings);
+    ExposureSettings GetExposureSettings();
+    ExposureStats GetExposureStats();
+    void SetRoiTracking(const RoiTrackingSettings& settings);
+    RoiTrackingSettings GetRoiTracking();
+    RoiTrackingStats GetRoiTrackingStats();
+    // Sensor window of the RAW image in effect
+    ROI GetRawRoi();
+    bool StartRecording(const std::string& directory);
+    void StopRecording();
+    FrameRecorder& GetRecorder();
     void StartStream(const int op_mode);
     void StopStream();
     void SetDnnRoi(const ROI& roi);
@@ -46,35 +120,93 @@ public:
     ROI GetDnnRoi() const;
 
 private:
-    void SetNodeParam_(const GENICAM_NAMESPACE::gcstring& node_name, const int node_value);
-    Arena::ISystem* pSystem_;
-    Arena::IDevice* pDevice_;
+    // A detection of the current frame, collected before the camera buffer is requeued
+    struct Detection {
+        std::string label;
+        ArenaExample::ObjectDetectionUtils::rect_uint32 rect; // Input tensor coordinates
+        cv::Rect region;                                       // Decoding region in RAW image coordinates
+        cv::Rect sensor_rect;                                  // The box in sensor coordinates
+        std::string result;                                    // Decoded text, empty when not decoded
+        bool is_reused = false;                                // result taken over from an already decoded track
+    };
+
+    void InitNetwork_();
+    bool CheckNetworkId_(const int network_id);
+    void ReloadNetwork_();
+    int GetPreviewDecimation_(const int image_width) const;
+    void ApplyStagedRoi_(const bool is_streaming);
+    void StageNextScheduledRoi_();
+    void CheckSequence_(const RawFrame& raw, const bool has_chunk, FrameResult& frame);
+    void TrackRawRoi_();
+    bool TryStartStream_(const char* action);
+    Arena::ISystem* pSystem_; // Owned by DeviceManager
+    Arena::IDevice* pDevice_; // nullptr when replaying a recording
+    std::string serial_;
+    ResultAggregator* aggregator_;
     ArenaExample::IMX501Utils util_;
     GenApi::INodeMap* pNodeMap;
-    GenApi::CIntegerPtr pNode;
-    int op_mode_ = 1; // 0-> get all, 1-> get inference results only
-    bool is_stream_ = false;
-    double detection_threshold_ = 0.6f;
+    std::atomic<int> op_mode_{ 1 }; // 0-> get all, 1-> get inference results only
+    std::atomic<bool> is_stream_{ false };
+    std::atomic<double> detection_threshold_{ 0.6f };
     int pointer_roi_ = 0;
+    int stream_roi_id_ = 0;
+    std::atomic<uint64_t> stream_generation_{ 0 };
+    uint64_t roi_ticket_ = 0;
+    uint64_t roi_ticket_frame_id_ = 0;  // Frame the last applied ROI took effect on
 
-    std::string barcode_ = "0000000000000";
+    // Serializes device access between the capture thread and the UI thread
+    std::recursive_mutex device_mutex_;
+    std::mutex barcode_mutex_;
+    std::mutex detail_mutex_;
+    std::mutex latency_mutex_;
+    AcquisitionSettings acquisition_settings_;
+    LatencyStats latency_stats_;
+    StreamStatistics stream_statistics_; // Published by the capture thread every kStreamStatisticsInterval_
+    std::chrono::steady_clock::time_point last_stream_statistics_;
+    std::chrono::steady_clock::time_point stream_start_time_;
+    std::atomic<double> first_frame_ms_{ -1.0 };
+    std::atomic<int> preview_width_{ 0 }; // 0 -> full resolution
+    cv::Rect detail_region_;
+    ImagePool image_pool_;
+    FrameContext frame_context_; // Views of the frame being processed, shared by display and decoders
+    FrameContext paired_context_; // Views of the earlier frame its output tensor was computed on
+    FramePairer frame_pairer_;
+    RawRoiTracker roi_tracker_;
+    ProcessingGovernor governor_;
+    ExposureController exposure_controller_;
+    std::vector<cv::Rect> tracked_rects_; // Barcodes of the current frame in sensor coordinates, reused
+    uint64_t tracking_ticket_ = 0;        // Ticket of the last window staged by roi_tracker_
+    ROI raw_roi_;                         // RAW window in effect, in sensor coordinates
+    std::vector<Detection> detections_; // Reused across frames
+    uint64_t network_fingerprint_ = 0;  // Of the network description in util_
+    int network_id_ = -1;               // Network id of its chunks, -1 until one arrived
+    bool reload_network_ = false;       // The description is read again before the next frame
+    FrameSequenceTracker sequence_tracker_;
+    int sequence_events_ = 0; // Events since the last sequence log line
+    std::chrono::steady_clock::time_point last_sequence_log_;
+    std::unique_ptr<IFrameSource> frame_source_;
+    std::unique_ptr<INodeAccess> node_access_;
+    std::unique_ptr<RoiSwitcher> roi_switcher_;
+    RoiScheduler roi_scheduler_;
+    FrameRecorder recorder_;
+    CaptureWorker capture_worker_;
 
-    const GENICAM_NAMESPACE::gcstring& kNodeNameRoiOffsetX_ = "DeepNeuralNetworkISPOffsetX";
-    const GENICAM_NAMESPACE::gcstring& kNodeNameRoiOffsetY_ = "DeepNeuralNetworkISPOffsetY";
-    const GENICAM_NAMESPACE::gcstring& kNodeNameRoiWidth_ = "DeepNeuralNetworkISPWidth";
-    const GENICAM_NAMESPACE::gcstring& kNodeNameRoiHeight_ = "DeepNeuralNetworkISPHeight";
+    std::string barcode_ = "0000000000000";
 
-    const GENICAM_NAMESPACE::gcstring& kNodeNameRAWRoiOffsetX_ = "OffsetX";
-    const GENICAM_NAMESPACE::gcstring& kNodeNameRAWRoiOffsetY_ = "OffsetY";
-    const GENICAM_NAMESPACE::gcstring& kNodeNameRAWRoiWidth_ = "Width";
-    const GENICAM_NAMESPACE::gcstring& kNodeNameRAWRoiHeight_ = "Height";
+    const RoiNodeNames kDnnRoiNodes_ = { "DeepNeuralNetworkISPOffsetX", "DeepNeuralNetworkISPOffsetY", "DeepNeuralNetworkISPWidth", "DeepNeuralNetworkISPHeight" };
+    const RoiNodeNames kRawRoiNodes_ = { "OffsetX", "OffsetY", "Width", "Height" };
 
     const int kInitRoiOffestX_ = 0;
     const int kInitRoiOffsetY_ = 0;
     const int kInitRoiWidth_ = kSensorWidth;
     const int kInitRoiHeight_ = kSensorHeight;
 
-    const int kTimeOut_ = 2000;
+    const int kCaptureTimeOut_ = 100; // Short enough to keep UI requests responsive
+    const double kLatencySmoothing_ = 0.1;
+    const std::chrono::seconds kSequenceLogInterval_{ 1 };
+    const std::chrono::milliseconds kStreamStatisticsInterval_{ 500 };
+    const int kPairedDecodePadding_ = 4;     // Sensor pixels around a box paired with its own image
+    const int kUnpairedDecodePadding_ = 10;  // Sensor pixels around a box whose image is not known
 
 
 };
@@ -0,0 +1,181 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file device_manager.cpp
+* @brief Owns the Arena system and one ArenaDeviceHandler per connected camera
+* @date 2026/10
+*/
+
+#include "./device_manager.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+DeviceManager::DeviceManager(const std::vector<std::string>& serials, const std::string& replay_path)
+    : startup_begin_(std::chrono::steady_clock::now()) {
+    startup_ = std::thread(&DeviceManager::Startup_, this, serials, replay_path);
+}
+
+DeviceManager::~DeviceManager() {
+    if (startup_.joinable())
+        startup_.join();
+    StopCapture();
+    devices_.clear();
+    if (pSystem_ != nullptr)
+        Arena::CloseSystem(pSystem_);
+}
+
+void DeviceManager::Startup_(const std::vector<std::string> serials, const std::string replay_path) {
+    try {
+        if (!replay_path.empty()) {
+            {
+                std::lock_guard<std::mutex> lock(startup_mutex_);
+                startup_status_.resize(1);
+                startup_status_[0].serial = "Replay";
+            }
+            is_discovering_ = false;
+            SetStage_(0, StartupStage::Connecting);
+            devices_.emplace_back(new ArenaDeviceHandler(replay_path, &aggregator_));
+            serials_.push_back(devices_.back()->GetSerial());
+            SetStage_(0, StartupStage::Ready);
+            startup_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startup_begin_).count();
+            is_startup_done_ = true;
+            return;
+        }
+
+        pSystem_ = Arena::OpenSystem();
+        pSystem_->UpdateDevices(100);
+        std::vector<Arena::DeviceInfo> deviceInfos;
+        for (const Arena::DeviceInfo& deviceInfo : pSystem_->GetDevices()) {
+            std::string serial = deviceInfo.SerialNumber().c_str();
+            if (serials.empty() || std::find(serials.begin(), serials.end(), serial) != serials.end())
+                deviceInfos.push_back(deviceInfo);
+        }
+        {
+            std::lock_guard<std::mutex> lock(startup_mutex_);
+            startup_status_.resize(deviceInfos.size());
+            for (size_t i = 0; i < deviceInfos.size(); i++)
+                startup_status_[i].serial = deviceInfos[i].SerialNumber().c_str();
+        }
+        is_discovering_ = false;
+
+        // A camera that fails is reported and left out, the others keep running
+        std::vector<std::unique_ptr<ArenaDeviceHandler>> handlers(deviceInfos.size());
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < deviceInfos.size(); i++)
+            threads.emplace_back(&DeviceManager::OpenDevice_, this, std::cref(deviceInfos[i]), i, std::ref(handlers[i]));
+        for (std::thread& thread : threads)
+            thread.join();
+
+        for (size_t i = 0; i < handlers.size(); i++) {
+            if (!handlers[i])
+                continue;
+            serials_.push_back(handlers[i]->GetSerial());
+            devices_.push_back(std::move(handlers[i]));
+        }
+        if (devices_.empty())
+            throw std::runtime_error("deviceInfos.size() == 0");
+    }
+    catch (...) {
+        devices_.clear();
+        serials_.clear();
+        if (pSystem_ != nullptr)
+            Arena::CloseSystem(pSystem_);
+        pSystem_ = nullptr;
+        startup_error_ = std::current_exception();
+    }
+    is_discovering_ = false;
+    startup_ms_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startup_begin_).count();
+    is_startup_done_ = true;
+}
+
+void DeviceManager::OpenDevice_(const Arena::DeviceInfo& deviceInfo, const size_t slot, std::unique_ptr<ArenaDeviceHandler>& handler) {
+    std::string serial = deviceInfo.SerialNumber().c_str();
+    Arena::IDevice* pDevice = nullptr;
+    try {
+        SetStage_(slot, StartupStage::Connecting);
+        {
+            std::lock_guard<std::mutex> lock(system_mutex_);
+            pDevice = pSystem_->CreateDevice(deviceInfo);
+        }
+        handler.reset(new ArenaDeviceHandler(pSystem_, pDevice, serial, &aggregator_, [this, slot](StartupStage stage) { SetStage_(slot, stage); }));
+        SetStage_(slot, StartupStage::Ready);
+        return;
+    }
+    catch (GenICam::GenericException& ge) {
+        printf("Couldn't open %s: %s\n", serial.c_str(), ge.what());
+        SetStage_(slot, StartupStage::Failed, ge.what());
+    }
+    catch (std::exception& ex) {
+        printf("Couldn't open %s: %s\n", serial.c_str(), ex.what());
+        SetStage_(slot, StartupStage::Failed, ex.what());
+    }
+    if (pDevice != nullptr) {
+        std::lock_guard<std::mutex> lock(system_mutex_);
+        pSystem_->DestroyDevice(pDevice);
+    }
+}
+
+void DeviceManager::SetStage_(const size_t slot, const StartupStage stage, const std::string& error) {
+    std::lock_guard<std::mutex> lock(startup_mutex_);
+    DeviceStartup& status = startup_status_[slot];
+    status.stage = stage;
+    status.error = error;
+    status.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startup_begin_).count();
+}
+
+bool DeviceManager::IsStartupDone() const {
+    return is_startup_done_;
+}
+
+void DeviceManager::FinishStartup() {
+    if (startup_.joinable())
+        startup_.join();
+    if (startup_error_)
+        std::rethrow_exception(startup_error_);
+}
+
+bool DeviceManager::IsDiscovering() const {
+    return is_discovering_;
+}
+
+double DeviceManager::GetStartupMs() const {
+    return startup_ms_;
+}
+
+std::vector<DeviceStartup> DeviceManager::GetStartupStatus() {
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(startup_mutex_);
+    std::vector<DeviceStartup> status = startup_status_;
+    for (DeviceStartup& device : status) {
+        if (device.stage != StartupStage::Ready && device.stage != StartupStage::Failed)
+            device.elapsed_ms = std::chrono::duration<double, std::milli>(now - startup_begin_).count();
+    }
+    return status;
+}
+
+size_t DeviceManager::GetDeviceCount() const {
+    return devices_.size();
+}
+
+ArenaDeviceHandler& DeviceManager::GetDevice(const size_t index) {
+    return *devices_[index];
+}
+
+const std::string& DeviceManager::GetSerial(const size_t index) const {
+    return serials_[index];
+}
+
+void DeviceManager::StartCapture() {
+    for (auto& device : devices_)
+        device->StartCapture();
+}
+
+void DeviceManager::StopCapture() {
+    for (auto& device : devices_)
+        device->StopCapture();
+}
+
+ResultAggregator& DeviceManager::GetAggregator() {
+    return aggregator_;
+}
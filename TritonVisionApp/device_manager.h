@@ -0,0 +1,87 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/**
+* @file device_manager.h
+* @brief Owns the Arena system and one ArenaDeviceHandler per connected camera
+* @date 2026/10
+*/
+
+#ifndef DEVICE_MANAGER_H_
+#define DEVICE_MANAGER_H_
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Arena/ArenaApi.h"
+#include "./device_handler.h"
+#include "./result_aggregator.h"
+
+// Startup progress of one camera
+struct DeviceStartup {
+    std::string serial;
+    StartupStage stage = StartupStage::Waiting;
+    double elapsed_ms = 0.0; // Since DeviceManager was created, stops when Ready or Failed
+    std::string error;       // Set when Failed
+};
+
+// The Arena system handle can only be opened once per process, so it lives here and
+// is shared by every device. Each device gets its own handler, IMX501Utils and capture
+// thread. All of them push their results into the same ResultAggregator.
+//
+// Startup runs in the background: one thread discovers the cameras, then every camera
+// is connected, gets its network loaded and its ROI configured on a thread of its own.
+// Only CreateDevice() is serialized, as it goes through the shared system handle.
+class DeviceManager {
+public:
+    // Starts opening every enumerated device, or only the ones whose serial number is listed.
+    // With a replay_path, no camera is opened and the recording is replayed as the only device.
+    DeviceManager(const std::vector<std::string>& serials, const std::string& replay_path);
+    ~DeviceManager();
+
+    // True once the cameras were found and every one of them is Ready or Failed
+    bool IsStartupDone() const;
+    // Waits for the startup. Throws when no device could be opened.
+    // The device accessors below may only be used after it returned.
+    void FinishStartup();
+    bool IsDiscovering() const;
+    std::vector<DeviceStartup> GetStartupStatus();
+    // From the creation of DeviceManager until the startup was done
+    double GetStartupMs() const;
+
+    size_t GetDeviceCount() const;
+    ArenaDeviceHandler& GetDevice(const size_t index);
+    const std::string& GetSerial(const size_t index) const;
+
+    void StartCapture();
+    void StopCapture();
+
+    ResultAggregator& GetAggregator();
+
+private:
+    void Startup_(const std::vector<std::string> serials, const std::string replay_path);
+    void OpenDevice_(const Arena::DeviceInfo& deviceInfo, const size_t slot, std::unique_ptr<ArenaDeviceHandler>& handler);
+    void SetStage_(const size_t slot, const StartupStage stage, const std::string& error = "");
+
+    Arena::ISystem* pSystem_ = nullptr; // nullptr when replaying
+    std::vector<std::unique_ptr<ArenaDeviceHandler>> devices_;
+    std::vector<std::string> serials_;
+    ResultAggregator aggregator_;
+
+    std::chrono::steady_clock::time_point startup_begin_;
+    std::thread startup_;
+    std::mutex system_mutex_;
+    std::mutex startup_mutex_;
+    std::vector<DeviceStartup> startup_status_;
+    std::atomic<bool> is_discovering_{ true };
+    std::atomic<bool> is_startup_done_{ false };
+    std::atomic<double> startup_ms_{ 0.0 };
+    std::exception_ptr startup_error_;
+};
+
+#endif
@@ -217,7 +217,7 @@ void SaveImageAsJPG(const std::vector<uint8_t>& image, int height, int width, co
 * decided that moving up and down by about 1/16 of the image is pretty good; we try more of the
 * image if "trying harder".
 */
-std::set<std::string> DoDecode(const std::vector<uint8_t>& BinarizedImage, int width, int height)
+std::set<std::string> DoDecode(const std::vector<uint8_t>& BinarizedImage, int width, int height, int rowStep)
 {
 
 	//SaveImageAsJPG(BinarizedImage, height, width, "debug_image.jpg");
@@ -228,7 +228,7 @@ std::set<std::string> DoDecode(const std::vector<uint8_t>& BinarizedImage, int w
 	//int fixed_max_top_lines = 100;
 
 	int middle = height / 2;
-	int rowStep = 1;
+	rowStep = std::max(1, rowStep);
 	int maxLines = height;
 
 	std::vector<int> checkRows;
@@ -307,9 +307,12 @@ std::string DecodeWithRotation(const cv::Mat buffer_image) {
 	int height = buffer_image.rows;
 	int width = buffer_image.cols;
 
-	// Convert the image to grayscale
+	// Convert the image to grayscale, one-channel images already are
 	cv::Mat gray_image;
-	cv::cvtColor(buffer_image, gray_image, cv::COLOR_BGR2GRAY);
+	if (buffer_image.channels() == 1)
+		gray_image = buffer_image;
+	else
+		cv::cvtColor(buffer_image, gray_image, cv::COLOR_BGR2GRAY);
 
 	//Convert grayscale image to binary image using Otus thresholding
 	cv::Mat binary_image;
@@ -318,13 +321,19 @@ std::string DecodeWithRotation(const cv::Mat buffer_image) {
 	//save the binary image for debugging
 	//cv::imwrite("binary_image.jpg", binary_image);
 	// Flatten the binary_image image into a vector
+	image.reserve((size_t)width * height);
 	for (int i = 0; i < height; ++i) {
-		for (int j = 0; j < width; ++j) {
-			image.push_back(binary_image.at<uchar>(i, j));
-		}
+		const uchar* row = binary_image.ptr<uchar>(i);
+		image.insert(image.end(), row, row + width);
 	}
 
-	std::set<std::string> results = DoDecode(image, width, height);
+	return DecodeBinaryWithRotation(image, width, height);
+}
+
+// Decodes an already binarized image, trying 90 degree rotations when the upright scan fails
+std::string DecodeBinaryWithRotation(const std::vector<uint8_t>& image, int width, int height, int rowStep, int maxRotations) {
+
+	std::set<std::string> results = DoDecode(image, width, height, rowStep);
 
 	//Save the image as jpg for debugging
 
@@ -332,12 +341,12 @@ std::string DecodeWithRotation(const cv::Mat buffer_image) {
 		std::vector<uint8_t> rotatedImage = image;
 		int newHeight = height;
 		int newWidth = width;
-		for (int angle = 90; angle < 360; angle += 90) {
+		for (int angle = 90; angle < 360 && angle <= maxRotations * 90; angle += 90) {
 			float radians = angle * M_PI / 180.0f;
 			rotatedImage = RotateImage(image, width, height, radians);
 			newHeight = static_cast<int>(std::abs(height * std::cos(radians)) + std::abs(width * std::sin(radians)));
 			newWidth = static_cast<int>(std::abs(width * std::cos(radians)) + std::abs(height * std::sin(radians)));
-			results = DoDecode(rotatedImage, newWidth, newHeight);
+			results = DoDecode(rotatedImage, newWidth, newHeight, rowStep);
 			if (!results.empty()) {
 				std::cout << "Barcode found at " << angle << " degrees rotation." << std::endl;
 				break;
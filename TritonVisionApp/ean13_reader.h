@@ -116,6 +116,10 @@ struct PartialResult
 	PartialResult() { txt.reserve(14); }
 };
 
-std::set<std::string> DoDecode(const std::vector<uint8_t>& image, int width, int height);
+// rowStep > 1 scans only every rowStep-th row
+std::set<std::string> DoDecode(const std::vector<uint8_t>& image, int width, int height, int rowStep = 1);
 
 std::string DecodeWithRotation(const cv::Mat buffer_image);
+
+// maxRotations limits the 90 degree rotations tried after the upright scan fails
+std::string DecodeBinaryWithRotation(const std::vector<uint8_t>& image, int width, int height, int rowStep = 1, int maxRotations = 3);
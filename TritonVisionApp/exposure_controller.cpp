@@ -0,0 +1,185 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file exposure_controller.cpp
+* @brief Tunes exposure time and gain from the contrast and the decode results of the barcode regions
+* @date 2026/10
+*/
+
+#include "./exposure_controller.h"
+
+#include <algorithm>
+#include <cmath>
+
+void ExposureController::SetSettings(const ExposureSettings& settings) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    settings_ = settings;
+    if (!settings_.enabled)
+        is_attached_ = false;
+    ClearWindow_();
+}
+
+ExposureSettings ExposureController::GetSettings() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return settings_;
+}
+
+bool ExposureController::IsEnabled() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return settings_.enabled;
+}
+
+// GainAuto is missing on some models, gain is then left to the camera
+bool ExposureController::Attach(INodeAccess& nodes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    is_attached_ = false;
+    if (!nodes.SetEnumeration(nodes.Resolve("ExposureAuto"), "Off"))
+        return false;
+    nodes.SetEnumeration(nodes.Resolve("GainAuto"), "Off");
+    exposure_node_ = nodes.Resolve(kExposureNode_);
+    gain_node_ = nodes.Resolve(kGainNode_);
+    stats_.exposure_us = nodes.GetFloat(exposure_node_);
+    stats_.gain_db = nodes.GetFloat(gain_node_);
+    settle_ = 0;
+    ClearWindow_();
+    is_attached_ = true;
+    return true;
+}
+
+RegionLevels ExposureController::Measure(const cv::Mat& gray) const {
+    RegionLevels levels;
+    if (gray.empty() || gray.type() != CV_8UC1)
+        return levels;
+
+    int histogram[256] = {};
+    for (int y = 0; y < gray.rows; y++) {
+        const uint8_t* row = gray.ptr<uint8_t>(y);
+        for (int x = 0; x < gray.cols; x++)
+            histogram[row[x]]++;
+    }
+
+    const int total = gray.rows * gray.cols;
+    const int dark_count = (int)(total * kDarkPercentile_);
+    const int bright_count = (int)(total * kBrightPercentile_);
+    int count = 0;
+    bool has_dark = false;
+    for (int level = 0; level < 256; level++) {
+        count += histogram[level];
+        if (!has_dark && count > dark_count) {
+            levels.dark = level;
+            has_dark = true;
+        }
+        if (count > bright_count) {
+            levels.bright = level;
+            break;
+        }
+    }
+
+    int saturated = 0;
+    for (int level = kSaturatedLevel_; level < 256; level++)
+        saturated += histogram[level];
+    levels.saturated = (double)saturated / total;
+    return levels;
+}
+
+void ExposureController::OnRegion(const cv::Mat& gray, const bool is_decoded) {
+    RegionLevels levels = Measure(gray);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!is_attached_ || settle_ > 0)
+        return;
+    window_regions_++;
+    window_decoded_ += is_decoded ? 1 : 0;
+    window_dark_ += levels.dark;
+    window_bright_ += levels.bright;
+    window_saturated_ += levels.saturated;
+    stats_.regions++;
+    stats_.decoded += is_decoded ? 1 : 0;
+}
+
+bool ExposureController::OnFrame(INodeAccess& nodes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!is_attached_)
+        return false;
+    if (settle_ > 0) {
+        settle_--;
+        return false;
+    }
+    if (++window_frames_ < settings_.window_frames)
+        return false;
+    if (window_regions_ == 0) {
+        ClearWindow_();
+        return false;
+    }
+
+    stats_.dark_level = window_dark_ / window_regions_;
+    stats_.bright_level = window_bright_ / window_regions_;
+    stats_.contrast = stats_.bright_level - stats_.dark_level;
+    stats_.saturated = window_saturated_ / window_regions_;
+    stats_.success_rate = (double)window_decoded_ / window_regions_;
+    ClearWindow_();
+
+    // Scans that succeed are not worth a change that could upset them
+    if (stats_.success_rate >= settings_.success_hold)
+        return false;
+    double ratio = 1.0;
+    if (stats_.saturated > kMaxSaturated_)
+        ratio = kSaturatedStep_;
+    else if (std::abs(stats_.bright_level - settings_.target_level) > settings_.tolerance)
+        ratio = std::min(std::max(settings_.target_level / std::max(stats_.bright_level, 1.0), kMinStep_), kMaxStep_);
+    else
+        return false;
+    return Apply_(nodes, ratio);
+}
+
+// Brightness is taken to follow exposure time times linear gain
+bool ExposureController::Apply_(INodeAccess& nodes, const double ratio) {
+    double node_min, node_max;
+    nodes.GetFloatRange(exposure_node_, node_min, node_max);
+    const double min_exposure = std::max(settings_.min_exposure_us, node_min);
+    const double max_exposure = std::max(std::min(settings_.max_exposure_us, node_max), min_exposure);
+    nodes.GetFloatRange(gain_node_, node_min, node_max);
+    const double min_gain = std::max(settings_.min_gain_db, node_min);
+    const double max_gain = std::max(std::min(settings_.max_gain_db, node_max), min_gain);
+
+    double exposure = std::min(std::max(stats_.exposure_us, min_exposure), max_exposure);
+    double gain = std::min(std::max(stats_.gain_db, min_gain), max_gain);
+    double remaining_db = 20.0 * std::log10(ratio);
+    if (ratio > 1.0) {
+        double new_exposure = std::min(exposure * ratio, max_exposure);
+        remaining_db -= 20.0 * std::log10(new_exposure / exposure);
+        exposure = new_exposure;
+        gain = std::min(gain + remaining_db, max_gain);
+    }
+    else {
+        double new_gain = std::max(gain + remaining_db, min_gain);
+        remaining_db -= new_gain - gain;
+        gain = new_gain;
+        exposure = std::max(exposure * std::pow(10.0, remaining_db / 20.0), min_exposure);
+    }
+
+    // Nothing left to change at the limits
+    if (std::abs(exposure - stats_.exposure_us) < 1.0 && std::abs(gain - stats_.gain_db) < 0.01)
+        return false;
+
+    nodes.SetFloat(exposure_node_, exposure);
+    stats_.exposure_us = exposure;
+    nodes.SetFloat(gain_node_, gain);
+    stats_.gain_db = gain;
+    stats_.adjustments++;
+    settle_ = settings_.settle_frames;
+    return true;
+}
+
+void ExposureController::ClearWindow_() {
+    window_frames_ = 0;
+    window_regions_ = 0;
+    window_decoded_ = 0;
+    window_dark_ = 0.0;
+    window_bright_ = 0.0;
+    window_saturated_ = 0.0;
+}
+
+ExposureStats ExposureController::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
@@ -0,0 +1,111 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/**
+* @file exposure_controller.h
+* @brief Tunes exposure time and gain from the contrast and the decode results of the barcode regions
+* @date 2026/10
+*/
+
+#ifndef EXPOSURE_CONTROLLER_H_
+#define EXPOSURE_CONTROLLER_H_
+
+#include <cstdint>
+#include <mutex>
+
+#include <opencv2/opencv.hpp>
+
+#include "./node_access.h"
+
+struct ExposureSettings {
+    bool enabled = false;
+    double min_exposure_us = 100.0;
+    double max_exposure_us = 20000.0; // Also limited by what ExposureTime accepts at the frame rate
+    double min_gain_db = 0.0;
+    double max_gain_db = 12.0;
+    double target_level = 200.0;      // Bright end of the bar/space histogram to aim for, 0..255
+    double tolerance = 25.0;          // Levels around target_level that are left alone
+    double success_hold = 0.9;        // Decode rate from which the settings are kept as they are
+    int window_frames = 5;            // Frames measured before each step
+    int settle_frames = 3;            // Frames skipped after a write, until the new values are in the image
+};
+
+struct ExposureStats {
+    double exposure_us = 0.0;  // Values in effect
+    double gain_db = 0.0;
+    double dark_level = 0.0;   // Of the last measured window, 0..255
+    double bright_level = 0.0;
+    double contrast = 0.0;     // bright_level - dark_level
+    double saturated = 0.0;    // Share of clipped pixels
+    double success_rate = 0.0; // Decoded regions per measured region
+    uint64_t regions = 0;
+    uint64_t decoded = 0;
+    uint64_t adjustments = 0;
+};
+
+// Bar/space levels of one gray region
+struct RegionLevels {
+    double dark = 0.0;      // kDarkPercentile of the pixels
+    double bright = 0.0;    // kBrightPercentile of the pixels
+    double saturated = 0.0; // Share of pixels at kSaturatedLevel or above
+};
+
+// Closed loop over ExposureTime and Gain. The regions the decoder ran on are measured
+// for a few frames; when the decode rate stays below success_hold the image is made
+// darker while bars or spaces clip, otherwise brightness is moved towards target_level.
+// Exposure time is raised before gain and gain lowered before exposure time, both
+// within the configured limits. Only parameters go through INodeAccess, so the loop
+// runs against a MemoryNodeAccess and synthetic regions as well as against a camera.
+// Attach() and OnFrame() must not run concurrently, everything else may be called
+// from any thread.
+class ExposureController {
+public:
+    void SetSettings(const ExposureSettings& settings);
+    ExposureSettings GetSettings();
+    bool IsEnabled();
+
+    // Turns the automatic exposure and gain of the camera off and takes over the values
+    // in effect. Returns false when ExposureAuto cannot be turned off. OnFrame() must be
+    // given the same nodes, their handles are resolved here.
+    bool Attach(INodeAccess& nodes);
+
+    RegionLevels Measure(const cv::Mat& gray) const;
+    // A region the decoder ran on this frame
+    void OnRegion(const cv::Mat& gray, const bool is_decoded);
+    // Once per frame. Returns true when new values were written.
+    bool OnFrame(INodeAccess& nodes);
+
+    ExposureStats GetStats();
+
+private:
+    bool Apply_(INodeAccess& nodes, const double ratio);
+    void ClearWindow_();
+
+    std::mutex mutex_;
+    ExposureSettings settings_;
+    ExposureStats stats_;
+    bool is_attached_ = false;
+    int settle_ = 0;
+
+    // Measurements since the last step
+    int window_frames_ = 0;
+    int window_regions_ = 0;
+    int window_decoded_ = 0;
+    double window_dark_ = 0.0;
+    double window_bright_ = 0.0;
+    double window_saturated_ = 0.0;
+
+    NodeHandle exposure_node_ = -1;
+    NodeHandle gain_node_ = -1;
+
+    const char* kExposureNode_ = "ExposureTime";
+    const char* kGainNode_ = "Gain";
+    const double kDarkPercentile_ = 0.1;
+    const double kBrightPercentile_ = 0.9;
+    const int kSaturatedLevel_ = 250;
+    const double kMaxSaturated_ = 0.02;  // Above this share of clipped pixels the image is made darker
+    const double kSaturatedStep_ = 0.7;
+    const double kMinStep_ = 0.5;        // Exposure change of one step, as a brightness ratio
+    const double kMaxStep_ = 2.0;
+};
+
+#endif
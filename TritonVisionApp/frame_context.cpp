@@ -0,0 +1,330 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file frame_context.cpp
+* @brief Per-frame cache of the image representations derived from one camera buffer
+* @date 2026/10
+*/
+
+#include "./frame_context.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+static bool IsBayer(const uint64_t pixel_format) {
+    return pixel_format == BayerRG8 || pixel_format == BayerBG8 || pixel_format == BayerGR8 || pixel_format == BayerGB8;
+}
+
+// Luminance straight from the Bayer mosaic. Every 2x2 window holds one R, two G
+// and one B sample whatever its phase, so averaging the window at each pixel gives
+// a full-resolution gray image without demosaicing. At the last row/column the
+// window is mirrored inwards to keep the same phase.
+static void BayerToGray(const cv::Mat& raw, const cv::Rect& region, cv::Mat& dst) {
+    for (int y = 0; y < region.height; y++) {
+        int y0 = region.y + y;
+        int y1 = (y0 + 1 < raw.rows) ? y0 + 1 : y0 - 1;
+        const uint8_t* row0 = raw.ptr<uint8_t>(y0);
+        const uint8_t* row1 = raw.ptr<uint8_t>(y1);
+        uint8_t* out = dst.ptr<uint8_t>(y);
+        for (int x = 0; x < region.width; x++) {
+            int x0 = region.x + x;
+            int x1 = (x0 + 1 < raw.cols) ? x0 + 1 : x0 - 1;
+            out[x] = (uint8_t)((row0[x0] + row0[x1] + row1[x0] + row1[x1] + 2) >> 2);
+        }
+    }
+}
+
+// Converts raw pixels of a supported format to BGR. Returns false for other formats.
+static bool RawToBgr(const uint64_t pixel_format, const cv::Mat& raw, cv::Mat& dst) {
+    // Note: OpenCV names Bayer patterns after the second row, so GenICam BayerRG is cv::COLOR_BayerBG
+    switch (pixel_format) {
+    case BGR8:
+        raw.copyTo(dst);
+        return true;
+    case RGB8:
+        cv::cvtColor(raw, dst, cv::COLOR_RGB2BGR);
+        return true;
+    case Mono8:
+        cv::cvtColor(raw, dst, cv::COLOR_GRAY2BGR);
+        return true;
+    case BayerRG8:
+        cv::cvtColor(raw, dst, cv::COLOR_BayerBG2BGR);
+        return true;
+    case BayerBG8:
+        cv::cvtColor(raw, dst, cv::COLOR_BayerRG2BGR);
+        return true;
+    case BayerGR8:
+        cv::cvtColor(raw, dst, cv::COLOR_BayerGB2BGR);
+        return true;
+    case BayerGB8:
+        cv::cvtColor(raw, dst, cv::COLOR_BayerGR2BGR);
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Builds one BGR pixel per sampled 2x2 Bayer cell (R, mean of both G, B).
+// Only the sampled cells are read, so the cost follows the size of dst.
+static void BayerToBgrDecimated(const uint64_t pixel_format, const cv::Mat& raw, const int decimation, cv::Mat& dst) {
+    // Position of the red sample inside a cell, blue is on the opposite corner
+    int red_x = (pixel_format == BayerGR8 || pixel_format == BayerBG8) ? 1 : 0;
+    int red_y = (pixel_format == BayerGB8 || pixel_format == BayerBG8) ? 1 : 0;
+    int last_cell_y = (raw.rows - 2) & ~1;
+    int last_cell_x = (raw.cols - 2) & ~1;
+
+    for (int y = 0; y < dst.rows; y++) {
+        int cell_y = std::min((y * decimation) & ~1, last_cell_y);
+        const uint8_t* red_row = raw.ptr<uint8_t>(cell_y + red_y);
+        const uint8_t* blue_row = raw.ptr<uint8_t>(cell_y + 1 - red_y);
+        uint8_t* out = dst.ptr<uint8_t>(y);
+        for (int x = 0; x < dst.cols; x++) {
+            int cell_x = std::min((x * decimation) & ~1, last_cell_x);
+            out[3 * x + 0] = blue_row[cell_x + 1 - red_x];
+            out[3 * x + 1] = (uint8_t)((red_row[cell_x + 1 - red_x] + blue_row[cell_x + red_x] + 1) >> 1);
+            out[3 * x + 2] = red_row[cell_x + red_x];
+        }
+    }
+}
+
+// One gray pixel per sampled 2x2 Bayer cell, the mean of its four samples as in BayerToGray()
+static void BayerToGrayDecimated(const cv::Mat& raw, const int decimation, cv::Mat& dst) {
+    int last_cell_y = (raw.rows - 2) & ~1;
+    int last_cell_x = (raw.cols - 2) & ~1;
+
+    for (int y = 0; y < dst.rows; y++) {
+        int cell_y = std::min((y * decimation) & ~1, last_cell_y);
+        const uint8_t* row0 = raw.ptr<uint8_t>(cell_y);
+        const uint8_t* row1 = raw.ptr<uint8_t>(cell_y + 1);
+        uint8_t* out = dst.ptr<uint8_t>(y);
+        for (int x = 0; x < dst.cols; x++) {
+            int cell_x = std::min((x * decimation) & ~1, last_cell_x);
+            out[x] = (uint8_t)((row0[cell_x] + row0[cell_x + 1] + row1[cell_x] + row1[cell_x + 1] + 2) >> 2);
+        }
+    }
+}
+
+FrameContext::FrameContext(ImagePool& pool) : pool_(pool) {
+}
+
+void FrameContext::Reset(const uint8_t* data, const int width, const int height, const uint64_t pixel_format) {
+    data_ = data;
+    pixel_format_ = pixel_format;
+    width_ = width;
+    height_ = height;
+    has_bgr_ = false;
+    has_preview_ = false;
+    has_preview_gray_ = false;
+    has_gray_ = false;
+    gray_.release();
+    num_regions_ = 0;
+}
+
+int FrameContext::GetWidth() const {
+    return width_;
+}
+
+int FrameContext::GetHeight() const {
+    return height_;
+}
+
+cv::Mat FrameContext::RawView_() const {
+    if (data_ == nullptr)
+        throw std::runtime_error("The frame buffer was already released");
+    int type = (pixel_format_ == BGR8 || pixel_format_ == RGB8) ? CV_8UC3 : CV_8UC1;
+    return cv::Mat(height_, width_, type, (void*)data_);
+}
+
+const cv::Mat& FrameContext::GetBgr() {
+    if (has_bgr_)
+        return bgr_;
+    pool_.Reshape(bgr_, height_, width_, CV_8UC3);
+    has_bgr_ = true;
+    if (RawToBgr(pixel_format_, RawView_(), bgr_))
+        return bgr_;
+
+    // Other formats go through the Arena image factory. PFNC encodes the bits per pixel in bits 16-23.
+    size_t bits_per_pixel = (size_t)((pixel_format_ >> 16) & 0xFF);
+    Arena::IImage* pWrapped = Arena::ImageFactory::Create(data_, (size_t)width_ * height_ * bits_per_pixel / 8, (size_t)width_, (size_t)height_, pixel_format_);
+    Arena::IImage* pConverted = Arena::ImageFactory::Convert(pWrapped, BGR8);
+    pool_.NoteAllocation((size_t)width_ * height_ * 3);
+    cv::Mat((int)pConverted->GetHeight(), (int)pConverted->GetWidth(), CV_8UC3, (void*)pConverted->GetData()).copyTo(bgr_);
+    Arena::ImageFactory::Destroy(pConverted);
+    Arena::ImageFactory::Destroy(pWrapped);
+    return bgr_;
+}
+
+const cv::Mat& FrameContext::GetPreviewBgr(const int decimation) {
+    if (decimation <= 1)
+        return GetBgr();
+    if (has_preview_ && preview_decimation_ == decimation)
+        return preview_;
+
+    int preview_width = width_ / decimation;
+    int preview_height = height_ / decimation;
+    pool_.Reshape(preview_, preview_height, preview_width, CV_8UC3);
+    has_preview_ = true;
+    preview_decimation_ = decimation;
+
+    if (IsBayer(pixel_format_)) {
+        BayerToBgrDecimated(pixel_format_, RawView_(), decimation, preview_);
+    }
+    else if (pixel_format_ == BGR8 || pixel_format_ == RGB8 || pixel_format_ == Mono8) {
+        // Sample first, then convert only the samples
+        cv::Mat raw = RawView_();
+        pool_.Reshape(preview_scratch_, preview_height, preview_width, raw.type());
+        cv::resize(raw, preview_scratch_, preview_.size(), 0, 0, cv::INTER_NEAREST);
+        RawToBgr(pixel_format_, preview_scratch_, preview_);
+    }
+    else {
+        cv::resize(GetBgr(), preview_, preview_.size(), 0, 0, cv::INTER_AREA);
+    }
+    return preview_;
+}
+
+const cv::Mat& FrameContext::GetRegionBgr(const cv::Rect& region) {
+    Region& entry = FindRegion_(region);
+    if (entry.has_bgr)
+        return entry.bgr;
+
+    bool is_raw_supported = IsBayer(pixel_format_) || pixel_format_ == BGR8 || pixel_format_ == RGB8 || pixel_format_ == Mono8;
+    if (has_bgr_ || !is_raw_supported) {
+        entry.bgr = GetBgr()(region);
+    }
+    else if (IsBayer(pixel_format_)) {
+        // Demosaic a slightly larger, even-aligned block so that the Bayer phase is kept
+        // and the edge handling of cvtColor stays outside of the requested region
+        const int margin = 2;
+        int left = std::max(0, region.x - margin) & ~1;
+        int top = std::max(0, region.y - margin) & ~1;
+        int right = std::min(width_, region.x + region.width + margin);
+        int bottom = std::min(height_, region.y + region.height + margin);
+        cv::Rect block(left, top, right - left, bottom - top);
+        // The block shrinks at the frame edges and grows by one for odd positions, so the buffer
+        // is sized for the largest block of this region size and the block is converted into a view
+        pool_.Reshape(entry.bgr_buffer, region.height + 2 * margin + 2, region.width + 2 * margin + 2, CV_8UC3);
+        cv::Mat block_bgr = entry.bgr_buffer(cv::Rect(0, 0, block.width, block.height));
+        RawToBgr(pixel_format_, RawView_()(block), block_bgr);
+        entry.bgr = block_bgr(cv::Rect(region.x - left, region.y - top, region.width, region.height));
+    }
+    else {
+        pool_.Reshape(entry.bgr_buffer, region.height, region.width, CV_8UC3);
+        RawToBgr(pixel_format_, RawView_()(region), entry.bgr_buffer);
+        entry.bgr = entry.bgr_buffer;
+    }
+    entry.has_bgr = true;
+    return entry.bgr;
+}
+
+const cv::Mat& FrameContext::GetGray() {
+    if (has_gray_)
+        return gray_;
+    if (pixel_format_ == Mono8) {
+        gray_ = RawView_();
+    }
+    else if (IsBayer(pixel_format_)) {
+        pool_.Reshape(gray_buffer_, height_, width_, CV_8UC1);
+        BayerToGray(RawView_(), cv::Rect(0, 0, width_, height_), gray_buffer_);
+        gray_ = gray_buffer_;
+    }
+    else {
+        pool_.Reshape(gray_buffer_, height_, width_, CV_8UC1);
+        cv::cvtColor(GetBgr(), gray_buffer_, cv::COLOR_BGR2GRAY);
+        gray_ = gray_buffer_;
+    }
+    has_gray_ = true;
+    return gray_;
+}
+
+const cv::Mat& FrameContext::GetPreviewGray(const int decimation) {
+    if (decimation <= 1)
+        return GetGray();
+    if (has_preview_gray_ && preview_gray_decimation_ == decimation)
+        return preview_gray_;
+
+    int preview_width = width_ / decimation;
+    int preview_height = height_ / decimation;
+    pool_.Reshape(preview_gray_, preview_height, preview_width, CV_8UC1);
+    has_preview_gray_ = true;
+    preview_gray_decimation_ = decimation;
+
+    if (IsBayer(pixel_format_))
+        BayerToGrayDecimated(RawView_(), decimation, preview_gray_);
+    else if (pixel_format_ == Mono8)
+        cv::resize(RawView_(), preview_gray_, preview_gray_.size(), 0, 0, cv::INTER_NEAREST);
+    else
+        cv::cvtColor(GetPreviewBgr(decimation), preview_gray_, cv::COLOR_BGR2GRAY);
+    return preview_gray_;
+}
+
+FrameContext::Region& FrameContext::FindRegion_(const cv::Rect& region) {
+    for (size_t i = 0; i < num_regions_; i++) {
+        if (regions_[i].rect == region)
+            return regions_[i];
+    }
+    if (num_regions_ == regions_.size())
+        regions_.emplace_back();
+    Region& entry = regions_[num_regions_++];
+    entry.rect = region;
+    entry.bgr.release();
+    entry.has_bgr = false;
+    entry.gray.release();
+    entry.has_gray = false;
+    entry.has_binary = false;
+    return entry;
+}
+
+const cv::Mat& FrameContext::GetRegionGray(const cv::Rect& region) {
+    Region& entry = FindRegion_(region);
+    if (entry.has_gray)
+        return entry.gray;
+
+    if (has_gray_ || pixel_format_ == Mono8) {
+        entry.gray = GetGray()(region);
+    }
+    else if (IsBayer(pixel_format_)) {
+        // Only the region is read from the raw buffer, the frame is never demosaiced for decoding
+        pool_.Reshape(entry.gray_buffer, region.height, region.width, CV_8UC1);
+        BayerToGray(RawView_(), region, entry.gray_buffer);
+        entry.gray = entry.gray_buffer;
+    }
+    else {
+        pool_.Reshape(entry.gray_buffer, region.height, region.width, CV_8UC1);
+        cv::cvtColor(GetBgr()(region), entry.gray_buffer, cv::COLOR_BGR2GRAY);
+        entry.gray = entry.gray_buffer;
+    }
+    entry.has_gray = true;
+    return entry.gray;
+}
+
+const std::vector<uint8_t>& FrameContext::GetRegionBinary(const cv::Rect& region) {
+    Region& entry = FindRegion_(region);
+    if (entry.has_binary)
+        return entry.binary;
+
+    const cv::Mat& gray = GetRegionGray(region);
+    entry.binary.resize((size_t)region.width * region.height);
+    cv::Mat binary(region.height, region.width, CV_8UC1, entry.binary.data());
+    cv::threshold(gray, binary, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+    entry.has_binary = true;
+    return entry.binary;
+}
+
+void FrameContext::Detach() {
+    // Only Mono8 gray views point into the raw buffer, every other view is converted into a buffer of its own
+    for (size_t i = 0; i < num_regions_; i++) {
+        Region& entry = regions_[i];
+        if (!entry.has_gray || pixel_format_ != Mono8 || entry.gray.data == entry.gray_buffer.data)
+            continue;
+        pool_.Reshape(entry.gray_buffer, entry.rect.height, entry.rect.width, CV_8UC1);
+        entry.gray.copyTo(entry.gray_buffer);
+        entry.gray = entry.gray_buffer;
+    }
+    // The full-frame Mono8 gray is only derived for frames no larger than the preview
+    if (has_gray_ && gray_.data != gray_buffer_.data) {
+        pool_.Reshape(gray_buffer_, height_, width_, CV_8UC1);
+        gray_.copyTo(gray_buffer_);
+        gray_ = gray_buffer_;
+    }
+    data_ = nullptr;
+}
@@ -0,0 +1,106 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/**
+* @file frame_context.h
+* @brief Per-frame cache of the image representations derived from one camera buffer
+* @date 2026/10
+*/
+
+#ifndef FRAME_CONTEXT_H_
+#define FRAME_CONTEXT_H_
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "Arena/ArenaApi.h"
+#include "./image_pool.h"
+
+// Wraps the raw buffer of the current frame and derives each representation
+// (full BGR, decimated BGR or gray preview, per-region BGR, full gray, per-region gray,
+// per-region binarized) the first time it is
+// asked for. Display, overlay drawing and every decoder of the frame share the results.
+// The wrapped buffer must not be requeued before Detach() has been called.
+class FrameContext {
+public:
+    explicit FrameContext(ImagePool& pool);
+
+    // Starts a new frame of packed pixels in the given PfncFormat. Cached views of the
+    // previous frame are invalidated, their buffers kept.
+    void Reset(const uint8_t* data, const int width, const int height, const uint64_t pixel_format);
+
+    int GetWidth() const;
+    int GetHeight() const;
+
+    // Full frame in BGR, converted once per frame
+    const cv::Mat& GetBgr();
+
+    // Full frame reduced by the given factor in both directions. Bayer buffers are
+    // sampled cell by cell, so the cost scales with the preview, not the sensor.
+    const cv::Mat& GetPreviewBgr(const int decimation);
+
+    // BGR of the given region, converted from the raw buffer without touching the rest of the frame
+    const cv::Mat& GetRegionBgr(const cv::Rect& region);
+
+    // Full frame in grayscale, converted once per frame
+    const cv::Mat& GetGray();
+
+    // GetPreviewBgr() on one channel. Mono and Bayer buffers are sampled directly.
+    const cv::Mat& GetPreviewGray(const int decimation);
+
+    // Grayscale of the given region. Uses the full-frame gray when it already exists.
+    // Mono and Bayer buffers are read directly, so no BGR conversion is needed for decoding.
+    const cv::Mat& GetRegionGray(const cv::Rect& region);
+
+    // Otsu-binarized region, flattened row by row as expected by DoDecode()
+    const std::vector<uint8_t>& GetRegionBinary(const cv::Rect& region);
+
+    // Makes every view derived so far independent of the raw buffer, so the buffer can be
+    // requeued while the views are still used. Views that need the raw buffer and were not
+    // derived before throw until the next Reset().
+    void Detach();
+
+private:
+    struct Region {
+        cv::Rect rect;
+        cv::Mat bgr;         // Either a view of the full-frame BGR or of bgr_buffer
+        cv::Mat bgr_buffer;
+        bool has_bgr = false;
+        cv::Mat gray;        // Either a view of a full-frame image or gray_buffer
+        cv::Mat gray_buffer;
+        bool has_gray = false;
+        std::vector<uint8_t> binary;
+        bool has_binary = false;
+    };
+
+    Region& FindRegion_(const cv::Rect& region);
+    cv::Mat RawView_() const;
+
+    ImagePool& pool_;
+    const uint8_t* data_ = nullptr;
+    uint64_t pixel_format_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+
+    cv::Mat bgr_;
+    bool has_bgr_ = false;
+    cv::Mat preview_;
+    cv::Mat preview_scratch_;
+    int preview_decimation_ = 1;
+    bool has_preview_ = false;
+    cv::Mat preview_gray_;
+    int preview_gray_decimation_ = 1;
+    bool has_preview_gray_ = false;
+    cv::Mat gray_;        // Either a view of the raw buffer or gray_buffer_
+    cv::Mat gray_buffer_;
+    bool has_gray_ = false;
+
+    // Entries are reused across frames so their buffers are too.
+    // A deque keeps returned references valid when a region is added.
+    std::deque<Region> regions_;
+    size_t num_regions_ = 0;
+};
+
+#endif
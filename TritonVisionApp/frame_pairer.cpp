@@ -0,0 +1,140 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file frame_pairer.cpp
+* @brief Pairs the DNN output of a frame with the RAW image that the IMX500 computed it on
+* @date 2026/10
+*/
+
+#include "./frame_pairer.h"
+
+#include <algorithm>
+#include <cstring>
+
+void FramePairer::SetSettings(const PairingSettings& settings) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    settings_ = settings;
+    settings_.history_depth = std::max(0, settings_.history_depth);
+    history_.resize(settings_.history_depth);
+    for (HistoryFrame& entry : history_) {
+        entry.has_frame = false;
+        entry.has_pixels = false;
+    }
+    next_slot_ = 0;
+}
+
+PairingSettings FramePairer::GetSettings() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return settings_;
+}
+
+void FramePairer::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_ = PairingStats();
+    for (HistoryFrame& entry : history_) {
+        entry.has_frame = false;
+        entry.has_pixels = false;
+        entry.frame_count = -1;
+        entry.frame_id = 0;
+    }
+    next_slot_ = 0;
+}
+
+FramePairer::Result FramePairer::Pair(const uint64_t frame_id, const uint64_t timestamp_ns, const int input_frame_count, const int output_frame_count, const HistoryFrame*& frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frame = nullptr;
+    stats_.frames++;
+
+    // 255 marks software standby, such counters say nothing about the lag
+    bool has_counts = (input_frame_count >= 0 && input_frame_count < kFrameCountModulo_ && output_frame_count >= 0 && output_frame_count < kFrameCountModulo_);
+    int lag = 0;
+    if (settings_.offset >= 0)
+        lag = settings_.offset;
+    else if (has_counts)
+        lag = (input_frame_count - output_frame_count + kFrameCountModulo_) % kFrameCountModulo_;
+    stats_.offset = lag;
+
+    if (lag == 0) {
+        stats_.same_frame++;
+        return kCurrent;
+    }
+
+    // Newest first. The frame_count wraps every 255 frames, the age limit keeps an old lap from matching.
+    uint64_t max_age_ns = (uint64_t)settings_.max_age_ms * 1000000;
+    for (size_t i = 1; i <= history_.size(); i++) {
+        const HistoryFrame& entry = history_[(next_slot_ + history_.size() - i) % history_.size()];
+        if (entry.has_frame == false || entry.timestamp_ns > timestamp_ns || timestamp_ns - entry.timestamp_ns > max_age_ns)
+            continue;
+        bool is_match = (settings_.offset < 0) ? (entry.frame_count == output_frame_count) : (entry.frame_id + lag == frame_id);
+        if (is_match) {
+            frame = &entry;
+            if (entry.has_pixels == false)
+                break;
+            stats_.from_history++;
+            return kHistory;
+        }
+    }
+    stats_.unpaired++;
+    return kMissing;
+}
+
+void FramePairer::Push(const RawFrame& raw, const int input_frame_count, const ROI& raw_roi, const ROI& dnn_roi, const uint64_t roi_ticket, const ROI& window) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (history_.empty())
+        return;
+
+    HistoryFrame& entry = history_[next_slot_];
+    next_slot_ = (next_slot_ + 1) % history_.size();
+    entry.frame_id = raw.frame_id;
+    entry.timestamp_ns = raw.timestamp_ns;
+    entry.frame_count = input_frame_count;
+    entry.dnn_roi = dnn_roi;
+    entry.roi_ticket = roi_ticket;
+    entry.pixel_format = raw.pixel_format;
+    entry.has_frame = true;
+    entry.has_pixels = false;
+    if (!NeedsPixels_() || window.width <= 0 || window.height <= 0)
+        return;
+
+    // Bits per pixel are held in bits 16-23 of the PfncFormat
+    int bits_per_pixel = (int)((raw.pixel_format >> 16) & 0xFF);
+    int left = 0, top = 0, right = raw.width, bottom = raw.height;
+    // Only whole-byte pixels can be cut, and only when the RAW window is known to be the image
+    if (bits_per_pixel % 8 == 0 && raw_roi.width == raw.width && raw_roi.height == raw.height) {
+        // Even offsets keep the Bayer phase of the cut
+        left = std::max(window.offset_x - raw_roi.offset_x, 0) & ~1;
+        top = std::max(window.offset_y - raw_roi.offset_y, 0) & ~1;
+        right = std::min(window.offset_x + window.width - raw_roi.offset_x, raw.width);
+        bottom = std::min(window.offset_y + window.height - raw_roi.offset_y, raw.height);
+        if (right <= left || bottom <= top)
+            return;
+    }
+
+    entry.width = right - left;
+    entry.height = bottom - top;
+    entry.raw_roi = { raw_roi.id, raw_roi.offset_x + left, raw_roi.offset_y + top, entry.width, entry.height };
+    size_t src_stride = (size_t)raw.width * bits_per_pixel / 8;
+    size_t dst_stride = (size_t)entry.width * bits_per_pixel / 8;
+    entry.raw.resize(dst_stride * entry.height);
+    if (dst_stride == src_stride) {
+        memcpy(entry.raw.data(), raw.data + top * src_stride, dst_stride * entry.height);
+    }
+    else {
+        const uint8_t* src = raw.data + top * src_stride + (size_t)left * bits_per_pixel / 8;
+        for (int y = 0; y < entry.height; y++)
+            memcpy(entry.raw.data() + y * dst_stride, src + y * src_stride, dst_stride);
+    }
+    entry.has_pixels = true;
+    stats_.history_copies++;
+}
+
+PairingStats FramePairer::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+bool FramePairer::NeedsPixels_() const {
+    if (settings_.offset >= 0)
+        return settings_.offset > 0;
+    return stats_.offset > 0;
+}
@@ -0,0 +1,93 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/**
+* @file frame_pairer.h
+* @brief Pairs the DNN output of a frame with the RAW image that the IMX500 computed it on
+* @date 2026/10
+*/
+
+#ifndef FRAME_PAIRER_H_
+#define FRAME_PAIRER_H_
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "./common.h"
+#include "./frame_source.h"
+
+struct PairingSettings {
+    int offset = -1;          // Frames the output tensor lags the RAW image, -1 follows the tensor frame_count
+    int history_depth = 4;    // Earlier RAW frames kept for pairing, 0 always pairs with the current frame
+    int max_age_ms = 500;     // Older history frames are never paired
+};
+
+struct PairingStats {
+    uint64_t frames = 0;         // Output tensors paired or not
+    uint64_t same_frame = 0;     // Computed on the RAW image of their own frame
+    uint64_t from_history = 0;   // Computed on an earlier RAW image that was still in the history
+    uint64_t unpaired = 0;       // Their RAW image was not in the history
+    uint64_t history_copies = 0; // RAW images copied into the history
+    int offset = 0;              // Last lag in frames
+};
+
+// One RAW image kept after its buffer went back to the camera
+struct HistoryFrame {
+    uint64_t frame_id = 0;
+    uint64_t timestamp_ns = 0;  // Device clock
+    int frame_count = -1;       // Input tensor frame_count, -1 without tensors
+    ROI dnn_roi = {};           // DNN ROI the frame was inferred on, the boxes of its output are relative to it
+    uint64_t roi_ticket = 0;    // ROI switch in effect for the frame
+    bool has_frame = false;     // The fields above are set, the pixels only with has_pixels
+    int width = 0;              // Of the kept pixels, see Push()
+    int height = 0;
+    uint64_t pixel_format = 0;
+    ROI raw_roi = {};           // Sensor window of the kept pixels
+    bool has_pixels = false;
+    std::vector<uint8_t> raw;   // Reused, so a steady history does not allocate
+};
+
+// The chunk of a frame carries the input tensor of that frame but the output tensor of
+// whatever inference finished last, so at speed the boxes may belong to an earlier image.
+// The pairer keeps a short ring of earlier frames and finds the one the output was
+// computed on: by the tensor frame_count when the offset follows the tensors, else by
+// frame id. Pixels are only copied into the ring while the output is known to lag, so
+// a camera whose outputs arrive with their own frame pays nothing but the bookkeeping;
+// the first frames after a lag appears are counted as unpaired.
+class FramePairer {
+public:
+    enum Result {
+        kCurrent,  // The current RAW image
+        kHistory,  // An earlier RAW image, see Pair()
+        kMissing,  // An earlier RAW image that is no longer, or never was, in the history
+    };
+
+    void SetSettings(const PairingSettings& settings);
+    PairingSettings GetSettings();
+    // Forgets the history, for a new stream
+    void Reset();
+
+    // Called once per frame with tensors, before Push() of that frame. frame points into the
+    // history for kHistory, and for kMissing when the frame is still known but its pixels
+    // were not kept. It stays valid until the next Push() or Reset().
+    Result Pair(const uint64_t frame_id, const uint64_t timestamp_ns, const int input_frame_count, const int output_frame_count, const HistoryFrame*& frame);
+    // Adds the current frame to the history, its pixels only when a lag is expected. Only the
+    // part of the RAW image inside window (sensor coordinates) is kept, the boxes of the DNN
+    // cannot lie elsewhere. An empty window keeps no pixels.
+    void Push(const RawFrame& raw, const int input_frame_count, const ROI& raw_roi, const ROI& dnn_roi, const uint64_t roi_ticket, const ROI& window);
+
+    PairingStats GetStats();
+
+private:
+    bool NeedsPixels_() const;
+
+    std::mutex mutex_;
+    PairingSettings settings_;
+    PairingStats stats_;
+    std::vector<HistoryFrame> history_;
+    size_t next_slot_ = 0;
+
+    const int kFrameCountModulo_ = 255;
+};
+
+#endif
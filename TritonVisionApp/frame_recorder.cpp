@@ -0,0 +1,420 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file frame_recorder.cpp
+* @brief Append-only recording of raw frames and DNN chunk data, and zero-copy reading of it
+* @date 2026/10
+*/
+
+#include "./frame_recorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static std::string SegmentPath(const std::string& directory, const uint32_t segment) {
+    char name[32];
+    snprintf(name, sizeof(name), "segment_%04u.tvs", segment);
+    return (std::filesystem::path(directory) / name).string();
+}
+
+static bool WriteWholeFile(const std::string& path, const void* data, const size_t size) {
+    std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+    if (!stream.is_open())
+        return false;
+    if (size > 0)
+        stream.write((const char*)data, (std::streamsize)size);
+    return stream.good();
+}
+
+FrameRecorder::FrameRecorder() {
+}
+
+FrameRecorder::~FrameRecorder() {
+    Stop();
+}
+
+bool FrameRecorder::Start(const std::string& directory, const void* fpk_info, const size_t fpk_info_size, const uint8_t* labels, const size_t labels_size) {
+    if (is_recording_)
+        return false;
+    // Joins the writer of a recording that stopped on its own
+    Stop();
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error)
+        return false;
+    std::filesystem::path root(directory);
+    if (!WriteWholeFile((root / "fpk_info.dat").string(), fpk_info, fpk_info_size))
+        return false;
+    if (labels != nullptr && labels_size > 0 && !WriteWholeFile((root / "label.txt").string(), labels, labels_size))
+        return false;
+    index_.open((root / "index.tvi").string(), std::ios::binary | std::ios::trunc);
+    if (!index_.is_open())
+        return false;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (std::vector<uint8_t>* slot : queue_)
+            free_.push_back(slot);
+        queue_.clear();
+        queued_bytes_ = 0;
+        stop_ = false;
+        next_frame_number_ = 0;
+    }
+    directory_ = directory;
+    segment_number_ = 0;
+    segment_offset_ = 0;
+    has_segment_ = false;
+    has_failed_ = false;
+    recorded_ = 0;
+    dropped_ = 0;
+    written_bytes_ = 0;
+
+    is_recording_ = true;
+    writer_ = std::thread(&FrameRecorder::WriterLoop_, this);
+    return true;
+}
+
+void FrameRecorder::Stop() {
+    if (!writer_.joinable())
+        return;
+    is_recording_ = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_one();
+    writer_.join();
+}
+
+bool FrameRecorder::IsRecording() const {
+    return is_recording_;
+}
+
+// Called on the capture thread while the frame buffer is still owned by it
+bool FrameRecorder::Record(const RawFrame& frame, const int roi_id, const ROI& roi) {
+    if (is_recording_ != true || frame.data == nullptr)
+        return false;
+
+    // PFNC encodes the bits per pixel in bits 16-23 of the format
+    size_t raw_size = (size_t)frame.width * frame.height * ((frame.pixel_format >> 16) & 0xFF) / 8;
+    size_t used_size = sizeof(RecordHeader) + raw_size + frame.chunk_size;
+    size_t record_size = (used_size + kRecordAlignment - 1) / kRecordAlignment * kRecordAlignment;
+
+    std::vector<uint8_t>* slot;
+    uint64_t frame_number;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stop_ || queued_bytes_ + record_size > kMaxQueuedBytes_) {
+            dropped_++;
+            return false;
+        }
+        if (free_.empty()) {
+            slots_.emplace_back(new std::vector<uint8_t>());
+            slot = slots_.back().get();
+        }
+        else {
+            slot = free_.back();
+            free_.pop_back();
+        }
+        queued_bytes_ += record_size;
+        in_flight_++;
+        frame_number = next_frame_number_++;
+    }
+
+    RecordHeader header = {};
+    header.magic = kRecordMagic;
+    header.header_size = sizeof(RecordHeader);
+    header.frame_number = frame_number;
+    header.frame_id = frame.frame_id;
+    header.device_timestamp_ns = frame.timestamp_ns;
+    header.host_timestamp_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    header.pixel_format = frame.pixel_format;
+    header.width = frame.width;
+    header.height = frame.height;
+    header.raw_size = (uint32_t)raw_size;
+    header.chunk_size = (uint32_t)frame.chunk_size;
+    header.roi_id = roi_id;
+    header.roi_offset_x = roi.offset_x;
+    header.roi_offset_y = roi.offset_y;
+    header.roi_width = roi.width;
+    header.roi_height = roi.height;
+    if (frame.chunk != nullptr && frame.chunk_size >= sizeof(header.tensor_header))
+        memcpy(header.tensor_header, frame.chunk, sizeof(header.tensor_header));
+
+    // The slot keeps its capacity, so only the first frames of a session allocate
+    slot->resize(record_size);
+    uint8_t* data = slot->data();
+    memcpy(data, &header, sizeof(RecordHeader));
+    memcpy(data + sizeof(RecordHeader), frame.data, raw_size);
+    if (frame.chunk_size > 0)
+        memcpy(data + sizeof(RecordHeader) + raw_size, frame.chunk, frame.chunk_size);
+    memset(data + used_size, 0, record_size - used_size);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(slot);
+        in_flight_--;
+    }
+    cv_.notify_one();
+    return true;
+}
+
+const std::string& FrameRecorder::GetDirectory() const {
+    return directory_;
+}
+
+uint64_t FrameRecorder::GetRecordedCount() const {
+    return recorded_;
+}
+
+uint64_t FrameRecorder::GetDroppedCount() const {
+    return dropped_;
+}
+
+uint64_t FrameRecorder::GetWrittenBytes() const {
+    return written_bytes_;
+}
+
+// Drains the queue until Stop() is called and every frame taken by Record() is written.
+// The segment is only closed once no Record() call can queue to it any more.
+void FrameRecorder::WriterLoop_() {
+    while (true) {
+        std::vector<uint8_t>* slot;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return (stop_ && in_flight_ == 0) || !queue_.empty(); });
+            if (queue_.empty())
+                break;
+            slot = queue_.front();
+            queue_.pop_front();
+        }
+
+        Write_(*slot);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued_bytes_ -= slot->size();
+        free_.push_back(slot);
+    }
+
+    CloseSegment_();
+    index_.close();
+}
+
+void FrameRecorder::Write_(const std::vector<uint8_t>& record) {
+    if (!has_failed_ && (!has_segment_ || segment_offset_ + record.size() > kSegmentSize_)) {
+        CloseSegment_();
+        if (!OpenSegment_()) {
+            printf("Recording: couldn't create %s, recording stopped\n", segment_path_.c_str());
+            has_failed_ = true;
+            is_recording_ = false;
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+    }
+    if (has_failed_) {
+        dropped_++;
+        return;
+    }
+
+    IndexEntry entry = {};
+    entry.offset = segment_offset_;
+    entry.segment = segment_number_;
+    entry.record_size = (uint32_t)record.size();
+    entry.device_timestamp_ns = ((const RecordHeader*)record.data())->device_timestamp_ns;
+
+    segment_.write((const char*)record.data(), (std::streamsize)record.size());
+    if (!segment_.good()) {
+        // The frame number is already taken, so the index keeps the entry and the reader rejects it
+        printf("Recording: couldn't write frame to %s\n", segment_path_.c_str());
+        segment_.clear();
+        entry.record_size = 0;
+        dropped_++;
+    }
+    else {
+        recorded_++;
+        written_bytes_ += record.size();
+    }
+    segment_offset_ += record.size();
+
+    // Flushed per frame so that the recording stays readable if the application stops abruptly
+    index_.write((const char*)&entry, sizeof(entry));
+    index_.flush();
+}
+
+// Segments are created at full size, so appending never grows the file.
+// Returns false when the file cannot be created, e.g. when the disk is full.
+bool FrameRecorder::OpenSegment_() {
+    segment_path_ = SegmentPath(directory_, segment_number_);
+    {
+        std::ofstream create(segment_path_, std::ios::binary | std::ios::trunc);
+        if (!create.is_open())
+            return false;
+    }
+    std::error_code error;
+    std::filesystem::resize_file(segment_path_, kSegmentSize_, error);
+    if (error)
+        return false;
+    segment_.open(segment_path_, std::ios::in | std::ios::out | std::ios::binary);
+    if (!segment_.is_open())
+        return false;
+
+    SegmentHeader header = {};
+    header.magic = kSegmentMagic;
+    header.version = kRecordingVersion;
+    segment_.write((const char*)&header, sizeof(header));
+    if (!segment_.good()) {
+        segment_.close();
+        return false;
+    }
+    segment_offset_ = sizeof(header);
+    has_segment_ = true;
+    return true;
+}
+
+// Stores the used size and gives the unused preallocated tail back
+void FrameRecorder::CloseSegment_() {
+    if (!has_segment_)
+        return;
+
+    SegmentHeader header = {};
+    header.magic = kSegmentMagic;
+    header.version = kRecordingVersion;
+    header.used_size = segment_offset_;
+    segment_.seekp(0);
+    segment_.write((const char*)&header, sizeof(header));
+    segment_.close();
+
+    std::error_code error;
+    std::filesystem::resize_file(segment_path_, segment_offset_, error);
+    has_segment_ = false;
+    segment_number_++;
+}
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+void MappedFile::Open(const std::string& path) {
+    Close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Couldn't open " + path);
+    file_ = file;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        Close();
+        throw std::runtime_error("Couldn't get the size of " + path);
+    }
+    size_ = (size_t)size.QuadPart;
+    if (size_ == 0)
+        return;
+    mapping_ = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping_ != NULL)
+        data_ = (const uint8_t*)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+    if (data_ == nullptr) {
+        Close();
+        throw std::runtime_error("Couldn't map " + path);
+    }
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        throw std::runtime_error("Couldn't open " + path);
+    struct stat status;
+    if (fstat(file, &status) != 0) {
+        close(file);
+        throw std::runtime_error("Couldn't get the size of " + path);
+    }
+    size_ = (size_t)status.st_size;
+    if (size_ > 0) {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+        if (data == MAP_FAILED) {
+            close(file);
+            size_ = 0;
+            throw std::runtime_error("Couldn't map " + path);
+        }
+        data_ = (const uint8_t*)data;
+    }
+    close(file);
+#endif
+}
+
+void MappedFile::Close() {
+#ifdef _WIN32
+    if (data_ != nullptr)
+        UnmapViewOfFile(data_);
+    if (mapping_ != nullptr)
+        CloseHandle((HANDLE)mapping_);
+    if (file_ != nullptr)
+        CloseHandle((HANDLE)file_);
+#else
+    if (data_ != nullptr)
+        munmap((void*)data_, size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    file_ = nullptr;
+    mapping_ = nullptr;
+}
+
+const uint8_t* MappedFile::GetData() const {
+    return data_;
+}
+
+size_t MappedFile::GetSize() const {
+    return size_;
+}
+
+RecordingReader::RecordingReader(const std::string& directory) {
+    index_.Open((std::filesystem::path(directory) / "index.tvi").string());
+    num_frames_ = index_.GetSize() / sizeof(IndexEntry);
+
+    const IndexEntry* entries = (const IndexEntry*)index_.GetData();
+    uint32_t num_segments = 0;
+    for (size_t i = 0; i < num_frames_; i++)
+        num_segments = std::max(num_segments, entries[i].segment + 1);
+    for (uint32_t i = 0; i < num_segments; i++) {
+        segments_.emplace_back(new MappedFile());
+        segments_.back()->Open(SegmentPath(directory, i));
+    }
+}
+
+size_t RecordingReader::GetFrameCount() const {
+    return num_frames_;
+}
+
+bool RecordingReader::GetFrame(const size_t frame_number, RecordedFrame& frame) const {
+    if (frame_number >= num_frames_)
+        return false;
+    const IndexEntry& entry = ((const IndexEntry*)index_.GetData())[frame_number];
+    if (entry.segment >= segments_.size() || entry.record_size < sizeof(RecordHeader))
+        return false;
+    const MappedFile& segment = *segments_[entry.segment];
+    if (entry.offset + entry.record_size > segment.GetSize())
+        return false;
+
+    const RecordHeader* header = (const RecordHeader*)(segment.GetData() + entry.offset);
+    if (header->magic != kRecordMagic || (uint64_t)header->header_size + header->raw_size + header->chunk_size > entry.record_size)
+        return false;
+
+    frame.header = header;
+    frame.raw = (const uint8_t*)header + header->header_size;
+    frame.chunk = (header->chunk_size > 0) ? frame.raw + header->raw_size : nullptr;
+    return true;
+}
@@ -0,0 +1,183 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/**
+* @file frame_recorder.h
+* @brief Append-only recording of raw frames and DNN chunk data, and zero-copy reading of it
+* @date 2026/10
+*/
+
+#ifndef FRAME_RECORDER_H_
+#define FRAME_RECORDER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./common.h"
+#include "./frame_source.h"
+
+// A recording is a directory holding:
+//   index.tvi           one IndexEntry per frame, the frame number is the position in the file
+//   segment_NNNN.tvs    SegmentHeader, then per frame a RecordHeader, the raw pixels and the chunk bytes
+//   fpk_info.dat        network description needed to parse the chunks
+//   label.txt           class labels of the network
+// Records start on kRecordAlignment boundaries. Integers are stored little endian.
+const uint32_t kSegmentMagic = 0x53525654;   // 'T' 'V' 'R' 'S'
+const uint32_t kRecordMagic = 0x52525654;    // 'T' 'V' 'R' 'R'
+const uint32_t kRecordingVersion = 1;
+const size_t kRecordAlignment = 64;
+
+struct SegmentHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t used_size;        // Bytes written, the rest of the preallocated file is unused
+    uint8_t reserved[48];
+};
+
+struct RecordHeader {
+    uint32_t magic;
+    uint32_t header_size;      // sizeof(RecordHeader) of the writer, the raw pixels follow it
+    uint64_t frame_number;
+    uint64_t frame_id;
+    uint64_t device_timestamp_ns;
+    uint64_t host_timestamp_ns;
+    uint64_t pixel_format;
+    int32_t width;
+    int32_t height;
+    uint32_t raw_size;
+    uint32_t chunk_size;       // The chunk bytes follow the raw pixels
+    int32_t roi_id;
+    int32_t roi_offset_x;
+    int32_t roi_offset_y;
+    int32_t roi_width;
+    int32_t roi_height;
+    uint8_t tensor_header[12]; // Input tensor header at the start of the chunk, zeros without a chunk
+    uint8_t reserved[32];
+};
+
+struct IndexEntry {
+    uint64_t offset;           // Offset of the RecordHeader in its segment
+    uint32_t segment;
+    uint32_t record_size;
+    uint64_t device_timestamp_ns;
+};
+
+static_assert(sizeof(SegmentHeader) == 64, "SegmentHeader must stay 64 bytes");
+static_assert(sizeof(RecordHeader) == 128, "RecordHeader must stay 128 bytes");
+static_assert(sizeof(IndexEntry) == 24, "IndexEntry must stay 24 bytes");
+
+// Writes frames to a recording. Record() only copies the frame into a queue slot so the
+// capture thread can requeue its buffer; a background thread appends the slots to
+// segments that are preallocated at full size and trimmed when they are closed.
+class FrameRecorder {
+public:
+    FrameRecorder();
+    ~FrameRecorder();
+
+    // Creates the directory, stores the network description and starts the writer thread.
+    // Returns false when already recording or when the directory cannot be written.
+    bool Start(const std::string& directory, const void* fpk_info, const size_t fpk_info_size, const uint8_t* labels, const size_t labels_size);
+    // Waits for Record() calls in progress, writes every queued frame, then closes the recording
+    void Stop();
+    // Also false after a segment could not be created, Stop() must still be called
+    bool IsRecording() const;
+
+    // Returns false and counts a drop when the queue already holds kMaxQueuedBytes_.
+    // May run concurrently with Stop().
+    bool Record(const RawFrame& frame, const int roi_id, const ROI& roi);
+
+    const std::string& GetDirectory() const;
+    uint64_t GetRecordedCount() const;
+    uint64_t GetDroppedCount() const;
+    uint64_t GetWrittenBytes() const;
+
+private:
+    void WriterLoop_();
+    void Write_(const std::vector<uint8_t>& record);
+    bool OpenSegment_();
+    void CloseSegment_();
+
+    std::string directory_;
+    std::atomic<bool> is_recording_{ false };
+    std::thread writer_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::vector<uint8_t>*> queue_;
+    std::vector<std::vector<uint8_t>*> free_;
+    std::vector<std::unique_ptr<std::vector<uint8_t>>> slots_; // Reused, so steady recording does not allocate
+    size_t queued_bytes_ = 0;
+    size_t in_flight_ = 0;       // Slots taken by Record() and not queued yet
+    bool stop_ = false;
+    uint64_t next_frame_number_ = 0;
+
+    // Owned by the writer thread
+    std::fstream segment_;
+    std::string segment_path_;
+    std::ofstream index_;
+    uint32_t segment_number_ = 0;
+    uint64_t segment_offset_ = 0;
+    bool has_segment_ = false;
+    bool has_failed_ = false;    // Every later frame is dropped
+
+    std::atomic<uint64_t> recorded_{ 0 };
+    std::atomic<uint64_t> dropped_{ 0 };
+    std::atomic<uint64_t> written_bytes_{ 0 };
+
+    const uint64_t kSegmentSize_ = 1ULL << 30;
+    const size_t kMaxQueuedBytes_ = 512 * 1024 * 1024;
+};
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+public:
+    MappedFile() {}
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Throws when the file cannot be opened or mapped
+    void Open(const std::string& path);
+    void Close();
+
+    const uint8_t* GetData() const;
+    size_t GetSize() const;
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    void* file_ = nullptr;     // Windows file and mapping handles
+    void* mapping_ = nullptr;
+};
+
+// One frame of a recording. The pointers point into the mapped segment.
+struct RecordedFrame {
+    const RecordHeader* header = nullptr;
+    const uint8_t* raw = nullptr;
+    const uint8_t* chunk = nullptr;
+};
+
+// Maps a recording and gives random access to its frames without copying them
+class RecordingReader {
+public:
+    // Throws when the index or a segment cannot be mapped
+    explicit RecordingReader(const std::string& directory);
+
+    size_t GetFrameCount() const;
+    // Returns false when frame_number is out of range or the record is damaged
+    bool GetFrame(const size_t frame_number, RecordedFrame& frame) const;
+
+private:
+    MappedFile index_;
+    std::vector<std::unique_ptr<MappedFile>> segments_;
+    size_t num_frames_ = 0;
+};
+
+#endif
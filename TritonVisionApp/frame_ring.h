@@ -0,0 +1,117 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/**
+* @file frame_ring.h
+* @brief Bounded single-producer/single-consumer ring used to hand frames to the UI
+* @date 2026/10
+*/
+
+#ifndef FRAME_RING_H_
+#define FRAME_RING_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Lock-free ring of preallocated slots. One thread writes (BeginWrite/EndWrite),
+// one thread reads (BeginRead/EndRead). Slots are reused, so their buffers are
+// recycled instead of being reallocated on every frame.
+// A ring of N slots holds at most N - 1 frames. When the reader falls behind, the
+// writer may drop the oldest frame (DropOldest) to make room for a newer one; the
+// slot the reader is in is never handed to the writer.
+template <typename T, size_t N>
+class FrameRing {
+    static_assert(N >= 2, "FrameRing needs at least two slots");
+
+public:
+    // Producer side: returns the slot to fill, or nullptr when the ring is full.
+    T* BeginWrite() {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (Next_(head) == tail_.load(std::memory_order_seq_cst))
+            return nullptr;
+        // A slot dropped while the consumer was in it is only free once EndRead() ran
+        if (head == reading_.load(std::memory_order_seq_cst))
+            return nullptr;
+        return &slots_[head];
+    }
+
+    // Producer side: publishes the slot returned by BeginWrite().
+    void EndWrite() {
+        head_.store(Next_(head_.load(std::memory_order_relaxed)), std::memory_order_release);
+    }
+
+    // Producer side: discards the oldest published frame. Returns false when the
+    // ring is empty.
+    bool DropOldest() {
+        size_t tail = tail_.load(std::memory_order_seq_cst);
+        while (tail != head_.load(std::memory_order_relaxed)) {
+            if (tail_.compare_exchange_weak(tail, Next_(tail), std::memory_order_seq_cst))
+                return true;
+        }
+        return false;
+    }
+
+    // Consumer side: returns the oldest published slot, or nullptr when empty.
+    // The slot stays reserved for the consumer until EndRead().
+    T* BeginRead() {
+        size_t tail = tail_.load(std::memory_order_seq_cst);
+        for (;;) {
+            if (tail == head_.load(std::memory_order_acquire))
+                return nullptr;
+            reading_.store(tail, std::memory_order_seq_cst);
+            // The producer may have dropped the slot before it saw the reservation
+            const size_t current = tail_.load(std::memory_order_seq_cst);
+            if (current == tail)
+                break;
+            tail = current;
+        }
+        read_index_ = tail;
+        return &slots_[tail];
+    }
+
+    // Consumer side: hands the slot returned by BeginRead() back to the producer.
+    void EndRead() {
+        size_t expected = read_index_;
+        // Fails when the producer dropped the slot in the meantime, which frees it as well
+        tail_.compare_exchange_strong(expected, Next_(read_index_), std::memory_order_seq_cst);
+        reading_.store(kNotReading_, std::memory_order_seq_cst);
+    }
+
+    // Consumer side: skips every frame but the newest and swaps it into out.
+    // The previous contents of out go back into the ring for reuse.
+    bool ReadLatest(T& out) {
+        bool found = false;
+        while (T* slot = BeginRead()) {
+            if (Size() > 1) {
+                EndRead();
+                continue;
+            }
+            std::swap(out, *slot);
+            EndRead();
+            found = true;
+        }
+        return found;
+    }
+
+    size_t Size() const {
+        const size_t head = head_.load(std::memory_order_acquire);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        return (head + N - tail) % N;
+    }
+
+    static constexpr size_t Capacity() { return N - 1; }
+
+private:
+    static size_t Next_(size_t index) { return (index + 1) % N; }
+
+    static constexpr size_t kNotReading_ = N;
+
+    std::array<T, N> slots_;
+    alignas(64) std::atomic<size_t> head_{ 0 };
+    alignas(64) std::atomic<size_t> tail_{ 0 };
+    alignas(64) std::atomic<size_t> reading_{ kNotReading_ }; // Slot between BeginRead() and EndRead()
+    size_t read_index_ = 0;                                   // Consumer only
+};
+
+#endif
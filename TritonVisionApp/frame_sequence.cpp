@@ -0,0 +1,80 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file frame_sequence.cpp
+* @brief Checks the camera frame ids against the frame counters of the IMX500 tensors
+* @date 2026/10
+*/
+
+#include "./frame_sequence.h"
+
+#include <algorithm>
+
+void FrameSequenceTracker::Reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_ = SequenceStats();
+    has_frame_id_ = false;
+    has_dnn_ = false;
+}
+
+int FrameSequenceTracker::OnFrame(const uint64_t frame_id, const uint64_t source_skips, const bool has_tensors, const uint8_t input_frame_count, const uint8_t output_frame_count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int events = kNone;
+    stats_.frames++;
+
+    if (has_frame_id_ && frame_id > last_frame_id_ + 1) {
+        uint64_t gap = frame_id - last_frame_id_ - 1;
+        uint64_t skipped = std::min(source_skips, gap);
+        stats_.source_skips += skipped;
+        if (gap > skipped) {
+            stats_.camera_gaps += gap - skipped;
+            events |= kCameraGap;
+        }
+    }
+    has_frame_id_ = true;
+    last_frame_id_ = frame_id;
+
+    if (!has_tensors)
+        return events;
+    stats_.dnn_frames++;
+    stats_.last_frame_count = input_frame_count;
+
+    if (input_frame_count == kFrameCountStandby_ || output_frame_count == kFrameCountStandby_) {
+        // Not part of the streaming sequence, the next streaming frame starts over
+        stats_.standby++;
+        has_dnn_ = false;
+        return events | kStandby;
+    }
+    if (input_frame_count != output_frame_count) {
+        stats_.mismatches++;
+        events |= kMismatch;
+    }
+
+    // Both counters advance once per sensor frame, so the tensors should move as far as the frame id did.
+    // Frame ids are only compared modulo the counter range, longer gaps cannot be told apart.
+    if (has_dnn_ && frame_id > last_dnn_frame_id_) {
+        int expected = (int)((frame_id - last_dnn_frame_id_) % kFrameCountModulo_);
+        int advanced = (input_frame_count - last_dnn_count_ + kFrameCountModulo_) % kFrameCountModulo_;
+        if (advanced == 0 && expected != 0) {
+            stats_.dnn_duplicates++;
+            events |= kDnnDuplicate;
+        }
+        else if (advanced > expected) {
+            stats_.dnn_gaps += advanced - expected;
+            events |= kDnnGap;
+        }
+        else if (advanced < expected) {
+            stats_.dnn_lagging++;
+            events |= kDnnLagging;
+        }
+    }
+    has_dnn_ = true;
+    last_dnn_frame_id_ = frame_id;
+    last_dnn_count_ = input_frame_count;
+    return events;
+}
+
+SequenceStats FrameSequenceTracker::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
@@ -0,0 +1,67 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/**
+* @file frame_sequence.h
+* @brief Checks the camera frame ids against the frame counters of the IMX500 tensors
+* @date 2026/10
+*/
+
+#ifndef FRAME_SEQUENCE_H_
+#define FRAME_SEQUENCE_H_
+
+#include <cstdint>
+#include <mutex>
+
+// Counters since the stream started. Comparing them tells where frames go missing:
+// camera_gaps without dnn_gaps points at the link or the host, dnn_gaps, duplicates
+// and lagging frames at the IMX500, mismatches at the chunk itself. Frames the
+// acquisition policy skipped on purpose are counted apart from the camera gaps.
+struct SequenceStats {
+    uint64_t frames = 0;          // Frames checked
+    uint64_t dnn_frames = 0;      // Frames that carried tensors
+    uint64_t camera_gaps = 0;     // Camera frame ids never seen by the pipeline, other than source_skips
+    uint64_t source_skips = 0;    // Frame ids the frame source dropped on purpose
+    uint64_t dnn_gaps = 0;        // Inference frames skipped beyond the camera gaps
+    uint64_t dnn_duplicates = 0;  // Tensors repeated from the previous frame
+    uint64_t dnn_lagging = 0;     // Tensors that advanced less than the camera frames
+    uint64_t mismatches = 0;      // Input and output tensor counters differ
+    uint64_t standby = 0;         // Tensors marked as taken in software standby
+    int last_frame_count = -1;    // Input tensor frame_count of the last frame, -1 if none
+};
+
+// Per stream. frame_count runs 0-254 and wraps, 255 marks software standby.
+class FrameSequenceTracker {
+public:
+    // Kinds of events found in one frame, combined as bits
+    enum Event {
+        kNone = 0,
+        kCameraGap = 1 << 0,
+        kDnnGap = 1 << 1,
+        kDnnDuplicate = 1 << 2,
+        kDnnLagging = 1 << 3,
+        kMismatch = 1 << 4,
+        kStandby = 1 << 5,
+    };
+
+    void Reset();
+
+    // Returns the Event bits found in this frame. source_skips is RawFrame::source_skips.
+    // The counters only matter when has_tensors is set.
+    int OnFrame(const uint64_t frame_id, const uint64_t source_skips, const bool has_tensors, const uint8_t input_frame_count, const uint8_t output_frame_count);
+
+    SequenceStats GetStats();
+
+private:
+    std::mutex mutex_;
+    SequenceStats stats_;
+    bool has_frame_id_ = false;
+    uint64_t last_frame_id_ = 0;
+    bool has_dnn_ = false;
+    uint64_t last_dnn_frame_id_ = 0;
+    int last_dnn_count_ = 0;
+
+    const int kFrameCountModulo_ = 255;
+    const uint8_t kFrameCountStandby_ = 255;
+};
+
+#endif
@@ -0,0 +1,439 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file frame_source.cpp
+* @brief Where ArenaDeviceHandler::Process() gets its frames from: a camera or a recording
+* @date 2026/10
+*/
+
+#include "./frame_source.h"
+#include "./frame_recorder.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+#include <nlohmann/json.hpp>
+
+bool ParseAcquisitionPolicy(const std::string& name, AcquisitionPolicy& policy) {
+    if (name == "OldestFirst")
+        policy = AcquisitionPolicy::OldestFirst;
+    else if (name == "NewestOnly")
+        policy = AcquisitionPolicy::NewestOnly;
+    else if (name == "BoundedLag")
+        policy = AcquisitionPolicy::BoundedLag;
+    else
+        return false;
+    return true;
+}
+
+bool IsSingleChannelFormat(const uint64_t pixel_format) {
+    return pixel_format == Mono8 || pixel_format == BayerRG8 || pixel_format == BayerBG8 || pixel_format == BayerGR8 || pixel_format == BayerGB8;
+}
+
+ArenaFrameSource::ArenaFrameSource(Arena::IDevice* pDevice) : pDevice_(pDevice) {
+}
+
+void ArenaFrameSource::StartStream() {
+    // PixelFormat is locked while streaming
+    if (!settings_.pixel_format.empty() && settings_.pixel_format != "Default") {
+        GenApi::CEnumerationPtr pPixelFormat = pDevice_->GetNodeMap()->GetNode("PixelFormat");
+        if (pPixelFormat == NULL)
+            throw std::runtime_error("Couldn't find the node");
+        GenApi::CEnumEntryPtr pFormat = pPixelFormat->GetEntryByName(settings_.pixel_format.c_str());
+        if (pFormat == NULL)
+            throw std::runtime_error("Unsupported pixel format " + settings_.pixel_format);
+        if (pPixelFormat->GetIntValue() != pFormat->GetValue())
+            pPixelFormat->SetIntValue(pFormat->GetValue());
+    }
+
+    // BoundedLag needs the queued frames, so only NewestOnly lets the driver drop them
+    GenApi::CEnumerationPtr pHandlingMode = pDevice_->GetTLStreamNodeMap()->GetNode("StreamBufferHandlingMode");
+    if (pHandlingMode == NULL)
+        throw std::runtime_error("Couldn't find the node");
+    const char* handling_mode = (settings_.policy == AcquisitionPolicy::NewestOnly) ? "NewestOnly" : "OldestFirst";
+    GenApi::CEnumEntryPtr pEntry = pHandlingMode->GetEntryByName(handling_mode);
+    if (pEntry == NULL)
+        throw std::runtime_error("Couldn't find the node");
+    pHandlingMode->SetIntValue(pEntry->GetValue());
+
+    if (settings_.buffer_count > 0)
+        pDevice_->StartStream(settings_.buffer_count);
+    else
+        pDevice_->StartStream();
+    has_last_frame_id_ = false;
+    has_chunk_nodes_ = false;
+    pLostFrames_ = pDevice_->GetTLStreamNodeMap()->GetNode("StreamLostFrameCount");
+    last_lost_frames_ = (pLostFrames_ != NULL && GenApi::IsReadable(pLostFrames_)) ? (uint64_t)pLostFrames_->GetValue() : 0;
+    SyncClock_();
+}
+
+void ArenaFrameSource::StopStream() {
+    pDevice_->StopStream();
+}
+
+bool ArenaFrameSource::Acquire(RawFrame& frame, const int timeout_ms) {
+    try
+    {
+        pImage_ = pDevice_->GetImage(timeout_ms);
+    }
+    catch (GenICam::TimeoutException)
+    {
+        pImage_ = nullptr;
+        return false;
+    }
+    if (pImage_ == NULL)
+        return false;
+
+    if (std::chrono::steady_clock::now() - last_clock_sync_ > kClockSyncInterval_)
+        SyncClock_();
+
+    // Stale frames are handed back as long as a newer one is already waiting
+    uint64_t requeued = 0;
+    if (settings_.policy == AcquisitionPolicy::BoundedLag && has_clock_offset_) {
+        while (GetLagMs_(pImage_->GetTimestampNs()) > settings_.max_lag_ms) {
+            Arena::IImage* pNewer = NULL;
+            try
+            {
+                pNewer = pDevice_->GetImage(0);
+            }
+            catch (GenICam::TimeoutException)
+            {
+            }
+            if (pNewer == NULL)
+                break;
+            pDevice_->RequeueBuffer(pImage_);
+            pImage_ = pNewer;
+            requeued++;
+        }
+    }
+
+    frame.data = pImage_->GetData();
+    frame.width = (int)pImage_->GetWidth();
+    frame.height = (int)pImage_->GetHeight();
+    frame.pixel_format = pImage_->GetPixelFormat();
+    frame.frame_id = pImage_->GetFrameId();
+    frame.timestamp_ns = pImage_->GetTimestampNs();
+    frame.host_timestamp_ns = has_clock_offset_ ? (uint64_t)((int64_t)frame.timestamp_ns + clock_offset_ns_) : 0;
+    frame.is_complete = false;
+
+    // Frame ids restart with the stream and wrap, so only forward gaps are counted.
+    // The part of a gap caused by the acquisition policy is reported with the frame:
+    // NewestOnly replaces every frame in between in the driver, the other policies
+    // drop frames that find no free buffer and BoundedLag requeues stale ones.
+    frame.source_skips = 0;
+    if (has_last_frame_id_ && frame.frame_id > last_frame_id_ + 1) {
+        uint64_t gap = frame.frame_id - last_frame_id_ - 1;
+        skipped_ += gap;
+        if (settings_.policy == AcquisitionPolicy::NewestOnly) {
+            frame.source_skips = gap;
+        }
+        else {
+            uint64_t lost_frames = (pLostFrames_ != NULL && GenApi::IsReadable(pLostFrames_)) ? (uint64_t)pLostFrames_->GetValue() : last_lost_frames_;
+            uint64_t no_buffer = (lost_frames > last_lost_frames_) ? lost_frames - last_lost_frames_ : 0;
+            frame.source_skips = std::min(requeued + no_buffer, gap);
+            last_lost_frames_ = lost_frames;
+        }
+    }
+    last_frame_id_ = frame.frame_id;
+    has_last_frame_id_ = true;
+    frame.chunk = nullptr;
+    frame.chunk_size = 0;
+
+    if (pImage_->IsIncomplete() == false) {
+        Arena::IChunkData* pChunkData = pImage_->AsChunkData();
+        if (pChunkData == NULL) {
+            printf("no chunk data\n");
+        }
+        else if (pChunkData->IsIncomplete() == false) {
+            frame.is_complete = true;
+            ReadChunk_(pChunkData, frame);
+        }
+    }
+    return true;
+}
+
+void ArenaFrameSource::Release(RawFrame& frame) {
+    if (pImage_ != nullptr)
+        pDevice_->RequeueBuffer(pImage_);
+    pImage_ = nullptr;
+    frame.data = nullptr;
+    frame.chunk = nullptr;
+}
+
+bool ArenaFrameSource::IsConnected() {
+    return pDevice_->IsConnected();
+}
+
+void ArenaFrameSource::SetAcquisitionSettings(const AcquisitionSettings& settings) {
+    settings_ = settings;
+}
+
+uint64_t ArenaFrameSource::GetSkippedCount() {
+    return skipped_;
+}
+
+StreamStatistics ArenaFrameSource::GetStreamStatistics() {
+    GenApi::INodeMap* pNodeMap = pDevice_->GetTLStreamNodeMap();
+    auto read = [pNodeMap](const char* name) -> uint64_t {
+        GenApi::CIntegerPtr pCounter = pNodeMap->GetNode(name);
+        if (pCounter == NULL || !GenApi::IsReadable(pCounter))
+            return 0;
+        return (uint64_t)pCounter->GetValue();
+    };
+    StreamStatistics statistics;
+    statistics.delivered_frames = read("StreamDeliveredFrameCount");
+    statistics.lost_frames = read("StreamLostFrameCount");
+    statistics.incomplete_frames = read("StreamIncompleteFrameCount");
+    statistics.missed_packets = read("StreamMissedPacketCount");
+    statistics.queued_buffers = read("StreamInputBufferCount");
+    return statistics;
+}
+
+// The host time is taken halfway through the latch command, so the error is at most half its round trip
+void ArenaFrameSource::SyncClock_() {
+    last_clock_sync_ = std::chrono::steady_clock::now();
+    GenApi::INodeMap* pNodeMap = pDevice_->GetNodeMap();
+    GenApi::CCommandPtr pLatch = pNodeMap->GetNode("TimestampLatch");
+    GenApi::CIntegerPtr pLatchValue = pNodeMap->GetNode("TimestampLatchValue");
+    if (pLatch == NULL || pLatchValue == NULL || !GenApi::IsWritable(pLatch))
+        return;
+
+    auto before = std::chrono::steady_clock::now();
+    pLatch->Execute();
+    auto after = std::chrono::steady_clock::now();
+    int64_t host_ns = std::chrono::duration_cast<std::chrono::nanoseconds>((before + (after - before) / 2).time_since_epoch()).count();
+    clock_offset_ns_ = host_ns - pLatchValue->GetValue();
+    has_clock_offset_ = true;
+}
+
+double ArenaFrameSource::GetLagMs_(const uint64_t device_timestamp_ns) const {
+    int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    return (now_ns - ((int64_t)device_timestamp_ns + clock_offset_ns_)) / 1e6;
+}
+
+// A frame without the DNN chunk is still delivered, IMX501Utils reports the missing chunk.
+// The chunk nodes belong to the chunk adapter of the device, which every retrieved image
+// is attached to, so they are looked up by name once per stream and read for each frame.
+// The chunk register takes its length from ChunkDeepNeuralNetworkLength. Once the first
+// frame confirmed that, the length node is no longer read.
+bool ArenaFrameSource::ReadChunk_(Arena::IChunkData* pChunkData, RawFrame& frame) {
+    if (!has_chunk_nodes_) {
+        pChunk_ = pChunkData->GetChunk(kChunkNodeName_);
+        pChunkLength_ = pChunkData->GetChunk(kChunkLengthNodeName_);
+        is_length_from_register_ = false;
+        has_chunk_nodes_ = (bool)pChunk_; // Looked up again while frames come without it
+    }
+    if (!pChunk_ || !GenApi::IsAvailable(pChunk_) || !GenApi::IsReadable(pChunk_))
+        return false;
+
+    int64_t length = 0;
+    if (is_length_from_register_) {
+        length = pChunk_->GetLength();
+    }
+    else {
+        if (!pChunkLength_ || !GenApi::IsAvailable(pChunkLength_) || !GenApi::IsReadable(pChunkLength_))
+            return false;
+        length = pChunkLength_->GetValue();
+        is_length_from_register_ = (length > 0 && pChunk_->GetLength() == length);
+    }
+    if (length <= 0)
+        return false;
+    if (chunk_buffer_.size() < (size_t)length)
+        chunk_buffer_.resize((size_t)length);
+    pChunk_->Get(chunk_buffer_.data(), length);
+
+    frame.chunk = chunk_buffer_.data();
+    frame.chunk_size = (size_t)length;
+    return true;
+}
+
+ReplayFrameSource::ReplayFrameSource(const std::string& path) {
+    if (std::filesystem::is_directory(path)) {
+        std::filesystem::path root(path);
+        recording_.reset(new RecordingReader(path));
+        if (recording_->GetFrameCount() == 0)
+            throw std::runtime_error("The recording has no frames");
+        fpk_info_ = ReadFile_((root / "fpk_info.dat").string());
+        if (std::filesystem::exists(root / "label.txt"))
+            labels_ = ReadFile_((root / "label.txt").string());
+
+        RecordedFrame first;
+        RecordedFrame last;
+        if (recording_->GetFrame(0, first) && recording_->GetFrame(recording_->GetFrameCount() - 1, last) && last.header->device_timestamp_ns > first.header->device_timestamp_ns)
+            frame_rate_ = (recording_->GetFrameCount() - 1) * 1e9 / (double)(last.header->device_timestamp_ns - first.header->device_timestamp_ns);
+        return;
+    }
+
+    const std::string& manifest_path = path;
+    std::ifstream stream(manifest_path);
+    if (!stream.is_open())
+        throw std::runtime_error("Couldn't open " + manifest_path);
+    nlohmann::json manifest = nlohmann::json::parse(stream);
+
+    // File names in the manifest are relative to its directory
+    size_t separator = manifest_path.find_last_of("/\\");
+    std::string directory = (separator == std::string::npos) ? "" : manifest_path.substr(0, separator + 1);
+
+    width_ = manifest.at("Width").get<int>();
+    height_ = manifest.at("Height").get<int>();
+    pixel_format_ = ParsePixelFormat_(manifest.at("PixelFormat").get<std::string>());
+    frame_rate_ = manifest.value("FrameRate", 0.0);
+    loop_ = manifest.value("Loop", true);
+    fpk_info_ = ReadFile_(directory + manifest.at("FpkInfo").get<std::string>());
+    if (manifest.contains("Labels"))
+        labels_ = ReadFile_(directory + manifest.at("Labels").get<std::string>());
+
+    size_t bytes_per_pixel = (pixel_format_ == BGR8 || pixel_format_ == RGB8) ? 3 : 1;
+    size_t image_size = (size_t)width_ * height_ * bytes_per_pixel;
+    for (const nlohmann::json& entry : manifest.at("Frames")) {
+        Frame frame;
+        frame.raw = ReadFile_(directory + entry.at("Raw").get<std::string>());
+        if (frame.raw.size() < image_size)
+            throw std::runtime_error("Recorded image is smaller than Width x Height");
+        if (entry.contains("Chunk"))
+            frame.chunk = ReadFile_(directory + entry.at("Chunk").get<std::string>());
+        frames_.push_back(std::move(frame));
+    }
+    if (frames_.empty())
+        throw std::runtime_error("The recording has no frames");
+}
+
+ReplayFrameSource::~ReplayFrameSource() {
+}
+
+void ReplayFrameSource::StartStream() {
+    next_deadline_ = std::chrono::steady_clock::now();
+    is_stream_ = true;
+}
+
+void ReplayFrameSource::StopStream() {
+    is_stream_ = false;
+}
+
+// Paced to the configured frame rate like a free-running camera. Without a frame rate
+// the next frame is returned immediately, so the pipeline itself sets the rate.
+bool ReplayFrameSource::Acquire(RawFrame& frame, const int timeout_ms) {
+    if (is_stream_ != true)
+        return false;
+    if (next_index_ >= GetFrameCount()) {
+        if (!loop_) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+            return false;
+        }
+        next_index_ = 0;
+    }
+
+    double frame_rate = frame_rate_;
+    if (frame_rate > 0.0) {
+        auto now = std::chrono::steady_clock::now();
+        if (next_deadline_ - now > std::chrono::milliseconds(timeout_ms)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+            return false;
+        }
+        std::this_thread::sleep_until(next_deadline_);
+        // A slow consumer lowers the rate instead of getting a burst of frames afterwards
+        auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / frame_rate));
+        next_deadline_ = std::max(next_deadline_ + period, std::chrono::steady_clock::now());
+    }
+
+    frame.frame_id = next_frame_id_++;
+    frame.timestamp_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    frame.host_timestamp_ns = frame.timestamp_ns;
+    frame.is_complete = true;
+
+    if (recording_) {
+        // Points into the mapped segment, nothing is copied
+        RecordedFrame recorded;
+        if (!recording_->GetFrame(next_index_++, recorded))
+            return false;
+        frame.data = recorded.raw;
+        frame.width = recorded.header->width;
+        frame.height = recorded.header->height;
+        frame.pixel_format = recorded.header->pixel_format;
+        frame.chunk = recorded.chunk;
+        frame.chunk_size = recorded.header->chunk_size;
+        return true;
+    }
+
+    const Frame& source = frames_[next_index_++];
+    frame.data = source.raw.data();
+    frame.width = width_;
+    frame.height = height_;
+    frame.pixel_format = pixel_format_;
+    frame.chunk = source.chunk.empty() ? nullptr : source.chunk.data();
+    frame.chunk_size = source.chunk.size();
+    return true;
+}
+
+void ReplayFrameSource::Release(RawFrame& frame) {
+    frame.data = nullptr;
+    frame.chunk = nullptr;
+}
+
+bool ReplayFrameSource::IsConnected() {
+    return true;
+}
+
+void ReplayFrameSource::SetAcquisitionSettings(const AcquisitionSettings& settings) {
+}
+
+uint64_t ReplayFrameSource::GetSkippedCount() {
+    return 0;
+}
+
+StreamStatistics ReplayFrameSource::GetStreamStatistics() {
+    StreamStatistics statistics;
+    statistics.delivered_frames = next_frame_id_;
+    return statistics;
+}
+
+const std::vector<uint8_t>& ReplayFrameSource::GetFpkInfo() const {
+    return fpk_info_;
+}
+
+const std::vector<uint8_t>& ReplayFrameSource::GetLabels() const {
+    return labels_;
+}
+
+size_t ReplayFrameSource::GetFrameCount() const {
+    return recording_ ? recording_->GetFrameCount() : frames_.size();
+}
+
+double ReplayFrameSource::GetFrameRate() const {
+    return frame_rate_;
+}
+
+void ReplayFrameSource::SetFrameRate(const double frame_rate) {
+    frame_rate_ = frame_rate;
+}
+
+std::vector<uint8_t> ReplayFrameSource::ReadFile_(const std::string& path) {
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream.is_open())
+        throw std::runtime_error("Couldn't open " + path);
+    std::vector<uint8_t> data((size_t)stream.tellg());
+    stream.seekg(0, std::ios::beg);
+    stream.read((char*)data.data(), (std::streamsize)data.size());
+    return data;
+}
+
+uint64_t ReplayFrameSource::ParsePixelFormat_(const std::string& name) {
+    if (name == "Mono8")
+        return Mono8;
+    if (name == "BayerRG8")
+        return BayerRG8;
+    if (name == "BayerGR8")
+        return BayerGR8;
+    if (name == "BayerGB8")
+        return BayerGB8;
+    if (name == "BayerBG8")
+        return BayerBG8;
+    if (name == "BGR8")
+        return BGR8;
+    if (name == "RGB8")
+        return RGB8;
+    throw std::runtime_error("Unsupported pixel format " + name);
+}
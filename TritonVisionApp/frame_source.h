@@ -0,0 +1,202 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/**
+* @file frame_source.h
+* @brief Where ArenaDeviceHandler::Process() gets its frames from: a camera or a recording
+* @date 2026/10
+*/
+
+#ifndef FRAME_SOURCE_H_
+#define FRAME_SOURCE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Arena/ArenaApi.h"
+
+class RecordingReader;
+
+// How frames queued in the driver are handed to the pipeline when it falls behind
+enum class AcquisitionPolicy {
+    OldestFirst, // Every frame in arrival order, latency grows while processing is slow
+    NewestOnly,  // Only the newest frame, older ones are overwritten in the driver
+    BoundedLag,  // Arrival order, but a frame older than max_lag_ms is skipped when a newer one is queued
+};
+
+struct AcquisitionSettings {
+    AcquisitionPolicy policy = AcquisitionPolicy::NewestOnly;
+    int buffer_count = 0; // Stream buffers, 0 keeps the driver default
+    int max_lag_ms = 100; // BoundedLag only
+    std::string pixel_format = "Default"; // PixelFormat entry the camera streams, "Default" keeps the camera setting
+};
+
+// Names accepted by ParseAcquisitionPolicy()
+const char* const kAcquisitionPolicyNames = "OldestFirst, NewestOnly, BoundedLag";
+
+// Returns false and leaves policy unchanged for a name not in kAcquisitionPolicyNames
+bool ParseAcquisitionPolicy(const std::string& name, AcquisitionPolicy& policy);
+
+// Mono8 and the Bayer formats carry luminance in one byte per pixel, so the pipeline
+// keeps them on one channel instead of converting to BGR
+bool IsSingleChannelFormat(const uint64_t pixel_format);
+
+// Counters of the stream driver since the stream started, 0 where the driver has none
+struct StreamStatistics {
+    uint64_t delivered_frames = 0;
+    uint64_t lost_frames = 0;       // No free buffer when the frame arrived
+    uint64_t incomplete_frames = 0;
+    uint64_t missed_packets = 0;
+    uint64_t queued_buffers = 0;    // Buffers free for the driver to fill right now
+};
+
+// One acquired frame. Every pointer stays valid until the frame is released.
+struct RawFrame {
+    const uint8_t* data = nullptr;  // Pixels in pixel_format, width * height packed rows
+    int width = 0;
+    int height = 0;
+    uint64_t pixel_format = 0;      // PfncFormat
+    uint64_t frame_id = 0;
+    uint64_t source_skips = 0;      // Frames right before this one that the source dropped on purpose
+    uint64_t timestamp_ns = 0;      // Device clock
+    uint64_t host_timestamp_ns = 0; // The same instant on the host steady clock, 0 when unknown
+    bool is_complete = false;       // Image and chunk data arrived complete
+    const uint8_t* chunk = nullptr; // ChunkDeepNeuralNetwork bytes, nullptr when the frame has none
+    size_t chunk_size = 0;
+};
+
+// Stream control and frame acquisition, the only part of the device that the
+// processing pipeline depends on
+class IFrameSource {
+public:
+    virtual ~IFrameSource() {}
+
+    virtual void StartStream() = 0;
+    virtual void StopStream() = 0;
+
+    // Returns false when no frame arrived within timeout_ms
+    virtual bool Acquire(RawFrame& frame, const int timeout_ms) = 0;
+    // Hands the buffer of an acquired frame back to the source
+    virtual void Release(RawFrame& frame) = 0;
+
+    virtual bool IsConnected() = 0;
+
+    // Takes effect on the next StartStream()
+    virtual void SetAcquisitionSettings(const AcquisitionSettings& settings) = 0;
+    // Frames the camera produced but the pipeline never got, skipped or lost
+    virtual uint64_t GetSkippedCount() = 0;
+    // Reads the stream node map, so it is called from the thread that acquires frames
+    virtual StreamStatistics GetStreamStatistics() = 0;
+};
+
+// Frames of a camera streaming through the Arena SDK
+class ArenaFrameSource : public IFrameSource {
+public:
+    explicit ArenaFrameSource(Arena::IDevice* pDevice);
+
+    void StartStream() override;
+    void StopStream() override;
+    bool Acquire(RawFrame& frame, const int timeout_ms) override;
+    void Release(RawFrame& frame) override;
+    bool IsConnected() override;
+    void SetAcquisitionSettings(const AcquisitionSettings& settings) override;
+    uint64_t GetSkippedCount() override;
+    StreamStatistics GetStreamStatistics() override;
+
+private:
+    bool ReadChunk_(Arena::IChunkData* pChunkData, RawFrame& frame);
+    void SyncClock_();
+    double GetLagMs_(const uint64_t device_timestamp_ns) const;
+
+    Arena::IDevice* pDevice_;
+    Arena::IImage* pImage_ = nullptr;
+    std::vector<uint8_t> chunk_buffer_; // Grows to the largest chunk once
+    // Looked up on the first frame of each stream
+    bool has_chunk_nodes_ = false;
+    GenApi::CRegisterPtr pChunk_;
+    GenApi::CIntegerPtr pChunkLength_;
+    bool is_length_from_register_ = false; // The chunk register reports the chunk length itself
+    AcquisitionSettings settings_;
+
+    // Device clock to host steady clock, measured with TimestampLatch
+    bool has_clock_offset_ = false;
+    int64_t clock_offset_ns_ = 0;
+    std::chrono::steady_clock::time_point last_clock_sync_;
+
+    bool has_last_frame_id_ = false;
+    uint64_t last_frame_id_ = 0;
+    std::atomic<uint64_t> skipped_{ 0 };
+    GenApi::CIntegerPtr pLostFrames_; // StreamLostFrameCount, nullptr when the driver has none
+    uint64_t last_lost_frames_ = 0;
+
+    const std::chrono::seconds kClockSyncInterval_{ 10 };
+    const GENICAM_NAMESPACE::gcstring kChunkNodeName_ = "ChunkDeepNeuralNetwork";
+    const GENICAM_NAMESPACE::gcstring kChunkLengthNodeName_ = "ChunkDeepNeuralNetworkLength";
+};
+
+// Replays frames recorded beforehand, so the pipeline can run without a camera.
+// The recording is described by a json manifest, file names are relative to it:
+// {
+//   "Width": 4052, "Height": 3036, "PixelFormat": "BayerRG8",
+//   "FpkInfo": "fpk_info.dat", "Labels": "label.txt",
+//   "FrameRate": 10.0,   // 0 -> as fast as the pipeline processes them
+//   "Loop": true,
+//   "Frames": [ { "Raw": "frame_0000.raw", "Chunk": "frame_0000.dnn" }, ... ]
+// }
+// Raw files hold the packed pixels, chunk files the ChunkDeepNeuralNetwork bytes.
+// Every file is loaded up front so that disk reads do not show up in the timings.
+// A directory written by FrameRecorder is replayed straight from its memory-mapped
+// segments instead, looping at the rate it was recorded.
+class ReplayFrameSource : public IFrameSource {
+public:
+    // Throws when the manifest, the recording or one of its files cannot be read
+    explicit ReplayFrameSource(const std::string& path);
+    ~ReplayFrameSource();
+
+    void StartStream() override;
+    void StopStream() override;
+    bool Acquire(RawFrame& frame, const int timeout_ms) override;
+    void Release(RawFrame& frame) override;
+    bool IsConnected() override;
+    // Pacing already keeps replayed frames fresh, so the settings are ignored
+    void SetAcquisitionSettings(const AcquisitionSettings& settings) override;
+    uint64_t GetSkippedCount() override;
+    StreamStatistics GetStreamStatistics() override;
+
+    // Content of fpk_info.dat and label.txt for IMX501Utils::InitFromRecordedData()
+    const std::vector<uint8_t>& GetFpkInfo() const;
+    const std::vector<uint8_t>& GetLabels() const;
+
+    size_t GetFrameCount() const;
+    double GetFrameRate() const;
+    void SetFrameRate(const double frame_rate);
+
+private:
+    struct Frame {
+        std::vector<uint8_t> raw;
+        std::vector<uint8_t> chunk;
+    };
+
+    static std::vector<uint8_t> ReadFile_(const std::string& path);
+    static uint64_t ParsePixelFormat_(const std::string& name);
+
+    int width_ = 0;
+    int height_ = 0;
+    uint64_t pixel_format_ = 0;
+    bool loop_ = true;
+    std::atomic<double> frame_rate_{ 0.0 };
+    std::vector<uint8_t> fpk_info_;
+    std::vector<uint8_t> labels_;
+    std::vector<Frame> frames_;
+    std::unique_ptr<RecordingReader> recording_;
+
+    std::atomic<bool> is_stream_{ false };
+    size_t next_index_ = 0;
+    std::atomic<uint64_t> next_frame_id_{ 0 };
+    std::chrono::steady_clock::time_point next_deadline_;
+};
+
+#endif
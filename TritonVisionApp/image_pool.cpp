@@ -0,0 +1,58 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file image_pool.cpp
+* @brief Pool of preallocated image buffers keyed by size and type
+* @date 2026/10
+*/
+
+#include "./image_pool.h"
+
+cv::Mat ImagePool::Acquire(const int rows, const int cols, const int type) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = free_list_.find(Key(rows, cols, type));
+        if (it != free_list_.end() && !it->second.empty()) {
+            cv::Mat mat = it->second.back();
+            it->second.pop_back();
+            return mat;
+        }
+    }
+    cv::Mat mat(rows, cols, type);
+    NoteAllocation(mat.total() * mat.elemSize());
+    return mat;
+}
+
+void ImagePool::Release(cv::Mat& mat) {
+    if (mat.empty())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<cv::Mat>& list = free_list_[Key(mat.rows, mat.cols, mat.type())];
+        // Views and buffers still referenced elsewhere must not be handed out again
+        bool is_owned = mat.isContinuous() && mat.u != nullptr && mat.u->refcount == 1;
+        if (list.size() < kMaxFreePerSize_ && is_owned)
+            list.push_back(mat);
+    }
+    mat.release();
+}
+
+void ImagePool::Reshape(cv::Mat& mat, const int rows, const int cols, const int type) {
+    if (mat.rows == rows && mat.cols == cols && mat.type() == type)
+        return;
+    Release(mat);
+    mat = Acquire(rows, cols, type);
+}
+
+void ImagePool::NoteAllocation(const size_t bytes) {
+    allocation_count_++;
+    allocated_bytes_ += bytes;
+}
+
+uint64_t ImagePool::GetAllocationCount() const {
+    return allocation_count_;
+}
+
+uint64_t ImagePool::GetAllocatedBytes() const {
+    return allocated_bytes_;
+}
@@ -0,0 +1,53 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/**
+* @file image_pool.h
+* @brief Pool of preallocated image buffers keyed by size and type
+* @date 2026/10
+*/
+
+#ifndef IMAGE_POOL_H_
+#define IMAGE_POOL_H_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+// Buffers are handed out by Acquire() and come back through Release(), so a
+// steady stream of same-sized frames reuses the same memory. Every buffer the
+// pool has to create is counted, which shows whether the steady state allocates.
+// Shared by the capture thread and the UI thread.
+class ImagePool {
+public:
+    // Returns a buffer of the requested geometry. Its contents are undefined.
+    cv::Mat Acquire(const int rows, const int cols, const int type);
+
+    // Gives the buffer back to the pool and leaves mat empty.
+    void Release(cv::Mat& mat);
+
+    // Makes mat the requested geometry, swapping buffers through the pool only when it differs.
+    void Reshape(cv::Mat& mat, const int rows, const int cols, const int type);
+
+    // Records an allocation made outside the pool (e.g. by the Arena image factory).
+    void NoteAllocation(const size_t bytes);
+
+    uint64_t GetAllocationCount() const;
+    uint64_t GetAllocatedBytes() const;
+
+private:
+    using Key = std::tuple<int, int, int>;
+
+    std::mutex mutex_;
+    std::map<Key, std::vector<cv::Mat>> free_list_;
+    std::atomic<uint64_t> allocation_count_{ 0 };
+    std::atomic<uint64_t> allocated_bytes_{ 0 };
+
+    const size_t kMaxFreePerSize_ = 8;
+};
+
+#endif
@@ -72,7 +72,17 @@ bool LoadTextureFromCvMat(cv::Mat* image, GLuint* out_texture) {
 #if defined(GL_UNPACK_ROW_LENGTH) && !defined(__EMSCRIPTEN__)
     glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 #endif
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image->cols, image->rows, 0, GL_BGR, GL_UNSIGNED_BYTE, image->data);
+    // Rows of one-channel images are not padded to 4 bytes
+    glPixelStorei(GL_UNPACK_ALIGNMENT, (image->step % 4 == 0) ? 4 : 1);
+    if (image->channels() == 1) {
+        // A third of the bytes of BGR; the sampler repeats the red channel as gray
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, image->cols, image->rows, 0, GL_RED, GL_UNSIGNED_BYTE, image->data);
+        GLint swizzle[] = { GL_RED, GL_RED, GL_RED, GL_ONE };
+        glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+    }
+    else {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image->cols, image->rows, 0, GL_BGR, GL_UNSIGNED_BYTE, image->data);
+    }
 
     *out_texture = parts_img_texture;
 
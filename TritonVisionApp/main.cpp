@@ -29,6 +29,7 @@
 
 #include "./json_utils.h"
 #include "./device_handler.h"
+#include "./device_manager.h"
 
 
 void ApplyROI(std::vector<ROI>& target_roi, std::vector<ROI>& source_roi ) {
@@ -101,6 +102,24 @@ std::string GetDatetimeStr() {
     return s.str();
 }
 
+// Shown while the cameras come up, before the main view has a device to show
+void ShowStartupProgress(DeviceManager& devices) {
+    ImGuiIO& io = ImGui::GetIO();
+    ImGui::SetNextWindowPos(ImVec2(0, 0));
+    ImGui::SetNextWindowSize(io.DisplaySize);
+    ImGui::Begin("Startup", NULL, ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoMove);
+    if (devices.IsDiscovering()) {
+        ImGui::Text("Searching for cameras...");
+    }
+    for (const DeviceStartup& device : devices.GetStartupStatus()) {
+        ImGui::Text("%s  %s  (%.1f s)", device.serial.c_str(), kStartupStage[(int)device.stage], device.elapsed_ms / 1000.0);
+        if (device.stage == StartupStage::Failed)
+            ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "    %s", device.error.c_str());
+    }
+    ImGui::Text("Loading the network takes about 30 s once after a camera is powered up.");
+    ImGui::End();
+}
+
 static int frameCount = 0;
 double fps = 0.0;
 
@@ -126,6 +145,14 @@ int WINAPI WinMain(
     int nCmdShow
 ) {
 
+    // Configuration parameters on json file, including saved ROI coordinate
+    Data result;
+    ReadConfigJson(result);
+
+    // Open the cameras, or the recording set as ReplayPath, in the background while the window is set up.
+    // The UI shows one of them, all of them keep capturing.
+    DeviceManager devices(result.device_serials, result.replay_path);
+
     // [GLFW] Initialization
     if (!glfwInit()) {
         return -1;
@@ -191,12 +218,71 @@ int WINAPI WinMain(
     // ROI coordinate on GUI, reserved coordinate to be applied when clicked "Save" on GUI 
     std::vector<ROI> roi;
 
-    // Configuration parameters on json file, including saved ROI coordinate
-    Data result;
-    ReadConfigJson(result);
-    
-    // Create a device instance
-    ArenaDeviceHandler triton;
+    // Startup progress until every camera is Ready or Failed
+    while (!devices.IsStartupDone() && !glfwWindowShouldClose(window)) {
+        glfwPollEvents();
+        ImGui_ImplOpenGL3_NewFrame();
+        ImGui_ImplGlfw_NewFrame();
+        ImGui::NewFrame();
+        ShowStartupProgress(devices);
+        ImGui::Render();
+        int display_w, display_h;
+        glfwGetFramebufferSize(window, &display_w, &display_h);
+        glClearColor(0.8f, 0.8f, 0.8f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glViewport(0, 0, display_w, display_h);
+        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        glfwSwapBuffers(window);
+    }
+    devices.FinishStartup();
+    printf("%zu camera(s) ready %.0f ms after startup\n", devices.GetDeviceCount(), devices.GetStartupMs());
+    size_t device_index = 0;
+    ArenaDeviceHandler* triton = &devices.GetDevice(device_index);
+
+    // How each camera hands queued frames to its pipeline, applied when its stream starts
+    AcquisitionSettings acquisition_settings;
+    if (!ParseAcquisitionPolicy(result.acquisition_policy, acquisition_settings.policy))
+        printf("Unknown AcquisitionPolicy \"%s\", valid policies are %s. NewestOnly is used.\n", result.acquisition_policy.c_str(), kAcquisitionPolicyNames);
+    acquisition_settings.buffer_count = result.stream_buffer_count;
+    acquisition_settings.max_lag_ms = result.max_lag_ms;
+    acquisition_settings.pixel_format = result.pixel_format;
+    for (size_t i = 0; i < devices.GetDeviceCount(); i++)
+        devices.GetDevice(i).SetAcquisitionSettings(acquisition_settings);
+
+    // Which RAW image the boxes of a late DNN output are decoded and drawn on
+    PairingSettings pairing_settings;
+    pairing_settings.offset = result.tensor_offset;
+    pairing_settings.history_depth = result.raw_history_depth;
+    for (size_t i = 0; i < devices.GetDeviceCount(); i++)
+        devices.GetDevice(i).SetPairingSettings(pairing_settings);
+
+    // The RAW image follows the detections when tracking is on
+    RoiTrackingSettings tracking_settings;
+    tracking_settings.enabled = result.roi_tracking;
+    tracking_settings.margin = result.roi_tracking_margin;
+    tracking_settings.raw_on_demand = result.raw_on_demand;
+    for (size_t i = 0; i < devices.GetDeviceCount(); i++)
+        devices.GetDevice(i).SetRoiTracking(tracking_settings);
+
+    // Decoding has priority over the UI images when a frame runs out of time
+    GovernorSettings governor_settings;
+    governor_settings.budget_ms = result.frame_budget_ms;
+    for (size_t i = 0; i < devices.GetDeviceCount(); i++)
+        devices.GetDevice(i).SetGovernorSettings(governor_settings);
+
+    // Exposure time and gain follow the contrast of the barcode regions when enabled
+    ExposureSettings exposure_settings;
+    exposure_settings.enabled = result.exposure_control;
+    exposure_settings.min_exposure_us = result.min_exposure_us;
+    exposure_settings.max_exposure_us = result.max_exposure_us;
+    exposure_settings.max_gain_db = result.max_gain_db;
+    for (size_t i = 0; i < devices.GetDeviceCount(); i++)
+        devices.GetDevice(i).SetExposureSettings(exposure_settings);
+
+    // Capture and processing run on their own thread per camera, decoupled from vsync
+    devices.StartCapture();
+    FrameResult frame;
+    std::vector<DeviceResult> latest_results;
 
     // Selected Connector pattern
     int pattern_id = 0;
@@ -207,6 +293,10 @@ int WINAPI WinMain(
     // state for demo mode
     int demo_state = -1;
 
+    // ROI schedule view: selected row and a copy of its latest results
+    int schedule_selection = 0;
+    RoiResult schedule_result;
+
     // state for window mode
     int window_mode = 1;
 
@@ -224,6 +314,14 @@ int WINAPI WinMain(
     bool is_show_position_control = false;
     bool is_show_inference_control = true;
 
+    // Display-sized views, refreshed only when a new frame arrives
+    cv::Mat resized(main_window_height, main_window_width, CV_8UC3, cv::Scalar(0, 0, 0));
+    cv::Mat resized_crop(main_window_height, main_window_width, CV_8UC3, cv::Scalar(0, 0, 0));
+    // Scratch image for the Setup tab, reused across frames instead of cloned
+    cv::Mat setup_view;
+    // Full-resolution copy of the selected ROI, the rest of the frame is only kept as a preview
+    cv::Mat detail;
+
     while (!glfwWindowShouldClose(window)) {
 
         // [GL] Process for getting events
@@ -238,27 +336,26 @@ int WINAPI WinMain(
         int width, height;
         glfwGetWindowSize(window, &width, &height);
 
-        //cv::Mat original(kSensorHeight, kSensorWidth, CV_8UC3, cv::Scalar(0, 0, 0));
-        cv::Mat resized(main_window_height, main_window_width, CV_8UC3, cv::Scalar(0, 0, 0));
-
-        cv::Mat resized_crop(main_window_height, main_window_width, CV_8UC3, cv::Scalar(0, 0, 0));
-
         // Change state for demo mode
+        bool has_frame = false;
         if (demo_state < 0) { // Demo is not started
-            int p_roi = triton.GetPointerRoi();
-            if (triton.GetStreamStatus()) {
-                triton.Process(original, raw_cropped, input_tensor[p_roi], detections[p_roi]);
-                cv::resize(original, resized, cv::Size(main_window_width, main_window_height));
-                cv::resize(raw_cropped, resized_crop, cv::Size(main_window_width, main_window_height));
+            if (triton->GetStreamStatus()) {
+                has_frame = triton->GetLatestFrame(frame);
             }
         }
         else { // Demo started
-            triton.SetDnnRoi(roi[demo_state]); // Set new ROI
-            triton.SetPointerRoi(demo_state); // Set operation pointer
-            triton.StopStream();
-            triton.StartStream(1);
-            triton.Process(original, raw_cropped, input_tensor[demo_state], detections[demo_state]); // Process
-            cv::resize(original, resized, cv::Size(main_window_width, main_window_height));
+            if (!triton->GetStreamStatus() || triton->GetOperationMode() != 1) {
+                triton->StopStream();
+                triton->StartStream(1);
+            }
+            // The new ROI is written between two frames, the stream keeps running
+            RoiRequest request;
+            request.roi_id = demo_state;
+            request.has_dnn = true;
+            request.dnn_roi = roi[demo_state];
+            uint64_t ticket = triton->StageRoi(request);
+            triton->SetPointerRoi(demo_state); // Set operation pointer
+            has_frame = triton->WaitForRoi(frame, ticket, 2000); // Wait for the first frame on the new ROI
             if (demo_state >= kNumOfRoi - 1) {
                 demo_state = -1;
             }
@@ -267,6 +364,29 @@ int WINAPI WinMain(
             }
         }
 
+        // Take over the buffers of the new frame. The old buffers go back to the ring.
+        triton->SetPreviewWidth(main_window_width);
+        if (has_frame) {
+            int p_roi = std::min(std::max(frame.roi_id, 0), kNumOfRoi - 1);
+            if (frame.has_image_12m) {
+                cv::swap(original, frame.image_12m);
+            }
+            if (frame.has_detail) {
+                cv::swap(detail, frame.detail_image);
+            }
+            if (frame.has_overlay) {
+                cv::swap(raw_cropped, frame.raw_cropped);
+            }
+            if (frame.has_input_tensor) {
+                cv::swap(input_tensor[p_roi], frame.input_tensor);
+                cv::swap(detections[p_roi], frame.detections);
+            }
+        }
+        if (has_frame || resized.cols != main_window_width) {
+            cv::resize(original, resized, cv::Size(main_window_width, main_window_height));
+            cv::resize(raw_cropped, resized_crop, cv::Size(main_window_width, main_window_height));
+        }
+
         // Draw Menu Bar
         StyleCornerRounding(kStyleRounding0);
         ImGui::SetNextWindowPos(ImVec2(kWidget_Menu_OffsetX, kWidget_Menu_OffsetY));
@@ -279,13 +399,13 @@ int WINAPI WinMain(
 
         if (ImGui::BeginMenuBar()) {
             if (ImGui::BeginMenu("Stream")) {
-                if (triton.GetStreamStatus()) {
+                if (triton->GetStreamStatus()) {
                     ImGui::PushStyleColor(ImGuiCol_Text, IM_COL32(0, 255, 0, 255));
-                    ImGui::MenuItem(kStreamStatus[triton.GetOperationMode()], NULL, false, false);
+                    ImGui::MenuItem(kStreamStatus[triton->GetOperationMode()], NULL, false, false);
                     ImGui::PopStyleColor();
                     if (ImGui::MenuItem("Stop")) {
-                        triton.ResetRawRoi();
-                        triton.ResetDnnRoi();
+                        triton->ResetRawRoi();
+                        triton->ResetDnnRoi();
                     }
                     ImGui::EndMenu();
                 }
@@ -294,11 +414,34 @@ int WINAPI WinMain(
                     ImGui::MenuItem(kStreamStatus[3], NULL, false, false);
                     ImGui::PopStyleColor();
                     if (ImGui::MenuItem("Start")) {
-                        triton.StartStream(2);
+                        triton->StartStream(2);
                     }
                     ImGui::EndMenu();
                 }
             }
+            if (ImGui::BeginMenu("Camera")) {
+                for (size_t i = 0; i < devices.GetDeviceCount(); i++) {
+                    if (ImGui::MenuItem(devices.GetSerial(i).c_str(), NULL, device_index == i, demo_state < 0)) {
+                        device_index = i;
+                        triton = &devices.GetDevice(device_index);
+                    }
+                }
+                ImGui::EndMenu();
+            }
+            if (ImGui::BeginMenu("Recording")) {
+                if (triton->GetRecorder().IsRecording()) {
+                    ImGui::PushStyleColor(ImGuiCol_Text, IM_COL32(255, 0, 0, 255));
+                    ImGui::MenuItem(triton->GetRecorder().GetDirectory().c_str(), NULL, false, false);
+                    ImGui::PopStyleColor();
+                    if (ImGui::MenuItem("Stop Recording")) {
+                        triton->StopRecording();
+                    }
+                }
+                else if (ImGui::MenuItem("Start Recording")) {
+                    triton->StartRecording(std::string(kRecordingPath) + triton->GetSerial() + "_" + GetDatetimeStr());
+                }
+                ImGui::EndMenu();
+            }
             if (ImGui::BeginMenu("Settings")) {
                 if (ImGui::BeginMenu("Window Size")) {
                     if (ImGui::MenuItem("Small", NULL, main_window_width == kResizedWidth640)) {
@@ -315,6 +458,40 @@ int WINAPI WinMain(
                     }
                     ImGui::EndMenu();
                 }
+                if (ImGui::BeginMenu("Acquisition")) {
+                    AcquisitionSettings settings = triton->GetAcquisitionSettings();
+                    for (int i = 0; i < kNumOfAcquisitionPolicy; i++) {
+                        if (ImGui::MenuItem(kAcquisitionPolicy[i], NULL, settings.policy == (AcquisitionPolicy)i)) {
+                            settings.policy = (AcquisitionPolicy)i;
+                            triton->SetAcquisitionSettings(settings);
+                        }
+                    }
+                    ImGui::EndMenu();
+                }
+                if (ImGui::BeginMenu("Pixel Format")) {
+                    AcquisitionSettings settings = triton->GetAcquisitionSettings();
+                    for (int i = 0; i < kNumOfPixelFormat; i++) {
+                        if (ImGui::MenuItem(kPixelFormat[i], NULL, settings.pixel_format == kPixelFormat[i])) {
+                            settings.pixel_format = kPixelFormat[i];
+                            triton->SetAcquisitionSettings(settings);
+                        }
+                    }
+                    ImGui::EndMenu();
+                }
+                RoiTrackingSettings tracking = triton->GetRoiTracking();
+                if (ImGui::MenuItem("RAW ROI Tracking", NULL, tracking.enabled)) {
+                    tracking.enabled = !tracking.enabled;
+                    triton->SetRoiTracking(tracking);
+                }
+                if (ImGui::MenuItem("DNN-only Streaming", NULL, tracking.raw_on_demand)) {
+                    tracking.raw_on_demand = !tracking.raw_on_demand;
+                    triton->SetRoiTracking(tracking);
+                }
+                ExposureSettings exposure = triton->GetExposureSettings();
+                if (ImGui::MenuItem("Exposure Control", NULL, exposure.enabled)) {
+                    exposure.enabled = !exposure.enabled;
+                    triton->SetExposureSettings(exposure);
+                }
                 ImGui::EndMenu();
             }
             ImGui::EndMenuBar();
@@ -326,6 +503,7 @@ int WINAPI WinMain(
         GLuint crop_texture;
         GLuint inputtensor_texture[kNumOfRoi];
         GLuint detection_texture[kNumOfRoi];
+        GLuint schedule_texture = 0;
 
         ImGui::SetNextWindowPos(ImVec2(kWidget_Tab_OffsetX, kWidget_Tab_OffsetY));
         ImGui::SetNextWindowSize(ImVec2(static_cast<float>(width), static_cast<float>(height - kWidget_Tab_OffsetY)));
@@ -340,9 +518,9 @@ int WINAPI WinMain(
             }
             if (ImGui::BeginTabItem("Setup")) {
                 window_mode = 0;
-                if (triton.GetStreamStatus() && (triton.GetOperationMode() == 1)) {
-                    triton.ResetDnnRoi();
-                    triton.ResetRawRoi();
+                if (triton->GetStreamStatus() && (triton->GetOperationMode() == 1)) {
+                    triton->ResetDnnRoi();
+                    triton->ResetRawRoi();
                 }
                 ImGui::EndTabItem();
             }
@@ -357,9 +535,9 @@ int WINAPI WinMain(
             ImGui::Begin("Control Panel", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
             ImGui::SeparatorText("Image Stream");
             //ImGui::Text("Status:  ");
-            if (triton.GetStreamStatus()) {
+            if (triton->GetStreamStatus()) {
                 ImGui::PushStyleColor(ImGuiCol_Text, IM_COL32(0, 255, 0, 255));
-                ImGui::Text(kStreamStatus[triton.GetOperationMode()]);
+                ImGui::Text(kStreamStatus[triton->GetOperationMode()]);
                 ImGui::PopStyleColor();
             }
             else {
@@ -369,11 +547,11 @@ int WINAPI WinMain(
 
             }
             if (ImGui::Button("Start")) {
-                triton.StartStream(2);
+                triton->StartStream(2);
             }
             ImGui::SameLine();
             if (ImGui::Button("Stop")) {
-                triton.ResetRawRoi();
+                triton->ResetRawRoi();
             }
             ImGui::Text("Threshold");
             ImGui::PushID(1);
@@ -394,10 +572,28 @@ int WINAPI WinMain(
             if (ImGui::Button("Run")) {
                 if (demo_state < 0) {
                     demo_state = 0;
-                    triton.ResetDnnRoi();
-					triton.SetDetectionThreshold(result.detection_threshold);
+                    triton->StopSchedule();
+                    triton->ResetDnnRoi();
+					triton->SetDetectionThreshold(result.detection_threshold);
                 }
             }
+            ImGui::SameLine();
+            if (ImGui::Button("Schedule")) {
+                // Cycle through every ROI of the pattern, with the edits made on screen
+                std::vector<ROI> schedule = result.pattern_list[pattern_id].roi_list;
+                for (int i = 0; i < kNumOfRoi && i < (int)schedule.size(); i++) {
+                    schedule[i].offset_x = roi[i].offset_x;
+                    schedule[i].offset_y = roi[i].offset_y;
+                    schedule[i].width = roi[i].width;
+                    schedule[i].height = roi[i].height;
+                }
+                triton->SetDetectionThreshold(result.detection_threshold);
+                triton->StartSchedule(schedule);
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Stop Schedule")) {
+                triton->StopSchedule();
+            }
             ImGui::Spacing();
             ImGui::SeparatorText("Advanced View Settings");
             ImGui::Spacing();
@@ -440,7 +636,7 @@ int WINAPI WinMain(
 
             ImGui::Begin("Image View (Inference Mode)", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
             ImGui::Text(result.pattern_list[pattern_id].pattern_name.c_str());
-            cv::Mat main2 = resized_crop.clone();
+            cv::Mat& main2 = resized_crop;
 
             LoadTextureFromCvMat(&main2, &main_texture);
             ImVec2 demo_size2 = ImVec2(static_cast<float>(main2.cols), static_cast<float>(main2.rows));
@@ -454,7 +650,17 @@ int WINAPI WinMain(
             ImGui::Spacing();
             ImGui::Text("Barcode: ");
             ImGui::SameLine();
-            ImGui::Text(triton.GetBarcode().c_str());
+            ImGui::Text(triton->GetBarcode().c_str());
+            if (devices.GetDeviceCount() > 1) {
+                // Merged results of every camera, newest first
+                ImGui::SeparatorText("All Cameras");
+                devices.GetAggregator().GetLatest(kNumOfAggregatedResults, latest_results);
+                for (auto it = latest_results.rbegin(); it != latest_results.rend(); ++it) {
+                    if (it->barcodes.empty())
+                        continue;
+                    ImGui::Text("%s  #%llu  %s  (%.0f ms)", it->serial.c_str(), (unsigned long long)it->frame_id, it->barcodes.back().c_str(), it->latency_ms);
+                }
+            }
             ImGui::End();
 
             double output_fps = ShowFPS();
@@ -469,8 +675,102 @@ int WINAPI WinMain(
             ImGui::Text("FPS: ");
             ImGui::SameLine();
             ImGui::Text(ShowFPS);
+            ImGui::Text("Image allocations: %llu (%.1f MB)", (unsigned long long)triton->GetImagePool().GetAllocationCount(), triton->GetImagePool().GetAllocatedBytes() / (1024.0 * 1024.0));
+            ImGui::Text("Startup: %.0f ms", devices.GetStartupMs());
+            double first_frame_ms = triton->GetTimeToFirstFrameMs();
+            if (first_frame_ms >= 0.0)
+                ImGui::Text("Time to first frame: %.0f ms after stream start", first_frame_ms);
+            LatencyStats latency = triton->GetLatencyStats();
+            ImGui::Text("Latency: %.1f ms (mean %.1f ms, max %.1f ms)", latency.last_ms, latency.mean_ms, latency.max_ms);
+            ImGui::Text("Skipped frames: %llu", (unsigned long long)latency.skipped);
+            StreamStatistics stream = triton->GetStreamStatistics();
+            ImGui::Text("Buffer hold: %.1f ms, free buffers %llu", latency.hold_ms, (unsigned long long)stream.queued_buffers);
+            ImGui::Text("Lost frames: %llu, incomplete %llu, missed packets %llu", (unsigned long long)stream.lost_frames, (unsigned long long)stream.incomplete_frames, (unsigned long long)stream.missed_packets);
+            SequenceStats sequence = triton->GetSequenceStats();
+            ImGui::Text("Camera frame gaps: %llu, skipped by policy %llu, DNN frames %llu of %llu", (unsigned long long)sequence.camera_gaps, (unsigned long long)sequence.source_skips, (unsigned long long)sequence.dnn_frames, (unsigned long long)sequence.frames);
+            ImGui::Text("DNN gaps: %llu, duplicates %llu, lagging %llu", (unsigned long long)sequence.dnn_gaps, (unsigned long long)sequence.dnn_duplicates, (unsigned long long)sequence.dnn_lagging);
+            ImGui::Text("Input/output mismatches: %llu, standby %llu, frame_count %d", (unsigned long long)sequence.mismatches, (unsigned long long)sequence.standby, sequence.last_frame_count);
+            RoiSwitchStats roi_switches = triton->GetRoiSwitchStats();
+            ImGui::Text("ROI switches: %llu, stream restarts %llu, failed %llu, ROI %d from frame %llu", (unsigned long long)roi_switches.switches, (unsigned long long)roi_switches.stream_restarts, (unsigned long long)roi_switches.failures, roi_switches.last_roi_id, (unsigned long long)roi_switches.last_frame_id);
+            RoiTrackingSettings roi_tracking = triton->GetRoiTracking();
+            if (roi_tracking.enabled || roi_tracking.raw_on_demand) {
+                RoiTrackingStats tracking = triton->GetRoiTrackingStats();
+                ROI raw_roi = triton->GetRawRoi();
+                ImGui::Text("RAW window: %d x %d at (%d, %d), %.0f%% of the DNN ROI", raw_roi.width, raw_roi.height, raw_roi.offset_x, raw_roi.offset_y, tracking.area_ratio * 100.0);
+                ImGui::Text("RAW window updates: %llu, expansions %llu", (unsigned long long)tracking.updates, (unsigned long long)tracking.expansions);
+                if (roi_tracking.raw_on_demand)
+                    ImGui::Text("DNN-only frames: %llu, RAW fetches %llu", (unsigned long long)tracking.idle_frames, (unsigned long long)tracking.fetches);
+            }
+            GovernorSettings governor_settings = triton->GetGovernorSettings();
+            if (governor_settings.budget_ms > 0.0) {
+                GovernorStats governor = triton->GetGovernorStats();
+                ImGui::Text("Frame budget %.0f ms: processing %.1f ms, over budget %llu", governor_settings.budget_ms, governor.frame_ms, (unsigned long long)governor.over_budget);
+                ImGui::Text("Decode %.1f ms (row step %d, rotations %d), overlay %.1f ms, input tensor %.1f ms", governor.decode_ms, governor.row_step, governor.max_rotations, governor.overlay_ms, governor.input_tensor_ms);
+                ImGui::Text("Deferred overlays %llu, input tensors %llu, dropped decodes %llu, reused tracks %llu", (unsigned long long)governor.deferred_overlays, (unsigned long long)governor.deferred_input_tensors, (unsigned long long)governor.dropped_decodes, (unsigned long long)governor.reused_tracks);
+            }
+            if (triton->GetExposureSettings().enabled) {
+                ExposureStats exposure = triton->GetExposureStats();
+                ImGui::Text("Exposure %.0f us, gain %.1f dB, adjustments %llu", exposure.exposure_us, exposure.gain_db, (unsigned long long)exposure.adjustments);
+                ImGui::Text("Barcode levels %.0f-%.0f (contrast %.0f), clipped %.1f%%, decoded %.0f%%", exposure.dark_level, exposure.bright_level, exposure.contrast, exposure.saturated * 100.0, exposure.success_rate * 100.0);
+            }
+            PairingStats pairing = triton->GetPairingStats();
+            ImGui::Text("Tensor pairing: offset %d, own frame %llu, history %llu, unpaired %llu, copies %llu", pairing.offset, (unsigned long long)pairing.same_frame, (unsigned long long)pairing.from_history, (unsigned long long)pairing.unpaired, (unsigned long long)pairing.history_copies);
+            if (triton->GetRecorder().IsRecording()) {
+                FrameRecorder& recorder = triton->GetRecorder();
+                ImGui::Text("Recorded: %llu frames (%.1f MB), dropped %llu", (unsigned long long)recorder.GetRecordedCount(), recorder.GetWrittenBytes() / (1024.0 * 1024.0), (unsigned long long)recorder.GetDroppedCount());
+            }
             ImGui::End();
 
+            // Per-ROI results of the ROI schedule
+            RoiScheduler& scheduler = triton->GetScheduler();
+            size_t num_scheduled = scheduler.GetSize();
+            if (num_scheduled > 0) {
+                ImGui::Begin("ROI Schedule", nullptr, ImGuiWindowFlags_AlwaysAutoResize);
+                if (ImGui::BeginTable("schedule_table", 8, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+                    ImGui::TableSetupColumn("ROI");
+                    ImGui::TableSetupColumn("Priority");
+                    ImGui::TableSetupColumn("Dwell");
+                    ImGui::TableSetupColumn("Visits");
+                    ImGui::TableSetupColumn("Hit Rate");
+                    ImGui::TableSetupColumn("Decoded");
+                    ImGui::TableSetupColumn("Revisit [ms]");
+                    ImGui::TableSetupColumn("Last Barcode");
+                    ImGui::TableHeadersRow();
+                    for (size_t i = 0; i < num_scheduled; i++) {
+                        if (!scheduler.GetResult(i, schedule_result))
+                            continue;
+                        const RoiStats& stats = schedule_result.stats;
+                        char label[32];
+                        sprintf(label, "%d", (int)i);
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn();
+                        if (ImGui::Selectable(label, schedule_selection == (int)i, ImGuiSelectableFlags_SpanAllColumns))
+                            schedule_selection = (int)i;
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%d", schedule_result.roi.priority);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%d", schedule_result.roi.dwell_frames);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%llu", (unsigned long long)stats.visits);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.1f %%", stats.frames > 0 ? 100.0 * stats.frames_with_detection / stats.frames : 0.0);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%llu", (unsigned long long)stats.barcodes_decoded);
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.0f", stats.revisit_interval_ms);
+                        ImGui::TableNextColumn();
+                        ImGui::Text(stats.last_barcode.c_str());
+                    }
+                    ImGui::EndTable();
+                }
+                // Latest detections of the selected ROI
+                if (scheduler.GetResult(schedule_selection, schedule_result) && !schedule_result.detections.empty()) {
+                    LoadTextureFromCvMat(&schedule_result.detections, &schedule_texture);
+                    ImGui::Image(schedule_texture, ImVec2(static_cast<float>(schedule_result.detections.cols), static_cast<float>(schedule_result.detections.rows)));
+                }
+                ImGui::End();
+            }
+
             // Draw Input tensor and Bounding Box of each ROIs
             for (int i = 0; i < kNumOfRoi; i++) {
                 char label[64];
@@ -598,15 +898,17 @@ int WINAPI WinMain(
                     ImGui::SeparatorText("Inference Control");
                     ImGui::Spacing();
                     if (ImGui::Button("Start")) {
-                        triton.SetRawRoi(roi[i]);
-                        triton.SetDnnRoi(roi[i]);
-                        triton.SetPointerRoi(i);
-                        triton.StartStream(1);
+                        triton->StopSchedule();
+                        triton->SetRawRoi(roi[i]);
+                        triton->SetDnnRoi(roi[i]);
+                        triton->SetPointerRoi(i);
+                        triton->StartStream(1);
                     }
                     ImGui::SameLine();
                     if (ImGui::Button("Stop")) {
-                        triton.ResetDnnRoi();
-                        triton.ResetRawRoi();
+                        triton->StopSchedule();
+                        triton->ResetDnnRoi();
+                        triton->ResetRawRoi();
                     }
                 }
                 ImGui::End();
@@ -633,8 +935,8 @@ int WINAPI WinMain(
                 ImGui::ProgressBar(v, ImVec2(0.f, 0.f), buf);
 
                 if (demo_state < 0) {
-                    triton.StopStream();
-                    triton.StartStream(2);
+                    triton->StopStream();
+                    triton->StartStream(2);
                     ImGui::CloseCurrentPopup();
                 }
 
@@ -684,7 +986,7 @@ int WINAPI WinMain(
             int c_pos_y = static_cast<int>(io.MousePos.y - image_pos.y);
 
             // Get RoI
-            int target_roi = triton.GetPointerRoi();
+            int target_roi = triton->GetPointerRoi();
 
             // Roi interaction flag
             static bool exsisting_roi = false;
@@ -699,14 +1001,14 @@ int WINAPI WinMain(
                 // Clicked on existig ROI
                 if (ret >= 0) {
                     exsisting_roi = true;
-                    if (triton.GetPointerRoiAddr() == ret) { // Clicked on same ROI -> keep delta between roi offset and current position
+                    if (triton->GetPointerRoiAddr() == ret) { // Clicked on same ROI -> keep delta between roi offset and current position
                         in_delta_w = (c_pos_x * kSensorWidth / main_window_width) - roi[ret].offset_x;
                         in_delta_h = (c_pos_y * kSensorHeight / main_window_height) - roi[ret].offset_y;
                         same_roi = true;
                     }
                     else // Clicked on different ROI -> change focus
                     {
-                        triton.GetPointerRoiAddr() = ret;
+                        triton->GetPointerRoiAddr() = ret;
                     }
 
                 }
@@ -722,7 +1024,12 @@ int WINAPI WinMain(
                 same_roi = false;
             }
 
-            cv::Mat main = resized.clone();
+            // The ROI colors need BGR, which only costs a window-sized conversion here
+            if (resized.channels() == 1)
+                cv::cvtColor(resized, setup_view, cv::COLOR_GRAY2BGR);
+            else
+                resized.copyTo(setup_view);
+            cv::Mat& main = setup_view;
             // Mouse down & clicked outside of ROI
             if (ImGui::IsMouseDown(0) && ImGui::IsWindowFocused() && is_on_canvas(c_pos_x, c_pos_y, main_window_width, main_window_height) && !exsisting_roi)
             {
@@ -879,16 +1186,22 @@ int WINAPI WinMain(
 
             ImGui::Spacing();
             cv::Mat cropped;
+            ROI selection = { roi[target_roi].id, 0, 0, 0, 0 };
             if ((roi[target_roi].width > 0) && (roi[target_roi].height > 0) && (roi[target_roi].offset_x + roi[target_roi].width < kSensorWidth) && (roi[target_roi].offset_y + roi[target_roi].height < kSensorHeight)) {
-                cropped = original(cv::Rect(roi[target_roi].offset_x, roi[target_roi].offset_y, roi[target_roi].width - (roi[target_roi].width % 4), roi[target_roi].height - (roi[target_roi].height % 4))).clone();
-                LoadTextureFromCvMat(&cropped, &crop_texture);
-                demo_size = ImVec2(static_cast<float>(cropped.cols), static_cast<float>(cropped.rows));
+                selection = { roi[target_roi].id, roi[target_roi].offset_x, roi[target_roi].offset_y, roi[target_roi].width - (roi[target_roi].width % 4), roi[target_roi].height - (roi[target_roi].height % 4) };
+                if (!detail.empty()) {
+                    cropped = detail;
+                    LoadTextureFromCvMat(&cropped, &crop_texture);
+                    demo_size = ImVec2(static_cast<float>(cropped.cols), static_cast<float>(cropped.rows));
+                }
             }
+            // The capture thread converts only this region at full resolution
+            triton->SetDetailRegion(selection);
             static std::string time;
             static int path_selection;
             ImGui::SameLine();
 
-            if (triton.GetStreamStatus()) {
+            if (triton->GetStreamStatus()) {
                 ImGui::Spacing();
                 ImGui::PushStyleColor(ImGuiCol_Text, text_color_gray);
                 ImGui::SeparatorText("Capture Cropped image for AI training");
@@ -903,7 +1216,7 @@ int WINAPI WinMain(
 
                 ImGui::Text(("Last Captured: " + time + "  ").c_str());
                 ImGui::SameLine();
-                if (ImGui::Button("Capture")) {
+                if (ImGui::Button("Capture") && !cropped.empty()) {
                     int ret = _mkdir(kDataImagePath);
                     time = GetDatetimeStr();
                     cv::imwrite(std::string(kDataImagePath) + time + ".png", cropped);
@@ -930,11 +1243,16 @@ int WINAPI WinMain(
             glDeleteTextures(1, &inputtensor_texture[i]);
             glDeleteTextures(1, &detection_texture[i]);
         }
+        if (schedule_texture != 0)
+            glDeleteTextures(1, &schedule_texture);
 
         // [GL] Swap window
         glfwSwapBuffers(window);
     }
 
+    // Stop the capture thread before tearing down the window
+    devices.StopCapture();
+
     // Save json file for threshold
     WriteConfigJson(result);
 
@@ -0,0 +1,80 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file network_cache.cpp
+* @brief On-disk copy of the network description of each camera
+* @date 2026/10
+*/
+
+#include "./network_cache.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+static bool ReadWholeFile(const std::filesystem::path& path, std::vector<uint8_t>& data) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !file.bad();
+}
+
+static bool WriteWholeFile(const std::filesystem::path& path, const void* data, const size_t size) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+    if (size > 0)
+        file.write((const char*)data, (std::streamsize)size);
+    return file.good();
+}
+
+NetworkMetadataCache::NetworkMetadataCache(const std::string& directory) : directory_(directory) {
+}
+
+std::string NetworkMetadataCache::GetEntryPath_(const std::string& serial, const uint64_t fingerprint) const {
+    char name[64];
+    snprintf(name, sizeof(name), "_%016llx", (unsigned long long)fingerprint);
+    return (std::filesystem::path(directory_) / (serial + name)).string();
+}
+
+bool NetworkMetadataCache::Load(const std::string& serial, const uint64_t fingerprint, std::vector<uint8_t>& fpk_info, std::vector<uint8_t>& labels) const {
+    std::filesystem::path entry = GetEntryPath_(serial, fingerprint);
+    // Store() writes label.txt last, so an interrupted store is never loaded
+    if (!std::filesystem::exists(entry / "label.txt"))
+        return false;
+    return ReadWholeFile(entry / "fpk_info.dat", fpk_info) && !fpk_info.empty() && ReadWholeFile(entry / "label.txt", labels);
+}
+
+bool NetworkMetadataCache::Store(const std::string& serial, const uint64_t fingerprint, const void* fpk_info, const size_t fpk_info_size, const uint8_t* labels, const size_t labels_size) const {
+    std::filesystem::path entry = GetEntryPath_(serial, fingerprint);
+    std::error_code error;
+    std::filesystem::create_directories(entry, error);
+    if (error)
+        return false;
+    if (!WriteWholeFile(entry / "fpk_info.dat", fpk_info, fpk_info_size))
+        return false;
+    return WriteWholeFile(entry / "label.txt", labels, labels_size);
+}
+
+int NetworkMetadataCache::LoadNetworkId(const std::string& serial, const uint64_t fingerprint) const {
+    std::ifstream file(std::filesystem::path(GetEntryPath_(serial, fingerprint)) / "network_id.txt");
+    int network_id = -1;
+    if (!(file >> network_id))
+        return -1;
+    return network_id;
+}
+
+bool NetworkMetadataCache::StoreNetworkId(const std::string& serial, const uint64_t fingerprint, const int network_id) const {
+    std::filesystem::path entry = GetEntryPath_(serial, fingerprint);
+    if (!std::filesystem::exists(entry / "label.txt"))
+        return false;
+    std::string text = std::to_string(network_id);
+    return WriteWholeFile(entry / "network_id.txt", text.data(), text.size());
+}
+
+void NetworkMetadataCache::Remove(const std::string& serial, const uint64_t fingerprint) const {
+    std::error_code error;
+    std::filesystem::remove_all(GetEntryPath_(serial, fingerprint), error);
+}
@@ -0,0 +1,40 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/**
+* @file network_cache.h
+* @brief On-disk copy of the network description of each camera
+* @date 2026/10
+*/
+
+#ifndef NETWORK_CACHE_H_
+#define NETWORK_CACHE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Reading fpk_info.dat and label.txt through the FileAccess nodes takes seconds per camera.
+// The cache keeps them in <directory>/<serial>_<fingerprint>/, where the fingerprint is
+// IMX501Utils::GetNetworkFingerprint(), so a camera that got a new network is read again.
+// The fingerprint does not cover the content of label.txt, so the entry also keeps the
+// network id of the chunk data and is removed when the camera reports another one.
+class NetworkMetadataCache {
+public:
+    explicit NetworkMetadataCache(const std::string& directory);
+
+    // Returns false when nothing is cached for the camera and network
+    bool Load(const std::string& serial, const uint64_t fingerprint, std::vector<uint8_t>& fpk_info, std::vector<uint8_t>& labels) const;
+    // Returns false when the files cannot be written, the cache is only an optimization
+    bool Store(const std::string& serial, const uint64_t fingerprint, const void* fpk_info, const size_t fpk_info_size, const uint8_t* labels, const size_t labels_size) const;
+    // Returns -1 when no network id was stored with the entry
+    int LoadNetworkId(const std::string& serial, const uint64_t fingerprint) const;
+    bool StoreNetworkId(const std::string& serial, const uint64_t fingerprint, const int network_id) const;
+    void Remove(const std::string& serial, const uint64_t fingerprint) const;
+
+private:
+    std::string GetEntryPath_(const std::string& serial, const uint64_t fingerprint) const;
+
+    std::string directory_;
+};
+
+#endif
@@ -0,0 +1,200 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file node_access.cpp
+* @brief Minimal interface to camera parameters, implemented on top of a GenApi node map
+* @date 2026/10
+*/
+
+#include "./node_access.h"
+
+#include <limits>
+#include <stdexcept>
+
+GenApiNodeAccess::GenApiNodeAccess(GenApi::INodeMap* pNodeMap) : pNodeMap_(pNodeMap) {
+}
+
+NodeHandle GenApiNodeAccess::Resolve(const char* node_name) {
+    auto it = handles_.find(node_name);
+    if (it != handles_.end())
+        return it->second;
+    Node node;
+    node.name = node_name;
+    node.pNode = pNodeMap_->GetNode(node_name);
+    nodes_.push_back(node);
+    NodeHandle handle = (NodeHandle)nodes_.size() - 1;
+    handles_[node_name] = handle;
+    return handle;
+}
+
+GenApiNodeAccess::Node& GenApiNodeAccess::Get_(const NodeHandle node) {
+    if (node < 0 || node >= (NodeHandle)nodes_.size())
+        throw std::out_of_range("Invalid node handle");
+    return nodes_[node];
+}
+
+GenApi::CIntegerPtr GenApiNodeAccess::GetIntegerNode_(Node& node) {
+    GenApi::CIntegerPtr pInteger = node.pNode;
+    if (pInteger == NULL)
+        throw std::runtime_error("Couldn't find the node " + node.name);
+    return pInteger;
+}
+
+GenApi::CFloatPtr GenApiNodeAccess::GetFloatNode_(Node& node) {
+    GenApi::CFloatPtr pFloat = node.pNode;
+    if (pFloat == NULL)
+        throw std::runtime_error("Couldn't find the node " + node.name);
+    return pFloat;
+}
+
+bool GenApiNodeAccess::IsWritable(const NodeHandle node) {
+    GenApi::INode* pNode = Get_(node).pNode;
+    return pNode != NULL && GenApi::IsWritable(pNode);
+}
+
+// Always read from the device, the node may be one that changes on its own
+int64_t GenApiNodeAccess::GetInteger(const NodeHandle node) {
+    return GetIntegerNode_(Get_(node))->GetValue();
+}
+
+void GenApiNodeAccess::SetInteger(const NodeHandle node, const int64_t value) {
+    Node& entry = Get_(node);
+    GenApi::CIntegerPtr pInteger = GetIntegerNode_(entry);
+    entry.has_value = false; // Unknown if the write fails half way
+    pInteger->SetValue(value);
+    entry.value = value;
+    entry.has_value = true;
+}
+
+int64_t GenApiNodeAccess::GetKnownInteger(const NodeHandle node) {
+    Node& entry = Get_(node);
+    if (!entry.has_value) {
+        entry.value = GetIntegerNode_(entry)->GetValue();
+        entry.has_value = true;
+    }
+    return entry.value;
+}
+
+size_t GenApiNodeAccess::SetIntegers(const NodeWrite* writes, const size_t count) {
+    size_t sent = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (GetKnownInteger(writes[i].node) == writes[i].value)
+            continue;
+        SetInteger(writes[i].node, writes[i].value);
+        sent++;
+    }
+    return sent;
+}
+
+bool GenApiNodeAccess::Execute(const NodeHandle node) {
+    GenApi::CCommandPtr pCommand = Get_(node).pNode;
+    if (pCommand == NULL || !GenApi::IsWritable(pCommand))
+        return false;
+    pCommand->Execute();
+    return true;
+}
+
+double GenApiNodeAccess::GetFloat(const NodeHandle node) {
+    return GetFloatNode_(Get_(node))->GetValue();
+}
+
+void GenApiNodeAccess::SetFloat(const NodeHandle node, const double value) {
+    GetFloatNode_(Get_(node))->SetValue(value);
+}
+
+void GenApiNodeAccess::GetFloatRange(const NodeHandle node, double& min, double& max) {
+    GenApi::CFloatPtr pFloat = GetFloatNode_(Get_(node));
+    min = pFloat->GetMin();
+    max = pFloat->GetMax();
+}
+
+bool GenApiNodeAccess::SetEnumeration(const NodeHandle node, const char* entry) {
+    GenApi::CEnumerationPtr pEnumeration = Get_(node).pNode;
+    if (pEnumeration == NULL || !GenApi::IsWritable(pEnumeration))
+        return false;
+    GenApi::CEnumEntryPtr pEntry = pEnumeration->GetEntryByName(entry);
+    if (pEntry == NULL)
+        return false;
+    if (pEnumeration->GetIntValue() != pEntry->GetValue())
+        pEnumeration->SetIntValue(pEntry->GetValue());
+    return true;
+}
+
+NodeHandle MemoryNodeAccess::Resolve(const char* node_name) {
+    auto it = handles_.find(node_name);
+    if (it != handles_.end())
+        return it->second;
+    Node node;
+    node.name = node_name;
+    nodes_.push_back(node);
+    NodeHandle handle = (NodeHandle)nodes_.size() - 1;
+    handles_[node_name] = handle;
+    return handle;
+}
+
+bool MemoryNodeAccess::IsWritable(const NodeHandle node) {
+    return true;
+}
+
+int64_t MemoryNodeAccess::GetInteger(const NodeHandle node) {
+    return nodes_.at(node).value;
+}
+
+void MemoryNodeAccess::SetInteger(const NodeHandle node, const int64_t value) {
+    nodes_.at(node).value = value;
+}
+
+int64_t MemoryNodeAccess::GetKnownInteger(const NodeHandle node) {
+    return GetInteger(node);
+}
+
+size_t MemoryNodeAccess::SetIntegers(const NodeWrite* writes, const size_t count) {
+    size_t sent = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (GetInteger(writes[i].node) == writes[i].value)
+            continue;
+        SetInteger(writes[i].node, writes[i].value);
+        sent++;
+    }
+    return sent;
+}
+
+bool MemoryNodeAccess::Execute(const NodeHandle node) {
+    return false;
+}
+
+double MemoryNodeAccess::GetFloat(const NodeHandle node) {
+    return nodes_.at(node).float_value;
+}
+
+void MemoryNodeAccess::SetFloat(const NodeHandle node, const double value) {
+    Node& entry = nodes_.at(node);
+    if (value < entry.float_min || value > entry.float_max)
+        throw std::out_of_range("Value out of range for " + entry.name);
+    entry.float_value = value;
+}
+
+void MemoryNodeAccess::GetFloatRange(const NodeHandle node, double& min, double& max) {
+    const Node& entry = nodes_.at(node);
+    min = entry.float_min;
+    max = entry.float_max;
+}
+
+bool MemoryNodeAccess::SetEnumeration(const NodeHandle node, const char* entry) {
+    nodes_.at(node).enumeration = entry;
+    return true;
+}
+
+const std::string& MemoryNodeAccess::GetName(const NodeHandle node) const {
+    return nodes_.at(node).name;
+}
+
+void MemoryNodeAccess::SetFloatRange(const NodeHandle node, const double min, const double max) {
+    Node& entry = nodes_.at(node);
+    entry.float_min = min;
+    entry.float_max = max;
+}
+
+std::string MemoryNodeAccess::GetEnumeration(const NodeHandle node) const {
+    return nodes_.at(node).enumeration;
+}
@@ -0,0 +1,142 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/**
+* @file node_access.h
+* @brief Minimal interface to camera parameters, implemented on top of a GenApi node map
+* @date 2026/10
+*/
+
+#ifndef NODE_ACCESS_H_
+#define NODE_ACCESS_H_
+
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Arena/ArenaApi.h"
+
+// A node looked up by INodeAccess::Resolve(), only valid with the object that returned it
+typedef int NodeHandle;
+
+// One integer write of a batch
+struct NodeWrite {
+    NodeHandle node;
+    int64_t value;
+};
+
+// The parameter access the application needs, kept small so that code writing
+// camera parameters can run against a mock node map instead of a device.
+// Nodes are resolved once, every access after that goes through the handle.
+class INodeAccess {
+public:
+    virtual ~INodeAccess() {}
+
+    // Looks the node up by name. A node the map does not have still gets a handle,
+    // every access through it then fails as described below.
+    virtual NodeHandle Resolve(const char* node_name) = 0;
+
+    virtual bool IsWritable(const NodeHandle node) = 0;
+    virtual int64_t GetInteger(const NodeHandle node) = 0;
+    virtual void SetInteger(const NodeHandle node, const int64_t value) = 0;
+    // Value last written through this object, read from the device only when there is none
+    virtual int64_t GetKnownInteger(const NodeHandle node) = 0;
+
+    // Writes in order, leaving out every write of the value the node already holds.
+    // Returns the number of writes that were sent.
+    virtual size_t SetIntegers(const NodeWrite* writes, const size_t count) = 0;
+
+    // Runs a command node. Returns false when the node does not exist or is not writable.
+    virtual bool Execute(const NodeHandle node) = 0;
+
+    // Float nodes are always read from and written to the device, none is written often
+    virtual double GetFloat(const NodeHandle node) = 0;
+    virtual void SetFloat(const NodeHandle node, const double value) = 0;
+    // Values the node accepts right now, the limits may depend on other nodes
+    virtual void GetFloatRange(const NodeHandle node, double& min, double& max) = 0;
+
+    // Selects an enumeration entry by name. Returns false when the node or the entry
+    // does not exist or the node is not writable.
+    virtual bool SetEnumeration(const NodeHandle node, const char* entry) = 0;
+};
+
+// Every node is looked up by name once and its handle kept for the lifetime of the
+// device. The value of each integer written through this object is remembered, so
+// SetIntegers() skips unchanged writes without a register read. Nodes must therefore
+// not be written around this object while it is in use. Accessing a node the map does
+// not have throws.
+class GenApiNodeAccess : public INodeAccess {
+public:
+    explicit GenApiNodeAccess(GenApi::INodeMap* pNodeMap);
+
+    NodeHandle Resolve(const char* node_name) override;
+    bool IsWritable(const NodeHandle node) override;
+    int64_t GetInteger(const NodeHandle node) override;
+    void SetInteger(const NodeHandle node, const int64_t value) override;
+    int64_t GetKnownInteger(const NodeHandle node) override;
+    size_t SetIntegers(const NodeWrite* writes, const size_t count) override;
+    bool Execute(const NodeHandle node) override;
+    double GetFloat(const NodeHandle node) override;
+    void SetFloat(const NodeHandle node, const double value) override;
+    void GetFloatRange(const NodeHandle node, double& min, double& max) override;
+    bool SetEnumeration(const NodeHandle node, const char* entry) override;
+
+private:
+    struct Node {
+        std::string name;
+        GenApi::INode* pNode = nullptr; // nullptr when the node map has no such node
+        bool has_value = false;         // value is what the node holds
+        int64_t value = 0;
+    };
+
+    Node& Get_(const NodeHandle node);
+    GenApi::CIntegerPtr GetIntegerNode_(Node& node);
+    GenApi::CFloatPtr GetFloatNode_(Node& node);
+
+    GenApi::INodeMap* pNodeMap_;
+    std::vector<Node> nodes_;
+    std::unordered_map<std::string, NodeHandle> handles_; // Only used by Resolve()
+};
+
+// Keeps parameters in memory. Used when frames come from a recording, where there is
+// no device to write to, and as a simulated node map for code that writes parameters.
+// Every name resolves to a node holding 0. Commands are reported as unavailable.
+// Float writes outside of the range given with SetFloatRange() throw, as they would
+// on a device.
+class MemoryNodeAccess : public INodeAccess {
+public:
+    NodeHandle Resolve(const char* node_name) override;
+    bool IsWritable(const NodeHandle node) override;
+    int64_t GetInteger(const NodeHandle node) override;
+    void SetInteger(const NodeHandle node, const int64_t value) override;
+    int64_t GetKnownInteger(const NodeHandle node) override;
+    size_t SetIntegers(const NodeWrite* writes, const size_t count) override;
+    bool Execute(const NodeHandle node) override;
+    double GetFloat(const NodeHandle node) override;
+    void SetFloat(const NodeHandle node, const double value) override;
+    void GetFloatRange(const NodeHandle node, double& min, double& max) override;
+    bool SetEnumeration(const NodeHandle node, const char* entry) override;
+
+    const std::string& GetName(const NodeHandle node) const;
+    // Unlimited until set
+    void SetFloatRange(const NodeHandle node, const double min, const double max);
+    // Entry last selected, empty when none was
+    std::string GetEnumeration(const NodeHandle node) const;
+
+private:
+    struct Node {
+        std::string name;
+        int64_t value = 0;
+        double float_value = 0.0;
+        double float_min = std::numeric_limits<double>::lowest();
+        double float_max = std::numeric_limits<double>::max();
+        std::string enumeration;
+    };
+
+    std::vector<Node> nodes_;
+    std::map<std::string, NodeHandle> handles_;
+};
+
+#endif
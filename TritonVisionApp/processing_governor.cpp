@@ -0,0 +1,160 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file processing_governor.cpp
+* @brief Keeps the processing of a frame within a time budget by deferring the work that matters least
+* @date 2026/10
+*/
+
+#include "./processing_governor.h"
+
+#include <algorithm>
+
+void ProcessingGovernor::SetSettings(const GovernorSettings& settings) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    settings_ = settings;
+    // Costs measured under another budget would hold stages back that now fit
+    for (int i = 0; i < kNumOfStage; i++) {
+        cost_ms_[i] = 0.0;
+        deferred_frames_[i] = 0;
+    }
+    if (settings_.budget_ms <= 0.0) {
+        stats_.row_step = 1;
+        stats_.max_rotations = kMaxRotations_;
+        tracks_.clear();
+    }
+}
+
+GovernorSettings ProcessingGovernor::GetSettings() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return settings_;
+}
+
+bool ProcessingGovernor::IsEnabled() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return settings_.budget_ms > 0.0;
+}
+
+void ProcessingGovernor::BeginFrame(const std::chrono::steady_clock::time_point start) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frame_start_ = start;
+    for (int i = 0; i < kNumOfStage; i++)
+        is_deferred_[i] = false;
+    has_decoded_ = false;
+}
+
+bool ProcessingGovernor::Admit(const Stage stage) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (settings_.budget_ms <= 0.0)
+        return true;
+    if (stage != kDecode && deferred_frames_[stage] >= kMaxDeferred_)
+        return true;
+    if (stage == kDecode && !has_decoded_) {
+        has_decoded_ = true;
+        return true;
+    }
+    if (cost_ms_[stage] <= settings_.budget_ms - ElapsedMs_())
+        return true;
+
+    if (stage == kDecode)
+        stats_.dropped_decodes++;
+    else if (!is_deferred_[stage]) {
+        is_deferred_[stage] = true;
+        if (stage == kOverlay)
+            stats_.deferred_overlays++;
+        else
+            stats_.deferred_input_tensors++;
+    }
+    return false;
+}
+
+void ProcessingGovernor::EndStage(const Stage stage, const double ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cost_ms_[stage] = (cost_ms_[stage] > 0.0) ? cost_ms_[stage] + kSmoothing_ * (ms - cost_ms_[stage]) : ms;
+    stats_.decode_ms = cost_ms_[kDecode];
+    stats_.overlay_ms = cost_ms_[kOverlay];
+    stats_.input_tensor_ms = cost_ms_[kInputTensor];
+}
+
+void ProcessingGovernor::EndFrame() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    double ms = ElapsedMs_();
+    stats_.frame_ms = (stats_.frames > 0) ? stats_.frame_ms + kSmoothing_ * (ms - stats_.frame_ms) : ms;
+    stats_.frames++;
+    for (int i = 0; i < kNumOfStage; i++)
+        deferred_frames_[i] = is_deferred_[i] ? deferred_frames_[i] + 1 : 0;
+
+    for (Track& track : tracks_)
+        track.age++;
+    tracks_.erase(std::remove_if(tracks_.begin(), tracks_.end(), [this](const Track& track) { return track.age > kTrackFrames_; }), tracks_.end());
+
+    if (settings_.budget_ms <= 0.0)
+        return;
+    if (ms > settings_.budget_ms)
+        stats_.over_budget++;
+
+    if (++frames_since_adapt_ < kAdaptInterval_)
+        return;
+    frames_since_adapt_ = 0;
+    // Rows go first, they cost less recognition than a missing rotation
+    if (stats_.frame_ms > settings_.budget_ms) {
+        if (stats_.row_step < kMaxRowStep_)
+            stats_.row_step *= 2;
+        else if (stats_.max_rotations > 1)
+            stats_.max_rotations--;
+    }
+    else if (stats_.frame_ms < settings_.budget_ms * kHeadroom_) {
+        if (stats_.max_rotations < kMaxRotations_)
+            stats_.max_rotations++;
+        else if (stats_.row_step > 1)
+            stats_.row_step /= 2;
+    }
+}
+
+bool ProcessingGovernor::FindDecodedTrack(const cv::Rect& rect, std::string& result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (settings_.budget_ms <= 0.0)
+        return false;
+    for (Track& track : tracks_) {
+        double overlap = (double)(track.rect & rect).area();
+        double total = (double)track.rect.area() + rect.area() - overlap;
+        if (total > 0.0 && overlap / total >= kTrackOverlap_) {
+            // Follows the barcode as it moves
+            track.rect = rect;
+            track.age = 0;
+            result = track.result;
+            stats_.reused_tracks++;
+            return true;
+        }
+    }
+    return false;
+}
+
+void ProcessingGovernor::AddDecodedTrack(const cv::Rect& rect, const std::string& result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (settings_.budget_ms <= 0.0)
+        return;
+    Track track;
+    track.rect = rect;
+    track.result = result;
+    tracks_.push_back(track);
+}
+
+int ProcessingGovernor::GetRowStep() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_.row_step;
+}
+
+int ProcessingGovernor::GetMaxRotations() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_.max_rotations;
+}
+
+GovernorStats ProcessingGovernor::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+double ProcessingGovernor::ElapsedMs_() const {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame_start_).count();
+}
@@ -0,0 +1,107 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/**
+* @file processing_governor.h
+* @brief Keeps the processing of a frame within a time budget by deferring the work that matters least
+* @date 2026/10
+*/
+
+#ifndef PROCESSING_GOVERNOR_H_
+#define PROCESSING_GOVERNOR_H_
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+struct GovernorSettings {
+    double budget_ms = 0.0; // Processing time per frame, 0 turns the governor off
+};
+
+struct GovernorStats {
+    double frame_ms = 0.0;          // Smoothed processing time of a frame
+    double decode_ms = 0.0;         // Smoothed time of one decode
+    double overlay_ms = 0.0;        // Smoothed time of the RAW preview overlay
+    double input_tensor_ms = 0.0;   // Smoothed time of the input tensor image and its boxes
+    uint64_t frames = 0;
+    uint64_t over_budget = 0;       // Frames that took longer than the budget
+    uint64_t deferred_overlays = 0; // Previews left for a later frame
+    uint64_t deferred_input_tensors = 0;
+    uint64_t dropped_decodes = 0;   // Regions not decoded for lack of time
+    uint64_t reused_tracks = 0;     // Regions of an already decoded barcode, not decoded again
+    int row_step = 1;               // Decoder settings in use
+    int max_rotations = 3;
+};
+
+// Work of a frame in order of priority: decoding first, then the images for the UI.
+// Each stage has a smoothed cost. A stage is admitted when its cost still fits into
+// what is left of the budget, but no stage is deferred for more than kMaxDeferred_
+// frames in a row so the UI keeps updating. The first decode of a frame is always
+// admitted, so one slow decode cannot stop decoding for good: its cost is measured
+// again and smooths back down. When whole frames stay over the budget the
+// decoder scans fewer rows and tries fewer rotations, and gets them back once there
+// is headroom again. Regions overlapping a barcode decoded in the last kTrackFrames_
+// frames take over its result instead of being decoded again.
+// The capture thread calls everything but SetSettings()/GetSettings()/GetStats().
+class ProcessingGovernor {
+public:
+    enum Stage {
+        kDecode,
+        kOverlay,
+        kInputTensor,
+        kNumOfStage,
+    };
+
+    void SetSettings(const GovernorSettings& settings);
+    GovernorSettings GetSettings();
+    bool IsEnabled();
+
+    void BeginFrame(const std::chrono::steady_clock::time_point start);
+    // Whether to run the stage now. Counts a deferral or a dropped decode when not.
+    bool Admit(const Stage stage);
+    // Records what a stage cost this time
+    void EndStage(const Stage stage, const double ms);
+    void EndFrame();
+
+    // rect is in sensor coordinates
+    bool FindDecodedTrack(const cv::Rect& rect, std::string& result);
+    void AddDecodedTrack(const cv::Rect& rect, const std::string& result);
+
+    int GetRowStep();
+    int GetMaxRotations();
+    GovernorStats GetStats();
+
+private:
+    struct Track {
+        cv::Rect rect;
+        std::string result;
+        int age = 0; // Frames since it was last seen
+    };
+
+    double ElapsedMs_() const;
+
+    std::mutex mutex_;
+    GovernorSettings settings_;
+    GovernorStats stats_;
+    std::chrono::steady_clock::time_point frame_start_;
+    double cost_ms_[kNumOfStage] = {};
+    int deferred_frames_[kNumOfStage] = {};
+    bool is_deferred_[kNumOfStage] = {};
+    bool has_decoded_ = false;          // A decode was admitted in this frame
+    std::vector<Track> tracks_;
+    int frames_since_adapt_ = 0;
+
+    const int kMaxDeferred_ = 10;
+    const int kTrackFrames_ = 15;
+    const double kTrackOverlap_ = 0.5;  // Intersection over union
+    const int kAdaptInterval_ = 10;     // Frames between two changes of the decoder settings
+    const double kHeadroom_ = 0.7;      // Below this share of the budget the decoder settings are relaxed
+    const int kMaxRowStep_ = 8;
+    const int kMaxRotations_ = 3;
+    const double kSmoothing_ = 0.1;
+};
+
+#endif
@@ -0,0 +1,133 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file raw_roi_tracker.cpp
+* @brief Follows the detections with the RAW image window so sparse scenes ship fewer pixels
+* @date 2026/10
+*/
+
+#include "./raw_roi_tracker.h"
+
+#include <algorithm>
+
+void RawRoiTracker::SetSettings(const RoiTrackingSettings& settings) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    settings_ = settings;
+    settings_.alignment = std::max(1, settings_.alignment);
+    settings_.history_frames = std::max(1, settings_.history_frames);
+}
+
+RoiTrackingSettings RawRoiTracker::GetSettings() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return settings_;
+}
+
+bool RawRoiTracker::IsEnabled() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return settings_.enabled || settings_.raw_on_demand;
+}
+
+bool RawRoiTracker::IsIdleImage(const int width, const int height) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return settings_.raw_on_demand && width <= settings_.idle_width && height <= settings_.idle_height;
+}
+
+void RawRoiTracker::Reset(const ROI& bounds, const ROI& window) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bounds_ = cv::Rect(bounds.offset_x, bounds.offset_y, bounds.width, bounds.height);
+    window_ = cv::Rect(window.offset_x, window.offset_y, window.width, window.height) & bounds_;
+    recent_.clear();
+    empty_frames_ = 0;
+    held_frames_ = 0;
+    stats_.area_ratio = bounds_.empty() ? 1.0 : (double)window_.area() / bounds_.area();
+}
+
+bool RawRoiTracker::OnFrame(const std::vector<cv::Rect>& detections, const bool can_stage, ROI& window) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.frames++;
+    if (bounds_.empty())
+        return false;
+
+    cv::Rect frame_union;
+    for (const cv::Rect& detection : detections)
+        frame_union = frame_union.empty() ? detection : (frame_union | detection);
+    recent_.push_back(frame_union);
+    while ((int)recent_.size() > settings_.history_frames)
+        recent_.pop_front();
+    empty_frames_ = frame_union.empty() ? empty_frames_ + 1 : 0;
+    held_frames_++;
+    cv::Rect idle(bounds_.x, bounds_.y, std::min(settings_.idle_width, bounds_.width), std::min(settings_.idle_height, bounds_.height));
+    bool is_idle = (window_ == idle);
+    if (settings_.raw_on_demand && is_idle)
+        stats_.idle_frames++;
+    if (can_stage == false)
+        return false;
+
+    cv::Rect target;
+    bool is_expansion = false;
+    if (empty_frames_ >= settings_.expand_after) {
+        // The idle window is not aligned, it is only there because the camera needs one
+        target = settings_.raw_on_demand ? idle : bounds_;
+        is_expansion = true;
+    }
+    else {
+        for (const cv::Rect& rect : recent_) {
+            if (!rect.empty())
+                target = target.empty() ? rect : (target | rect);
+        }
+        if (target.empty())
+            return false;
+        target = Align_(cv::Rect(target.x - settings_.margin, target.y - settings_.margin, target.width + 2 * settings_.margin, target.height + 2 * settings_.margin));
+    }
+
+    bool grows = ((target | window_) != window_);
+    bool shrinks = (target.x - window_.x >= settings_.min_change || target.y - window_.y >= settings_.min_change ||
+        window_.br().x - target.br().x >= settings_.min_change || window_.br().y - target.br().y >= settings_.min_change);
+    if (target == window_ || (!grows && !shrinks))
+        return false;
+    // Growing follows the detections at once, giving pixels up waits for the hold
+    if (!grows && held_frames_ < settings_.hold_frames)
+        return false;
+    if (grows && !shrinks && !is_expansion && target.width <= window_.width && target.height <= window_.height) {
+        // Moving keeps the payload size, which cameras accept while streaming
+        int x = std::max(target.br().x - window_.width, std::min(window_.x, target.x));
+        int y = std::max(target.br().y - window_.height, std::min(window_.y, target.y));
+        target = cv::Rect(x, y, window_.width, window_.height);
+    }
+
+    window_ = target;
+    held_frames_ = 0;
+    stats_.updates++;
+    if (is_expansion)
+        stats_.expansions++;
+    else if (is_idle)
+        stats_.fetches++;
+    stats_.area_ratio = (double)window_.area() / bounds_.area();
+    window = { 0, window_.x, window_.y, window_.width, window_.height };
+    return true;
+}
+
+RoiTrackingStats RawRoiTracker::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+// Widens the rectangle outwards to whole steps from the bounds origin and to at least the
+// minimum size. A window pushed against a bound keeps its size by moving away from it.
+cv::Rect RawRoiTracker::Align_(const cv::Rect& rect) const {
+    int step = settings_.alignment;
+    int width = std::max(rect.width, settings_.min_width);
+    int height = std::max(rect.height, settings_.min_height);
+    int x = rect.x - (width - rect.width) / 2 - bounds_.x;
+    int y = rect.y - (height - rect.height) / 2 - bounds_.y;
+
+    int max_cols = bounds_.width / step;
+    int max_rows = bounds_.height / step;
+    int left = (x >= 0) ? x / step : -((-x + step - 1) / step);
+    int top = (y >= 0) ? y / step : -((-y + step - 1) / step);
+    int cols = std::min(max_cols, (x + width + step - 1 - left * step) / step);
+    int rows = std::min(max_rows, (y + height + step - 1 - top * step) / step);
+    left = std::max(0, std::min(left, max_cols - cols));
+    top = std::max(0, std::min(top, max_rows - rows));
+    return cv::Rect(bounds_.x + left * step, bounds_.y + top * step, cols * step, rows * step);
+}
@@ -0,0 +1,88 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/**
+* @file raw_roi_tracker.h
+* @brief Follows the detections with the RAW image window so sparse scenes ship fewer pixels
+* @date 2026/10
+*/
+
+#ifndef RAW_ROI_TRACKER_H_
+#define RAW_ROI_TRACKER_H_
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "./common.h"
+
+struct RoiTrackingSettings {
+    bool enabled = false;
+    int margin = 200;           // Sensor pixels around the detections, covers the motion until the next window
+    int history_frames = 10;    // The window holds the detections of this many recent frames
+    int expand_after = 5;       // Frames without any detection before the window opens to the full bounds
+    int min_width = 512;        // Smallest window, in sensor pixels
+    int min_height = 512;
+    int min_change = 64;        // A window is only shrunk by at least this many pixels on one edge
+    int hold_frames = 15;       // Frames a staged window is kept before it may shrink, longer than expand_after
+    int alignment = 8;          // Offset and size step of the window, a multiple of the node increments
+    bool raw_on_demand = false; // Stream only the DNN chunk while nothing is detected, implies enabled
+    int idle_width = 4;         // RAW window while only the DNN chunk is streamed, the smallest the camera accepts
+    int idle_height = 4;
+};
+
+struct RoiTrackingStats {
+    uint64_t frames = 0;        // Inferred frames seen
+    uint64_t updates = 0;       // Windows staged
+    uint64_t expansions = 0;    // Windows staged because nothing was seen
+    uint64_t idle_frames = 0;   // Inferred frames streamed without a RAW image
+    uint64_t fetches = 0;       // Windows opened from the idle window for new detections
+    double area_ratio = 1.0;    // Area of the current window relative to the bounds
+};
+
+// Picks the RAW OffsetX/OffsetY/Width/Height window from the detections of the DNN,
+// which keeps seeing its whole ROI. The window is the union of the detections of the
+// last history_frames frames plus margin, clipped to the bounds. It follows as soon as a
+// detection reaches outside of it, by moving when the detections still fit its size, and
+// shrinks only by min_change or more, so small moves neither change the payload size nor
+// cost a write each frame. It opens to the bounds after expand_after empty frames.
+// A window shrinks only hold_frames after the last one was staged, so detections that
+// come and go around expand_after do not make it open and close every few frames.
+// With raw_on_demand it closes to the idle window instead, so empty stretches stream
+// little more than the DNN chunk, and opens straight onto the next detections.
+// Every rectangle is in sensor coordinates. Only used by the capture thread, apart from
+// the settings and the stats.
+class RawRoiTracker {
+public:
+    void SetSettings(const RoiTrackingSettings& settings);
+    RoiTrackingSettings GetSettings();
+    bool IsEnabled();
+    // A frame of the idle window, which carries no RAW image worth processing
+    bool IsIdleImage(const int width, const int height);
+
+    // Starts over within bounds, e.g. the DNN ROI, from the RAW window currently in effect
+    void Reset(const ROI& bounds, const ROI& window);
+
+    // Records the detections of one inferred frame. Returns true and fills window when a
+    // new window should be staged. can_stage false only records, e.g. while an earlier
+    // window is not in effect yet.
+    bool OnFrame(const std::vector<cv::Rect>& detections, const bool can_stage, ROI& window);
+
+    RoiTrackingStats GetStats();
+
+private:
+    cv::Rect Align_(const cv::Rect& rect) const;
+
+    std::mutex mutex_;
+    RoiTrackingSettings settings_;
+    RoiTrackingStats stats_;
+    cv::Rect bounds_;
+    cv::Rect window_;                // Last window handed out
+    std::deque<cv::Rect> recent_;    // Union of the detections per frame, empty when there was none
+    int empty_frames_ = 0;
+    int held_frames_ = 0;            // Frames since window_ was staged
+};
+
+#endif
@@ -0,0 +1,32 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file result_aggregator.cpp
+* @brief Merges the results of every camera into one timestamped stream
+* @date 2026/10
+*/
+
+#include "./result_aggregator.h"
+
+#include <chrono>
+
+void ResultAggregator::Push(DeviceResult result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    result.host_timestamp_ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    results_.push_back(std::move(result));
+    if (results_.size() > kMaxResults_)
+        results_.pop_front();
+    total_++;
+}
+
+void ResultAggregator::GetLatest(const size_t count, std::vector<DeviceResult>& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out.clear();
+    size_t begin = (results_.size() > count) ? results_.size() - count : 0;
+    out.insert(out.end(), results_.begin() + begin, results_.end());
+}
+
+uint64_t ResultAggregator::GetTotalCount() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return total_;
+}
@@ -0,0 +1,49 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/**
+* @file result_aggregator.h
+* @brief Merges the results of every camera into one timestamped stream
+* @date 2026/10
+*/
+
+#ifndef RESULT_AGGREGATOR_H_
+#define RESULT_AGGREGATOR_H_
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One processed frame of one camera
+struct DeviceResult {
+    std::string serial;
+    uint64_t host_timestamp_ns = 0;   // Host steady clock, stamped by ResultAggregator::Push()
+    uint64_t device_timestamp_ns = 0; // Camera timestamp of the frame
+    uint64_t frame_id = 0;            // Camera frame id
+    double latency_ms = 0.0;          // Exposure to result, 0 when unknown
+    int roi_id = 0;
+    int num_detections = 0;
+    std::vector<std::string> barcodes;
+};
+
+// Every capture thread pushes into the same aggregator. The newest results are kept
+// in arrival order, which is also host timestamp order.
+class ResultAggregator {
+public:
+    void Push(DeviceResult result);
+
+    // Copies the newest results, newest last
+    void GetLatest(const size_t count, std::vector<DeviceResult>& out);
+
+    uint64_t GetTotalCount();
+
+private:
+    std::mutex mutex_;
+    std::deque<DeviceResult> results_;
+    uint64_t total_ = 0;
+
+    const size_t kMaxResults_ = 1024;
+};
+
+#endif
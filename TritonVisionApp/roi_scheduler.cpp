@@ -0,0 +1,116 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file roi_scheduler.cpp
+* @brief Weighted round-robin of the DNN ROI over several configured regions
+* @date 2026/10
+*/
+
+#include "./roi_scheduler.h"
+
+#include <algorithm>
+
+void RoiScheduler::SetSchedule(const std::vector<ROI>& rois) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    slots_.clear();
+    for (const ROI& roi : rois) {
+        Slot slot;
+        slot.result.roi = roi;
+        slot.dwell_frames = std::max(1, roi.dwell_frames);
+        slot.weight = std::max(1, roi.priority);
+        slots_.push_back(slot);
+    }
+    current_ = -1;
+    current_ticket_ = 0;
+    dwell_count_ = 0;
+}
+
+void RoiScheduler::Clear() {
+    SetSchedule(std::vector<ROI>());
+}
+
+bool RoiScheduler::IsActive() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !slots_.empty();
+}
+
+int RoiScheduler::PickNext(ROI& roi) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (slots_.empty())
+        return -1;
+
+    // Smooth weighted round-robin
+    int total_weight = 0;
+    int best = 0;
+    for (size_t i = 0; i < slots_.size(); i++) {
+        slots_[i].current_weight += slots_[i].weight;
+        total_weight += slots_[i].weight;
+        if (slots_[i].current_weight > slots_[best].current_weight)
+            best = (int)i;
+    }
+    slots_[best].current_weight -= total_weight;
+
+    current_ = best;
+    current_ticket_ = UINT64_MAX; // Nothing counts until the ROI is staged
+    dwell_count_ = 0;
+    roi = slots_[best].result.roi;
+    return best;
+}
+
+void RoiScheduler::OnStaged(const int index, const uint64_t ticket) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index == current_)
+        current_ticket_ = ticket;
+}
+
+bool RoiScheduler::OnFrame(const FrameResult& frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (current_ < 0 || current_ >= (int)slots_.size())
+        return !slots_.empty();
+    // Frames still captured with the previous ROI, or whose output was still inferred on it
+    if (frame.roi_ticket < current_ticket_ || frame.dnn_roi_ticket < current_ticket_ || frame.roi_id != current_ || !frame.has_inference)
+        return false;
+
+    Slot& slot = slots_[current_];
+    RoiStats& stats = slot.result.stats;
+    if (dwell_count_ == 0) {
+        auto now = std::chrono::steady_clock::now();
+        if (slot.has_visited) {
+            double interval_ms = std::chrono::duration<double, std::milli>(now - slot.last_visit).count();
+            stats.revisit_interval_ms = (stats.visits > 1) ? stats.revisit_interval_ms + kRevisitSmoothing_ * (interval_ms - stats.revisit_interval_ms) : interval_ms;
+        }
+        slot.last_visit = now;
+        slot.has_visited = true;
+        stats.visits++;
+    }
+
+    stats.frames++;
+    if (frame.num_detections > 0)
+        stats.frames_with_detection++;
+    stats.barcodes_decoded += frame.barcodes.size();
+    if (!frame.barcodes.empty())
+        stats.last_barcode = frame.barcodes.back();
+    if (frame.has_input_tensor)
+        frame.detections.copyTo(slot.result.detections);
+    slot.result.barcodes = frame.barcodes;
+
+    dwell_count_++;
+    return dwell_count_ >= slot.dwell_frames;
+}
+
+size_t RoiScheduler::GetSize() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slots_.size();
+}
+
+bool RoiScheduler::GetResult(const size_t index, RoiResult& result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index >= slots_.size())
+        return false;
+    const RoiResult& source = slots_[index].result;
+    result.roi = source.roi;
+    result.barcodes = source.barcodes;
+    result.stats = source.stats;
+    source.detections.copyTo(result.detections);
+    return true;
+}
@@ -0,0 +1,84 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/**
+* @file roi_scheduler.h
+* @brief Weighted round-robin of the DNN ROI over several configured regions
+* @date 2026/10
+*/
+
+#ifndef ROI_SCHEDULER_H_
+#define ROI_SCHEDULER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "./capture_worker.h"
+#include "./common.h"
+
+struct RoiStats {
+    uint64_t visits = 0;
+    uint64_t frames = 0;                 // Frames inferred on this ROI
+    uint64_t frames_with_detection = 0;
+    uint64_t barcodes_decoded = 0;
+    std::string last_barcode;
+    double revisit_interval_ms = 0.0;    // Smoothed time between two visits
+};
+
+// Latest results of one ROI
+struct RoiResult {
+    ROI roi = {};
+    cv::Mat detections;
+    std::vector<std::string> barcodes;
+    RoiStats stats;
+};
+
+// Cycles through the scheduled ROIs. Each ROI stays for its dwell frames, then the
+// next one is picked by smooth weighted round-robin on the ROI priorities, so a
+// priority 2 ROI is visited twice as often as a priority 1 ROI and visits of the
+// same ROI are spread evenly. Results are kept per ROI.
+// SetSchedule()/Clear()/Get*() are called from the UI thread, the rest from the capture thread.
+class RoiScheduler {
+public:
+    void SetSchedule(const std::vector<ROI>& rois);
+    void Clear();
+    bool IsActive();
+
+    // Picks the next ROI and returns its index. Only call while the schedule is active.
+    int PickNext(ROI& roi);
+
+    // The ROI of index has been staged with ticket. Frames of earlier tickets are ignored.
+    void OnStaged(const int index, const uint64_t ticket);
+
+    // Records the results of a processed frame. Returns true when the dwell of the
+    // current ROI is over and PickNext() should be called.
+    bool OnFrame(const FrameResult& frame);
+
+    size_t GetSize();
+    // Copies the results of one ROI into result, reusing its image buffer
+    bool GetResult(const size_t index, RoiResult& result);
+
+private:
+    struct Slot {
+        RoiResult result;
+        int dwell_frames = 1;
+        int weight = 1;
+        int current_weight = 0;
+        std::chrono::steady_clock::time_point last_visit;
+        bool has_visited = false;
+    };
+
+    std::mutex mutex_;
+    std::vector<Slot> slots_;
+    int current_ = -1;
+    uint64_t current_ticket_ = 0;
+    int dwell_count_ = 0;
+
+    const double kRevisitSmoothing_ = 0.2;
+};
+
+#endif
@@ -0,0 +1,170 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file roi_switcher.cpp
+* @brief Stages ROI changes and applies them between frames without restarting the stream
+* @date 2026/10
+*/
+
+#include "./roi_switcher.h"
+
+RoiNodes ResolveRoiNodes(INodeAccess& nodes, const RoiNodeNames& names) {
+    RoiNodes handles;
+    handles.offset_x = nodes.Resolve(names.offset_x);
+    handles.offset_y = nodes.Resolve(names.offset_y);
+    handles.width = nodes.Resolve(names.width);
+    handles.height = nodes.Resolve(names.height);
+    return handles;
+}
+
+RoiSwitcher::RoiSwitcher(INodeAccess& nodes, const RoiNodeNames& dnn_nodes, const RoiNodeNames& raw_nodes)
+    : nodes_(nodes),
+      dnn_nodes_(ResolveRoiNodes(nodes, dnn_nodes)),
+      raw_nodes_(ResolveRoiNodes(nodes, raw_nodes)),
+      timestamp_latch_(nodes.Resolve("TimestampLatch")),
+      timestamp_latch_value_(nodes.Resolve("TimestampLatchValue")) {
+}
+
+uint64_t RoiSwitcher::Stage(const RoiRequest& request) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_ = request;
+    has_pending_ = true;
+    return ++last_ticket_;
+}
+
+bool RoiSwitcher::HasPending() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return has_pending_;
+}
+
+bool RoiSwitcher::ApplyPending(const bool is_streaming, const std::function<void()>& stop_stream, const std::function<void()>& start_stream) {
+    RoiSwitchRecord record;
+    RoiRequest request;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!has_pending_)
+            return false;
+        request = pending_;
+        record.ticket = last_ticket_;
+        has_pending_ = false;
+    }
+    record.request = request;
+    std::string error;
+    bool is_stopped = false;
+    try {
+        record.restarted_stream = is_streaming && !IsWritable_(request);
+        if (record.restarted_stream) {
+            stop_stream();
+            is_stopped = true;
+        }
+        if (request.has_dnn)
+            WriteRoi(nodes_, dnn_nodes_, request.dnn_roi);
+        if (request.has_raw)
+            WriteRoi(nodes_, raw_nodes_, request.raw_roi);
+
+        // Frames exposed before this point still carry the old ROI and may already be queued
+        if (is_streaming && !record.restarted_stream && nodes_.Execute(timestamp_latch_))
+            record.latch_timestamp_ns = (uint64_t)nodes_.GetInteger(timestamp_latch_value_);
+    }
+    catch (std::exception& ex) {
+        // e.g. an offset the camera rejects after alignment
+        record.failed = true;
+        error = ex.what();
+    }
+    if (is_stopped)
+        start_stream();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (record.failed) {
+        stats_.failures++;
+        stats_.last_error = error;
+    }
+    awaiting_ = record;
+    has_awaiting_ = true;
+    return true;
+}
+
+bool RoiSwitcher::OnFrame(const uint64_t frame_id, const uint64_t timestamp_ns, RoiSwitchRecord& record) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!has_awaiting_)
+        return false;
+    if (timestamp_ns < awaiting_.latch_timestamp_ns)
+        return false;
+    awaiting_.effective_frame_id = frame_id;
+    has_awaiting_ = false;
+    record = awaiting_;
+    if (record.failed)
+        return true;
+    last_record_ = awaiting_;
+    stats_.switches++;
+    if (record.restarted_stream)
+        stats_.stream_restarts++;
+    stats_.last_roi_id = record.request.roi_id;
+    stats_.last_frame_id = frame_id;
+    return true;
+}
+
+RoiSwitchRecord RoiSwitcher::GetLastRecord() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_record_;
+}
+
+RoiSwitchStats RoiSwitcher::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+const RoiNodes& RoiSwitcher::GetDnnNodes() const {
+    return dnn_nodes_;
+}
+
+const RoiNodes& RoiSwitcher::GetRawNodes() const {
+    return raw_nodes_;
+}
+
+// The camera takes offsets and sizes in steps of 4 pixels
+static int64_t AlignRoiValue(const int64_t value) {
+    const int alignment = 4;
+    return value - (value % alignment);
+}
+
+// Per axis, a shrinking size is written before its offset and a growing one after it,
+// so offset + size never leaves the sensor and no write to 0 is needed in between
+static void AddAxisWrites(INodeAccess& nodes, const NodeHandle offset_node, const NodeHandle size_node, const int64_t offset, const int64_t size, NodeWrite* writes, size_t& count) {
+    if (size <= nodes.GetKnownInteger(size_node)) {
+        writes[count++] = { size_node, size };
+        writes[count++] = { offset_node, offset };
+    }
+    else {
+        writes[count++] = { offset_node, offset };
+        writes[count++] = { size_node, size };
+    }
+}
+
+size_t RoiSwitcher::WriteRoi(INodeAccess& nodes, const RoiNodes& handles, const ROI& roi) {
+    NodeWrite writes[4];
+    size_t count = 0;
+    AddAxisWrites(nodes, handles.offset_x, handles.width, AlignRoiValue(roi.offset_x), AlignRoiValue(roi.width), writes, count);
+    AddAxisWrites(nodes, handles.offset_y, handles.height, AlignRoiValue(roi.offset_y), AlignRoiValue(roi.height), writes, count);
+    return nodes.SetIntegers(writes, count);
+}
+
+bool RoiSwitcher::IsWritable_(const RoiRequest& request) {
+    if (request.has_dnn && !IsWritable_(dnn_nodes_, request.dnn_roi))
+        return false;
+    if (request.has_raw && !IsWritable_(raw_nodes_, request.raw_roi))
+        return false;
+    return true;
+}
+
+// Cameras may lock the size while streaming but not the offsets, so a move
+// that keeps the size only needs the offsets
+bool RoiSwitcher::IsWritable_(const RoiNodes& handles, const ROI& roi) {
+    if (!nodes_.IsWritable(handles.offset_x) || !nodes_.IsWritable(handles.offset_y))
+        return false;
+    if (AlignRoiValue(roi.width) != nodes_.GetKnownInteger(handles.width) && !nodes_.IsWritable(handles.width))
+        return false;
+    if (AlignRoiValue(roi.height) != nodes_.GetKnownInteger(handles.height) && !nodes_.IsWritable(handles.height))
+        return false;
+    return true;
+}
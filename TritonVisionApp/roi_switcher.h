@@ -0,0 +1,116 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/**
+* @file roi_switcher.h
+* @brief Stages ROI changes and applies them between frames without restarting the stream
+* @date 2026/10
+*/
+
+#ifndef ROI_SWITCHER_H_
+#define ROI_SWITCHER_H_
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+
+#include "./common.h"
+#include "./node_access.h"
+
+// Names of the four nodes that describe one ROI
+struct RoiNodeNames {
+    const char* offset_x;
+    const char* offset_y;
+    const char* width;
+    const char* height;
+};
+
+// The same nodes, resolved with ResolveRoiNodes()
+struct RoiNodes {
+    NodeHandle offset_x;
+    NodeHandle offset_y;
+    NodeHandle width;
+    NodeHandle height;
+};
+
+RoiNodes ResolveRoiNodes(INodeAccess& nodes, const RoiNodeNames& names);
+
+struct RoiRequest {
+    int roi_id = 0;
+    bool has_dnn = false;
+    ROI dnn_roi = {};
+    bool has_raw = false;
+    ROI raw_roi = {};
+};
+
+// How and when a staged request reached the camera
+struct RoiSwitchRecord {
+    uint64_t ticket = 0;             // Returned by Stage()
+    RoiRequest request;
+    bool restarted_stream = false;   // The nodes were locked while streaming
+    uint64_t latch_timestamp_ns = 0; // Device time right after the writes, 0 if unknown
+    uint64_t effective_frame_id = 0; // First camera frame captured with the new ROI
+    bool failed = false;             // A write threw, the request was dropped and may be half written
+};
+
+struct RoiSwitchStats {
+    uint64_t switches = 0;           // Requests in effect
+    uint64_t stream_restarts = 0;
+    uint64_t failures = 0;
+    int last_roi_id = -1;
+    uint64_t last_frame_id = 0;      // effective_frame_id of the last switch
+    std::string last_error;
+};
+
+// Requests can be staged from any thread. The capture thread applies them between
+// two GetImage() calls, so a switch costs a frame instead of a stream restart.
+// Only the nodes that cannot be written while streaming fall back to stop/write/start.
+class RoiSwitcher {
+public:
+    RoiSwitcher(INodeAccess& nodes, const RoiNodeNames& dnn_nodes, const RoiNodeNames& raw_nodes);
+
+    // Replaces any request that has not been applied yet. Returns the ticket of the request.
+    uint64_t Stage(const RoiRequest& request);
+    bool HasPending();
+
+    // Capture thread, between frames. Writes the staged request, if any, and returns true.
+    // stop_stream/start_stream are only called when a node is locked while streaming.
+    // A request whose writes throw is dropped; it is still reported by OnFrame(), as failed.
+    bool ApplyPending(const bool is_streaming, const std::function<void()>& stop_stream, const std::function<void()>& start_stream);
+
+    // Capture thread, for every acquired frame. Returns true and fills record when
+    // this is the first frame captured after the last applied request.
+    bool OnFrame(const uint64_t frame_id, const uint64_t timestamp_ns, RoiSwitchRecord& record);
+
+    RoiSwitchRecord GetLastRecord();
+    RoiSwitchStats GetStats();
+
+    // Resolved in the constructor, for writes that do not go through Stage()
+    const RoiNodes& GetDnnNodes() const;
+    const RoiNodes& GetRawNodes() const;
+
+    // Writes one ROI as a single batch and returns the number of writes sent to the camera.
+    // Every intermediate state stays inside the sensor, unchanged values are not written.
+    static size_t WriteRoi(INodeAccess& nodes, const RoiNodes& handles, const ROI& roi);
+
+private:
+    bool IsWritable_(const RoiRequest& request);
+    bool IsWritable_(const RoiNodes& handles, const ROI& roi);
+
+    INodeAccess& nodes_;
+    const RoiNodes dnn_nodes_;
+    const RoiNodes raw_nodes_;
+    const NodeHandle timestamp_latch_;
+    const NodeHandle timestamp_latch_value_;
+
+    std::mutex mutex_;
+    RoiRequest pending_;
+    bool has_pending_ = false;
+    uint64_t last_ticket_ = 0;
+    RoiSwitchRecord awaiting_; // Applied, waiting for its first frame
+    bool has_awaiting_ = false;
+    RoiSwitchRecord last_record_;
+    RoiSwitchStats stats_;
+};
+
+#endif
@@ -0,0 +1,107 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file capture_worker_test.cpp
+* @brief FrameRing and CaptureWorker with a fake producer
+* @date 2026/10
+*/
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "capture_worker.h"
+#include "frame_ring.h"
+#include "./test.h"
+
+TEST(FrameRingDropsOldest) {
+    FrameRing<int, 4> ring;
+    for (int i = 1; i <= 3; i++) {
+        int* slot = ring.BeginWrite();
+        CHECK(slot != nullptr);
+        *slot = i;
+        ring.EndWrite();
+    }
+    CHECK(ring.BeginWrite() == nullptr);
+    CHECK(ring.DropOldest());
+    int* slot = ring.BeginWrite();
+    CHECK(slot != nullptr);
+    *slot = 4;
+    ring.EndWrite();
+
+    for (int expected = 2; expected <= 4; expected++) {
+        int* read = ring.BeginRead();
+        CHECK(read != nullptr);
+        CHECK(*read == expected);
+        ring.EndRead();
+    }
+    CHECK(ring.BeginRead() == nullptr);
+    CHECK(!ring.DropOldest());
+}
+
+// The writer drops frames while the reader is in a slot, the slot must stay untouched
+TEST(FrameRingKeepsTheSlotBeingRead) {
+    struct Item {
+        uint64_t first = 0;
+        uint64_t last = 0;
+    };
+    FrameRing<Item, 4> ring;
+    const uint64_t kItems = 200000;
+    std::atomic<bool> done{ false };
+    std::thread writer([&]() {
+        for (uint64_t i = 1; i <= kItems; i++) {
+            Item* slot = ring.BeginWrite();
+            if (slot == nullptr) {
+                ring.DropOldest();
+                slot = ring.BeginWrite();
+                if (slot == nullptr)
+                    continue;
+            }
+            slot->first = i;
+            slot->last = i;
+            ring.EndWrite();
+        }
+        done = true;
+    });
+
+    uint64_t previous = 0;
+    bool is_ok = true;
+    while (!done || ring.Size() > 0) {
+        Item* slot = ring.BeginRead();
+        if (slot == nullptr)
+            continue;
+        uint64_t first = slot->first;
+        std::this_thread::yield();
+        uint64_t last = slot->last;
+        is_ok = is_ok && (first == last) && (first > previous);
+        previous = first;
+        ring.EndRead();
+    }
+    writer.join();
+    CHECK(is_ok);
+}
+
+// The UI does not read while the camera keeps producing: the oldest frames are dropped
+TEST(CaptureWorkerKeepsNewestFrameWhenUiStalls) {
+    const uint64_t kFrames = 20;
+    uint64_t next_frame_id = 0;
+    CaptureWorker worker([&](FrameResult& frame) {
+        if (next_frame_id >= kFrames)
+            return false;
+        frame.frame_id = ++next_frame_id;
+        return true;
+    });
+    worker.Start();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (worker.GetProducedCount() < kFrames && std::chrono::steady_clock::now() < deadline)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    worker.Stop();
+
+    CHECK(worker.GetProducedCount() == kFrames);
+    CHECK(worker.GetDroppedCount() == kFrames - (kFrameRingSize - 1));
+    FrameResult frame;
+    CHECK(worker.GetLatestFrame(frame));
+    CHECK(frame.frame_id == kFrames);
+    CHECK(frame.sequence == kFrames);
+    CHECK(!worker.GetLatestFrame(frame));
+}
@@ -0,0 +1,155 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file exposure_controller_test.cpp
+* @brief Exposure and gain steps against a simulated node map and synthetic regions
+* @date 2026/10
+*/
+
+#include <cmath>
+
+#include "exposure_controller.h"
+#include "node_access.h"
+#include "./test.h"
+
+// Counts the float writes, which throw outside of the node ranges
+class ExposureNodeAccess : public MemoryNodeAccess {
+public:
+    int writes = 0;
+
+    ExposureNodeAccess(const double exposure_us, const double gain_db) {
+        SetFloatRange(Resolve("ExposureTime"), 10.0, 30000.0);
+        SetFloatRange(Resolve("Gain"), 0.0, 24.0);
+        MemoryNodeAccess::SetFloat(Resolve("ExposureTime"), exposure_us);
+        MemoryNodeAccess::SetFloat(Resolve("Gain"), gain_db);
+    }
+
+    void SetFloat(const NodeHandle node, const double value) override {
+        writes++;
+        MemoryNodeAccess::SetFloat(node, value);
+    }
+
+    double Get(const char* node_name) {
+        return GetFloat(Resolve(node_name));
+    }
+};
+
+static ExposureSettings MakeSettings() {
+    ExposureSettings settings;
+    settings.enabled = true;
+    settings.window_frames = 1;
+    settings.settle_frames = 2;
+    return settings;
+}
+
+// One frame with one region of a single level
+static bool RunFrame(ExposureController& controller, ExposureNodeAccess& nodes, const int level, const bool is_decoded) {
+    controller.OnRegion(cv::Mat(32, 32, CV_8UC1, cv::Scalar(level)), is_decoded);
+    return controller.OnFrame(nodes);
+}
+
+TEST(ExposureRaisesExposureTimeBeforeGain) {
+    ExposureNodeAccess nodes(1000.0, 0.0);
+    ExposureController controller;
+    controller.SetSettings(MakeSettings());
+    CHECK(controller.Attach(nodes));
+    CHECK(nodes.GetEnumeration(nodes.Resolve("ExposureAuto")) == "Off");
+
+    // Twice as bright at most per step
+    CHECK(RunFrame(controller, nodes, 50, false));
+    CHECK(std::abs(nodes.Get("ExposureTime") - 2000.0) < 1.0);
+    CHECK(nodes.Get("Gain") == 0.0);
+
+    // Gain only takes what max_exposure_us leaves
+    ExposureNodeAccess long_nodes(15000.0, 0.0);
+    ExposureController long_controller;
+    long_controller.SetSettings(MakeSettings());
+    long_controller.Attach(long_nodes);
+    CHECK(RunFrame(long_controller, long_nodes, 50, false));
+    CHECK(long_nodes.Get("ExposureTime") == 20000.0);
+    CHECK(std::abs(long_nodes.Get("Gain") - 20.0 * std::log10(2.0 * 15000.0 / 20000.0)) < 0.01);
+}
+
+TEST(ExposureLowersGainBeforeExposureTime) {
+    ExposureNodeAccess nodes(1000.0, 6.0);
+    ExposureController controller;
+    controller.SetSettings(MakeSettings());
+    controller.Attach(nodes);
+
+    // Clipped bars step down by kSaturatedStep_
+    CHECK(RunFrame(controller, nodes, 255, false));
+    CHECK(std::abs(nodes.Get("Gain") - (6.0 + 20.0 * std::log10(0.7))) < 0.01);
+    CHECK(nodes.Get("ExposureTime") == 1000.0);
+
+    // Exposure time only takes what min_gain_db leaves
+    ExposureNodeAccess low_nodes(1000.0, 1.0);
+    ExposureController low_controller;
+    low_controller.SetSettings(MakeSettings());
+    low_controller.Attach(low_nodes);
+    CHECK(RunFrame(low_controller, low_nodes, 255, false));
+    CHECK(low_nodes.Get("Gain") == 0.0);
+    CHECK(std::abs(low_nodes.Get("ExposureTime") - 1000.0 * std::pow(10.0, (20.0 * std::log10(0.7) + 1.0) / 20.0)) < 1.0);
+}
+
+TEST(ExposureStaysWithinLimits) {
+    ExposureNodeAccess nodes(1000.0, 0.0);
+    // The node range is narrower than the settings on the exposure time
+    nodes.SetFloatRange(nodes.Resolve("ExposureTime"), 200.0, 5000.0);
+    ExposureSettings settings = MakeSettings();
+    settings.settle_frames = 0;
+    ExposureController controller;
+    controller.SetSettings(settings);
+    controller.Attach(nodes);
+
+    for (int frame = 0; frame < 50; frame++)
+        RunFrame(controller, nodes, 10, false);
+    CHECK(nodes.Get("ExposureTime") == 5000.0);
+    CHECK(nodes.Get("Gain") == 12.0);
+    // Nothing is left to change
+    int writes = nodes.writes;
+    CHECK(!RunFrame(controller, nodes, 10, false));
+    CHECK(nodes.writes == writes);
+
+    for (int frame = 0; frame < 50; frame++)
+        RunFrame(controller, nodes, 255, false);
+    CHECK(nodes.Get("ExposureTime") == 200.0);
+    CHECK(nodes.Get("Gain") == 0.0);
+}
+
+TEST(ExposureWaitsForSettleFrames) {
+    ExposureNodeAccess nodes(1000.0, 0.0);
+    ExposureController controller;
+    controller.SetSettings(MakeSettings());
+    controller.Attach(nodes);
+
+    CHECK(RunFrame(controller, nodes, 50, false));
+    int writes = nodes.writes;
+    // Regions of the frames taken before the new values are in the image are not measured
+    CHECK(!RunFrame(controller, nodes, 50, false));
+    CHECK(!RunFrame(controller, nodes, 50, false));
+    CHECK(nodes.writes == writes);
+    CHECK(RunFrame(controller, nodes, 50, false));
+    CHECK(nodes.writes > writes);
+    CHECK(controller.GetStats().adjustments == 2);
+}
+
+TEST(ExposureHoldsWhileScansSucceed) {
+    ExposureNodeAccess nodes(1000.0, 0.0);
+    ExposureSettings settings = MakeSettings();
+    settings.window_frames = 10;
+    ExposureController controller;
+    controller.SetSettings(settings);
+    controller.Attach(nodes);
+
+    // Nine of ten regions decoded, success_hold is 0.9
+    for (int frame = 0; frame < 10; frame++)
+        CHECK(!RunFrame(controller, nodes, 50, frame != 0));
+    CHECK(nodes.writes == 0);
+    CHECK(std::abs(controller.GetStats().success_rate - 0.9) < 1e-9);
+
+    // Eight of ten are not
+    bool is_written = false;
+    for (int frame = 0; frame < 10; frame++)
+        is_written = RunFrame(controller, nodes, 50, frame > 1);
+    CHECK(is_written && nodes.writes == 2);
+}
@@ -0,0 +1,77 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file frame_pairer_test.cpp
+* @brief History frames keep only the DNN window of their RAW image
+* @date 2026/10
+*/
+
+#include <vector>
+
+#include "frame_pairer.h"
+#include "./test.h"
+
+static const uint64_t kMono8 = 0x01080001;
+
+TEST(FramePairerKeepsOnlyWindowOfHistoryFrame) {
+    FramePairer pairer;
+    PairingSettings settings;
+    settings.offset = 1;
+    pairer.SetSettings(settings);
+
+    std::vector<uint8_t> pixels(64 * 32);
+    for (size_t i = 0; i < pixels.size(); i++)
+        pixels[i] = (uint8_t)i;
+    RawFrame raw;
+    raw.frame_id = 1;
+    raw.timestamp_ns = 1000;
+    raw.width = 64;
+    raw.height = 32;
+    raw.pixel_format = kMono8;
+    raw.data = pixels.data();
+    ROI raw_roi = { 0, 100, 200, 64, 32 };
+    // Odd offsets are moved down to keep the Bayer phase
+    ROI window = { 0, 111, 205, 20, 10 };
+    pairer.Push(raw, 5, raw_roi, window, 1, window);
+
+    const HistoryFrame* frame = nullptr;
+    CHECK(pairer.Pair(2, 2000, -1, -1, frame) == FramePairer::kHistory);
+    CHECK(frame->raw_roi.offset_x == 110 && frame->raw_roi.offset_y == 204);
+    CHECK(frame->width == 21 && frame->height == 11);
+    CHECK(frame->raw.size() == 21 * 11);
+    CHECK(frame->raw[0] == pixels[4 * 64 + 10]);
+    CHECK(frame->raw[21 * 10 + 20] == pixels[14 * 64 + 30]);
+    CHECK(frame->dnn_roi.offset_x == 111 && frame->roi_ticket == 1);
+    CHECK(pairer.GetStats().history_copies == 1);
+}
+
+TEST(FramePairerKeepsNoPixelsOutsideWindow) {
+    FramePairer pairer;
+    PairingSettings settings;
+    settings.offset = 1;
+    pairer.SetSettings(settings);
+
+    std::vector<uint8_t> pixels(16 * 16);
+    RawFrame raw;
+    raw.frame_id = 1;
+    raw.width = 16;
+    raw.height = 16;
+    raw.pixel_format = kMono8;
+    raw.data = pixels.data();
+    ROI raw_roi = { 0, 0, 0, 16, 16 };
+    ROI outside = { 0, 100, 100, 16, 16 };
+    pairer.Push(raw, 5, raw_roi, raw_roi, 1, outside);
+    ROI empty = { 0, 0, 0, 0, 0 };
+    raw.frame_id = 2;
+    pairer.Push(raw, 6, raw_roi, raw_roi, 2, empty);
+
+    // Still known without their pixels, so that their boxes can be placed
+    const HistoryFrame* frame = nullptr;
+    CHECK(pairer.Pair(2, 0, -1, -1, frame) == FramePairer::kMissing);
+    CHECK(frame != nullptr && frame->frame_id == 1 && frame->roi_ticket == 1);
+    CHECK(pairer.Pair(3, 0, -1, -1, frame) == FramePairer::kMissing);
+    CHECK(frame != nullptr && frame->frame_id == 2 && frame->roi_ticket == 2);
+    CHECK(pairer.Pair(9, 0, -1, -1, frame) == FramePairer::kMissing);
+    CHECK(frame == nullptr);
+    CHECK(pairer.GetStats().history_copies == 0);
+}
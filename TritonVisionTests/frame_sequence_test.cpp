@@ -0,0 +1,39 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file frame_sequence_test.cpp
+* @brief Camera gaps against the frames the acquisition policy skipped
+* @date 2026/10
+*/
+
+#include "frame_sequence.h"
+#include "./test.h"
+
+TEST(FrameSequenceSeparatesPolicySkipsFromGaps) {
+    FrameSequenceTracker tracker;
+    CHECK(tracker.OnFrame(10, 0, false, 0, 0) == FrameSequenceTracker::kNone);
+    // Three frames replaced by the driver
+    CHECK(tracker.OnFrame(14, 3, false, 0, 0) == FrameSequenceTracker::kNone);
+    // Two frames lost on top of one skipped
+    CHECK(tracker.OnFrame(18, 1, false, 0, 0) == FrameSequenceTracker::kCameraGap);
+    // More skips than the gap are not counted twice
+    CHECK(tracker.OnFrame(19, 5, false, 0, 0) == FrameSequenceTracker::kNone);
+
+    SequenceStats stats = tracker.GetStats();
+    CHECK(stats.frames == 4);
+    CHECK(stats.source_skips == 4);
+    CHECK(stats.camera_gaps == 2);
+}
+
+TEST(FrameSequenceExpectsTensorsToFollowSkippedFrames) {
+    FrameSequenceTracker tracker;
+    tracker.OnFrame(100, 0, true, 20, 20);
+    // The IMX500 ran on the skipped frames as well, so its counter moved as far
+    CHECK(tracker.OnFrame(104, 3, true, 24, 24) == FrameSequenceTracker::kNone);
+    CHECK(tracker.OnFrame(105, 0, true, 24, 24) == FrameSequenceTracker::kDnnDuplicate);
+
+    SequenceStats stats = tracker.GetStats();
+    CHECK(stats.camera_gaps == 0);
+    CHECK(stats.dnn_gaps == 0);
+    CHECK(stats.dnn_duplicates == 1);
+}
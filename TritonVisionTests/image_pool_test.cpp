@@ -0,0 +1,87 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file image_pool_test.cpp
+* @brief No image buffer is allocated once the first frame has warmed the pool up
+* @date 2026/10
+*/
+
+#include <vector>
+
+#include "frame_context.h"
+#include "image_pool.h"
+#include "./test.h"
+
+TEST(ImagePoolReusesReleasedBuffers) {
+    ImagePool pool;
+    cv::Mat image;
+    pool.Reshape(image, 120, 160, CV_8UC3);
+    CHECK(pool.GetAllocationCount() == 1);
+    CHECK(pool.GetAllocatedBytes() == 120 * 160 * 3);
+
+    // Same size and type: kept as it is
+    uint8_t* data = image.data;
+    pool.Reshape(image, 120, 160, CV_8UC3);
+    CHECK(image.data == data);
+
+    // Released buffers are handed out again, shared ones are not taken back
+    pool.Release(image);
+    pool.Reshape(image, 120, 160, CV_8UC3);
+    CHECK(image.data == data);
+    cv::Mat shared = image;
+    pool.Release(image);
+    pool.Reshape(image, 120, 160, CV_8UC3);
+    CHECK(image.data != data);
+    CHECK(pool.GetAllocationCount() == 2);
+}
+
+// What the capture thread does with each frame, and the UI with the results
+static void ProcessFrame(ImagePool& pool, FrameContext& context, const std::vector<uint8_t>& pixels, const uint64_t pixel_format, const int frame, cv::Mat& preview, cv::Mat& detail) {
+    const int width = 256;
+    const int height = 192;
+    const int decimation = 4;
+    context.Reset(pixels.data(), width, height, pixel_format);
+
+    const cv::Mat& bgr = context.GetPreviewBgr(decimation);
+    pool.Reshape(preview, bgr.rows, bgr.cols, bgr.type());
+    bgr.copyTo(preview);
+    context.GetPreviewGray(decimation);
+
+    // Regions move from frame to frame but keep their sizes
+    cv::Rect region(8 + frame * 4, 16 + frame * 2, 64, 32);
+    context.GetRegionGray(region);
+    context.GetRegionBinary(region);
+    const cv::Mat& detail_bgr = context.GetRegionBgr(cv::Rect(frame * 2, frame * 2, 48, 48));
+    pool.Reshape(detail, detail_bgr.rows, detail_bgr.cols, detail_bgr.type());
+    detail_bgr.copyTo(detail);
+
+    // The buffer goes back to the camera, decoding goes on with the copies
+    context.Detach();
+    context.GetRegionBinary(region);
+}
+
+TEST(FrameContextAllocatesOnlyOnFirstFrame) {
+    const uint64_t formats[] = { BayerRG8, Mono8 };
+    for (uint64_t pixel_format : formats) {
+        ImagePool pool;
+        FrameContext context(pool);
+        std::vector<uint8_t> pixels(256 * 192);
+        for (size_t i = 0; i < pixels.size(); i++)
+            pixels[i] = (uint8_t)(i * 7);
+
+        cv::Mat preview, detail;
+        ProcessFrame(pool, context, pixels, pixel_format, 0, preview, detail);
+        uint64_t warm_count = pool.GetAllocationCount();
+        uint64_t warm_bytes = pool.GetAllocatedBytes();
+        CHECK(warm_count > 0);
+
+        for (int frame = 1; frame < 10; frame++) {
+            // The UI hands the result buffers back before the next frame
+            pool.Release(preview);
+            pool.Release(detail);
+            ProcessFrame(pool, context, pixels, pixel_format, frame, preview, detail);
+            CHECK(pool.GetAllocationCount() == warm_count);
+        }
+        CHECK(pool.GetAllocatedBytes() == warm_bytes);
+    }
+}
@@ -0,0 +1,105 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file imx501_utils_test.cpp
+* @brief Input image extraction, the SSSE3 interleave against the scalar loop
+* @date 2026/10
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "IMX501Utils.h"
+#include "./test.h"
+
+// Only the protected static members are used, it is never constructed
+class InputImageExtractor : public ArenaExample::IMX501Utils {
+public:
+    using IMX501Utils::input_image_layout;
+    using IMX501Utils::ExtractInputImage;
+};
+
+// An input tensor of R, G and B planes laid out in chunk lines of line_width bytes
+// every line_stride bytes, the gap filled with bytes that must not be read
+struct TensorLines {
+    InputImageExtractor::input_image_layout layout;
+    size_t line_width;
+    size_t line_stride;
+    std::vector<uint8_t> flat;   // Without the chunk line padding
+    std::vector<uint8_t> lines;
+};
+
+static TensorLines MakeTensorLines(const size_t width, const size_t height, const size_t x_padding, const size_t y_padding, const size_t line_width, const size_t line_stride) {
+    TensorLines tensor;
+    tensor.layout = { width, height, x_padding, y_padding, 0x80 };
+    tensor.line_width = line_width;
+    tensor.line_stride = line_stride;
+    size_t plane_size = (width + x_padding) * height + width * y_padding;
+    tensor.flat.resize(plane_size * 3);
+    for (size_t i = 0; i < tensor.flat.size(); i++)
+        tensor.flat[i] = (uint8_t)(i * 131 + 7);
+    size_t num_lines = (tensor.flat.size() + line_width - 1) / line_width;
+    tensor.lines.assign(num_lines * line_stride, 0xEE);
+    for (size_t i = 0; i < tensor.flat.size(); i++)
+        tensor.lines[(i / line_width) * line_stride + i % line_width] = tensor.flat[i];
+    return tensor;
+}
+
+// BGR read element by element from the flat tensor
+static std::vector<uint8_t> ExpectedImage(const TensorLines& tensor) {
+    const InputImageExtractor::input_image_layout& layout = tensor.layout;
+    size_t plane_size = (layout.width + layout.x_padding) * layout.height + layout.width * layout.y_padding;
+    std::vector<uint8_t> image(layout.width * layout.height * 3);
+    for (size_t y = 0; y < layout.height; y++) {
+        for (size_t x = 0; x < layout.width; x++) {
+            size_t element = (layout.width + layout.x_padding) * y + x;
+            for (size_t c = 0; c < 3; c++)
+                image[(y * layout.width + x) * 3 + 2 - c] = tensor.flat[plane_size * c + element] ^ layout.offset;
+        }
+    }
+    return image;
+}
+
+static void CheckExtraction(const TensorLines& tensor) {
+    std::vector<uint8_t> expected = ExpectedImage(tensor);
+    std::vector<uint8_t> simd(expected.size());
+    std::vector<uint8_t> scalar(expected.size());
+    InputImageExtractor::ExtractInputImage(&tensor.layout, tensor.lines.data(), tensor.line_width, tensor.line_stride, simd.data(), true);
+    InputImageExtractor::ExtractInputImage(&tensor.layout, tensor.lines.data(), tensor.line_width, tensor.line_stride, scalar.data(), false);
+    CHECK(scalar == expected);
+    CHECK(simd == expected);
+}
+
+TEST(InputImageSimdMatchesScalar) {
+    CheckExtraction(MakeTensorLines(256, 256, 0, 0, 4096, 4096));
+    CheckExtraction(MakeTensorLines(320, 320, 3, 2, 2000, 2048));
+}
+
+TEST(InputImageSimdMatchesScalarOnOddWidths) {
+    // Widths below, at and around one 16 pixel block, and runs cut by odd chunk lines
+    const size_t widths[] = { 1, 15, 16, 17, 31, 33, 255, 257 };
+    for (size_t width : widths) {
+        CheckExtraction(MakeTensorLines(width, 7, 0, 0, width * 3, width * 3));
+        CheckExtraction(MakeTensorLines(width, 7, 1, 3, 97, 112));
+        CheckExtraction(MakeTensorLines(width, 7, 5, 0, 2001, 2048));
+    }
+}
+
+BENCHMARK(InputImageExtraction) {
+    const size_t sizes[] = { 256, 320, 512, 640 };
+    const int iterations = 500;
+    for (size_t size : sizes) {
+        TensorLines tensor = MakeTensorLines(size, size, 3, 2, 2000, 2048);
+        std::vector<uint8_t> image(size * size * 3);
+        double ms[2];
+        for (int allow_simd = 0; allow_simd < 2; allow_simd++) {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < iterations; i++)
+                InputImageExtractor::ExtractInputImage(&tensor.layout, tensor.lines.data(), tensor.line_width, tensor.line_stride, image.data(), allow_simd != 0);
+            ms[allow_simd] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+        }
+        printf("  %zux%zu scalar %.3f ms, SSSE3 %.3f ms, x%.1f\n", size, size, ms[0], ms[1], ms[0] / ms[1]);
+        CHECK(image == ExpectedImage(tensor));
+    }
+}
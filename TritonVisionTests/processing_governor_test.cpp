@@ -0,0 +1,143 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file processing_governor_test.cpp
+* @brief Stage admission and decoder adaptation of the processing governor
+* @date 2026/10
+*/
+
+#include <chrono>
+#include <string>
+
+#include "processing_governor.h"
+#include "./test.h"
+
+static void SetBudget(ProcessingGovernor& governor, const double budget_ms) {
+    GovernorSettings settings;
+    settings.budget_ms = budget_ms;
+    governor.SetSettings(settings);
+}
+
+TEST(GovernorResumesDecodingAfterSlowDecode) {
+    ProcessingGovernor governor;
+    SetBudget(governor, 10.0);
+
+    // One decode that took the budget many times over
+    governor.BeginFrame(std::chrono::steady_clock::now());
+    CHECK(governor.Admit(ProcessingGovernor::kDecode));
+    governor.EndStage(ProcessingGovernor::kDecode, 100.0);
+    governor.EndFrame();
+
+    // The first decode of each frame is still measured, further ones wait for the cost to come down
+    governor.BeginFrame(std::chrono::steady_clock::now());
+    CHECK(governor.Admit(ProcessingGovernor::kDecode));
+    CHECK(!governor.Admit(ProcessingGovernor::kDecode));
+    governor.EndStage(ProcessingGovernor::kDecode, 1.0);
+    governor.EndFrame();
+
+    int resumed_after = 0;
+    for (int frame = 1; frame <= 100 && resumed_after == 0; frame++) {
+        governor.BeginFrame(std::chrono::steady_clock::now());
+        CHECK(governor.Admit(ProcessingGovernor::kDecode));
+        governor.EndStage(ProcessingGovernor::kDecode, 1.0);
+        if (governor.Admit(ProcessingGovernor::kDecode))
+            resumed_after = frame;
+        governor.EndFrame();
+    }
+    CHECK(resumed_after > 0);
+    CHECK(governor.GetStats().decode_ms < 10.0);
+}
+
+TEST(GovernorForgetsCostsWithNewBudget) {
+    ProcessingGovernor governor;
+    SetBudget(governor, 10.0);
+    governor.BeginFrame(std::chrono::steady_clock::now());
+    governor.Admit(ProcessingGovernor::kDecode);
+    governor.EndStage(ProcessingGovernor::kDecode, 100.0);
+    governor.EndStage(ProcessingGovernor::kOverlay, 100.0);
+    governor.EndFrame();
+
+    SetBudget(governor, 20.0);
+    governor.BeginFrame(std::chrono::steady_clock::now());
+    CHECK(governor.Admit(ProcessingGovernor::kDecode));
+    CHECK(governor.Admit(ProcessingGovernor::kDecode));
+    CHECK(governor.Admit(ProcessingGovernor::kOverlay));
+    governor.EndFrame();
+}
+
+TEST(GovernorDefersStageAtMostTenFrames) {
+    ProcessingGovernor governor;
+    SetBudget(governor, 10.0);
+    governor.BeginFrame(std::chrono::steady_clock::now());
+    governor.EndStage(ProcessingGovernor::kOverlay, 100.0);
+    governor.EndFrame();
+
+    // kMaxDeferred_ frames in a row, then it runs whatever it costs
+    int deferred = 0;
+    for (int frame = 0; frame < 20; frame++) {
+        governor.BeginFrame(std::chrono::steady_clock::now());
+        bool is_admitted = governor.Admit(ProcessingGovernor::kOverlay);
+        governor.EndFrame();
+        if (is_admitted)
+            break;
+        deferred++;
+    }
+    CHECK(deferred == 10);
+    CHECK(governor.GetStats().deferred_overlays == 10);
+
+    // The count starts over once the stage has run
+    governor.BeginFrame(std::chrono::steady_clock::now());
+    CHECK(!governor.Admit(ProcessingGovernor::kOverlay));
+    governor.EndFrame();
+}
+
+TEST(GovernorReusesDecodedTrackByOverlap) {
+    ProcessingGovernor governor;
+    SetBudget(governor, 10.0);
+    governor.AddDecodedTrack(cv::Rect(100, 100, 100, 100), "4901234567894");
+
+    std::string result;
+    // Intersection over union 0.25
+    CHECK(!governor.FindDecodedTrack(cv::Rect(150, 150, 100, 100), result));
+    // 0.6, the track follows the barcode
+    CHECK(governor.FindDecodedTrack(cv::Rect(125, 100, 100, 100), result));
+    CHECK(result == "4901234567894");
+    CHECK(governor.FindDecodedTrack(cv::Rect(150, 100, 100, 100), result));
+    CHECK(governor.GetStats().reused_tracks == 2);
+
+    // Forgotten once it was not seen for kTrackFrames_ frames
+    for (int frame = 0; frame < 16; frame++) {
+        governor.BeginFrame(std::chrono::steady_clock::now());
+        governor.EndFrame();
+    }
+    CHECK(!governor.FindDecodedTrack(cv::Rect(150, 100, 100, 100), result));
+}
+
+// Frames that took the given time, by starting them that long ago
+static void RunFrames(ProcessingGovernor& governor, const int frames, const int frame_ms) {
+    for (int frame = 0; frame < frames; frame++) {
+        governor.BeginFrame(std::chrono::steady_clock::now() - std::chrono::milliseconds(frame_ms));
+        governor.EndFrame();
+    }
+}
+
+TEST(GovernorTightensAndRelaxesDecoder) {
+    ProcessingGovernor governor;
+    SetBudget(governor, 20.0);
+    CHECK(governor.GetRowStep() == 1 && governor.GetMaxRotations() == 3);
+
+    // Rows first, every kAdaptInterval_ frames over the budget
+    RunFrames(governor, 10, 40);
+    CHECK(governor.GetRowStep() == 2 && governor.GetMaxRotations() == 3);
+    RunFrames(governor, 20, 40);
+    CHECK(governor.GetRowStep() == 8 && governor.GetMaxRotations() == 3);
+    RunFrames(governor, 20, 40);
+    CHECK(governor.GetRowStep() == 8 && governor.GetMaxRotations() == 1);
+
+    // Rotations come back first, once the smoothed frame time is below the headroom
+    RunFrames(governor, 100, 0);
+    CHECK(governor.GetMaxRotations() == 3);
+    RunFrames(governor, 30, 0);
+    CHECK(governor.GetRowStep() == 1 && governor.GetMaxRotations() == 3);
+    CHECK(governor.GetStats().over_budget == 50);
+}
@@ -0,0 +1,70 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file raw_roi_tracker_test.cpp
+* @brief RAW window decisions for detections that come and go
+* @date 2026/10
+*/
+
+#include <vector>
+
+#include "raw_roi_tracker.h"
+#include "./test.h"
+
+static RoiTrackingSettings MakeSettings(const int expand_after, const int hold_frames) {
+    RoiTrackingSettings settings;
+    settings.enabled = true;
+    settings.margin = 0;
+    settings.history_frames = 1;
+    settings.expand_after = expand_after;
+    settings.hold_frames = hold_frames;
+    settings.min_width = 64;
+    settings.min_height = 64;
+    return settings;
+}
+
+TEST(RawRoiTrackerHoldsWindowBeforeShrinking) {
+    RawRoiTracker tracker;
+    tracker.SetSettings(MakeSettings(2, 6));
+    ROI bounds = { 0, 0, 0, 1024, 1024 };
+    tracker.Reset(bounds, bounds);
+    std::vector<cv::Rect> detection(1, cv::Rect(96, 96, 64, 64));
+    std::vector<cv::Rect> none;
+    ROI window;
+
+    // Reset starts the hold as well
+    for (int i = 0; i < 5; i++)
+        CHECK(!tracker.OnFrame(detection, true, window));
+    CHECK(tracker.OnFrame(detection, true, window));
+    CHECK(window.width == 64 && window.height == 64);
+
+    // Opens to the bounds once nothing is seen, growing is not held
+    CHECK(!tracker.OnFrame(none, true, window));
+    CHECK(tracker.OnFrame(none, true, window));
+    CHECK(window.width == 1024);
+
+    // The detection is back at once, the window is not shrunk before the hold ran out
+    int shrunk_after = 0;
+    for (int i = 1; i <= 10 && shrunk_after == 0; i++) {
+        if (tracker.OnFrame(detection, true, window))
+            shrunk_after = i;
+    }
+    CHECK(shrunk_after == 6);
+    CHECK(window.width == 64);
+
+    RoiTrackingStats stats = tracker.GetStats();
+    CHECK(stats.updates == 3 && stats.expansions == 1);
+}
+
+TEST(RawRoiTrackerFollowsDetectionsDuringHold) {
+    RawRoiTracker tracker;
+    tracker.SetSettings(MakeSettings(5, 100));
+    ROI bounds = { 0, 0, 0, 1024, 1024 };
+    ROI start = { 0, 0, 0, 64, 64 };
+    tracker.Reset(bounds, start);
+    std::vector<cv::Rect> detection(1, cv::Rect(512, 512, 64, 64));
+    ROI window;
+
+    CHECK(tracker.OnFrame(detection, true, window));
+    CHECK(window.offset_x == 512 && window.offset_y == 512 && window.width == 64);
+}
@@ -0,0 +1,193 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file roi_switcher_test.cpp
+* @brief Staged ROI writes against a simulated node map
+* @date 2026/10
+*/
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "node_access.h"
+#include "roi_switcher.h"
+#include "./test.h"
+
+static const RoiNodeNames kDnnNodes = { "DeepNeuralNetworkROIOffsetX", "DeepNeuralNetworkROIOffsetY", "DeepNeuralNetworkROIWidth", "DeepNeuralNetworkROIHeight" };
+static const RoiNodeNames kRawNodes = { "OffsetX", "OffsetY", "Width", "Height" };
+
+// Records every write that reaches the node map, can lock nodes and reject values
+class TestNodeAccess : public MemoryNodeAccess {
+public:
+    std::vector<std::string> written;
+    std::vector<std::string> locked;
+    int64_t max_offset = INT64_MAX;
+
+    bool IsWritable(const NodeHandle node) override {
+        for (const auto& name : locked) {
+            if (name == GetName(node))
+                return false;
+        }
+        return true;
+    }
+
+    void SetInteger(const NodeHandle node, const int64_t value) override {
+        const std::string& name = GetName(node);
+        if (name.find("Offset") != std::string::npos && value > max_offset)
+            throw std::out_of_range("Value out of range for " + name);
+        written.push_back(name);
+        MemoryNodeAccess::SetInteger(node, value);
+    }
+
+    int64_t Get(const char* node_name) {
+        return GetInteger(Resolve(node_name));
+    }
+};
+
+static RoiRequest MakeRawRequest(const int roi_id, const int offset_x, const int offset_y, const int width, const int height) {
+    RoiRequest request;
+    request.roi_id = roi_id;
+    request.has_raw = true;
+    request.raw_roi.id = roi_id;
+    request.raw_roi.offset_x = offset_x;
+    request.raw_roi.offset_y = offset_y;
+    request.raw_roi.width = width;
+    request.raw_roi.height = height;
+    return request;
+}
+
+TEST(RoiSwitcherWritesStagedRequestBetweenFrames) {
+    TestNodeAccess nodes;
+    nodes.SetInteger(nodes.Resolve("Width"), 4052);
+    nodes.SetInteger(nodes.Resolve("Height"), 3036);
+    nodes.written.clear();
+    RoiSwitcher switcher(nodes, kDnnNodes, kRawNodes);
+    int stops = 0, starts = 0;
+    auto stop = [&]() { stops++; };
+    auto start = [&]() { starts++; };
+
+    CHECK(!switcher.ApplyPending(true, stop, start));
+    uint64_t ticket = switcher.Stage(MakeRawRequest(1, 102, 50, 1001, 803));
+    CHECK(nodes.written.empty());
+    CHECK(switcher.HasPending());
+
+    CHECK(switcher.ApplyPending(true, stop, start));
+    CHECK(!switcher.HasPending());
+    CHECK(stops == 0 && starts == 0);
+    // Aligned to 4, sizes shrink before their offsets move
+    CHECK(nodes.Get("OffsetX") == 100);
+    CHECK(nodes.Get("OffsetY") == 48);
+    CHECK(nodes.Get("Width") == 1000);
+    CHECK(nodes.Get("Height") == 800);
+    CHECK(nodes.written.size() == 4);
+    CHECK(nodes.written[0] == "Width" && nodes.written[1] == "OffsetX");
+    CHECK(nodes.written[2] == "Height" && nodes.written[3] == "OffsetY");
+
+    RoiSwitchRecord record;
+    CHECK(switcher.OnFrame(7, 0, record));
+    CHECK(record.ticket == ticket);
+    CHECK(record.effective_frame_id == 7);
+    CHECK(!record.failed && !record.restarted_stream);
+    CHECK(!switcher.OnFrame(8, 0, record));
+
+    RoiSwitchStats stats = switcher.GetStats();
+    CHECK(stats.switches == 1 && stats.failures == 0);
+    CHECK(stats.last_roi_id == 1 && stats.last_frame_id == 7);
+}
+
+TEST(RoiSwitcherKeepsOnlyLatestStagedRequest) {
+    TestNodeAccess nodes;
+    RoiSwitcher switcher(nodes, kDnnNodes, kRawNodes);
+    auto none = []() {};
+
+    switcher.Stage(MakeRawRequest(1, 0, 0, 400, 400));
+    uint64_t ticket = switcher.Stage(MakeRawRequest(2, 800, 800, 640, 480));
+    nodes.written.clear();
+    CHECK(switcher.ApplyPending(true, none, none));
+    CHECK(nodes.Get("OffsetX") == 800 && nodes.Get("Width") == 640);
+
+    // Unchanged values are not written again
+    nodes.written.clear();
+    switcher.Stage(MakeRawRequest(2, 800, 800, 640, 480));
+    CHECK(switcher.ApplyPending(true, none, none));
+    CHECK(nodes.written.empty());
+
+    RoiSwitchRecord record;
+    CHECK(switcher.OnFrame(3, 0, record));
+    CHECK(record.ticket == ticket + 1 && record.request.roi_id == 2);
+}
+
+TEST(RoiSwitcherRestartsStreamForLockedNodes) {
+    TestNodeAccess nodes;
+    nodes.locked.push_back("Width");
+    RoiSwitcher switcher(nodes, kDnnNodes, kRawNodes);
+    std::vector<std::string> calls;
+    auto stop = [&]() { calls.push_back("stop"); };
+    auto start = [&]() { calls.push_back("start"); };
+
+    switcher.Stage(MakeRawRequest(1, 0, 0, 640, 480));
+    CHECK(switcher.ApplyPending(true, stop, start));
+    CHECK(calls.size() == 2 && calls[0] == "stop" && calls[1] == "start");
+
+    RoiSwitchRecord record;
+    CHECK(switcher.OnFrame(1, 0, record));
+    CHECK(record.restarted_stream);
+    CHECK(switcher.GetStats().stream_restarts == 1);
+}
+
+TEST(RoiSwitcherMovesLockedSizeWithoutRestart) {
+    TestNodeAccess nodes;
+    nodes.SetInteger(nodes.Resolve("Width"), 640);
+    nodes.SetInteger(nodes.Resolve("Height"), 480);
+    nodes.locked.push_back("Width");
+    nodes.locked.push_back("Height");
+    nodes.written.clear();
+    RoiSwitcher switcher(nodes, kDnnNodes, kRawNodes);
+    int stops = 0, starts = 0;
+    auto stop = [&]() { stops++; };
+    auto start = [&]() { starts++; };
+
+    // Sizes that align to the current ones only move the window
+    switcher.Stage(MakeRawRequest(1, 800, 600, 642, 481));
+    CHECK(switcher.ApplyPending(true, stop, start));
+    CHECK(stops == 0 && starts == 0);
+    CHECK(nodes.written.size() == 2);
+    CHECK(nodes.Get("OffsetX") == 800 && nodes.Get("OffsetY") == 600);
+
+    switcher.Stage(MakeRawRequest(2, 0, 0, 320, 480));
+    CHECK(switcher.ApplyPending(true, stop, start));
+    CHECK(stops == 1 && starts == 1);
+}
+
+TEST(RoiSwitcherDropsRequestWhenWriteThrows) {
+    TestNodeAccess nodes;
+    nodes.locked.push_back("Width");
+    nodes.max_offset = 1000;
+    RoiSwitcher switcher(nodes, kDnnNodes, kRawNodes);
+    int stops = 0, starts = 0;
+    auto stop = [&]() { stops++; };
+    auto start = [&]() { starts++; };
+
+    uint64_t ticket = switcher.Stage(MakeRawRequest(3, 2000, 0, 640, 480));
+    CHECK(switcher.ApplyPending(true, stop, start));
+    CHECK(!switcher.HasPending());
+    // The stream is started again although the writes did not complete
+    CHECK(stops == 1 && starts == 1);
+
+    RoiSwitchRecord record;
+    CHECK(switcher.OnFrame(5, 0, record));
+    CHECK(record.failed && record.ticket == ticket);
+    CHECK(switcher.GetLastRecord().ticket == 0);
+
+    RoiSwitchStats stats = switcher.GetStats();
+    CHECK(stats.failures == 1 && stats.switches == 0);
+    CHECK(stats.last_error.find("OffsetX") != std::string::npos);
+
+    // The next request goes through
+    nodes.max_offset = INT64_MAX;
+    switcher.Stage(MakeRawRequest(4, 2000, 0, 640, 480));
+    CHECK(switcher.ApplyPending(true, stop, start));
+    CHECK(switcher.OnFrame(6, 0, record));
+    CHECK(!record.failed && nodes.Get("OffsetX") == 2000);
+}
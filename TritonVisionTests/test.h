@@ -0,0 +1,52 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/**
+* @file test.h
+* @brief Test and benchmark registry of TritonVisionTests
+* @date 2026/10
+*/
+
+#ifndef TEST_H_
+#define TEST_H_
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct TestCase {
+    const char* name;
+    void (*run)();
+    bool is_benchmark;
+};
+
+std::vector<TestCase>& GetTestCases();
+
+struct TestRegistrar {
+    TestRegistrar(const char* name, void (*run)(), const bool is_benchmark) {
+        GetTestCases().push_back({ name, run, is_benchmark });
+    }
+};
+
+struct TestFailure : public std::runtime_error {
+    explicit TestFailure(const std::string& what) : std::runtime_error(what) {}
+};
+
+// Runs by default
+#define TEST(name) \
+    static void name(); \
+    static TestRegistrar name##_registrar_(#name, name, false); \
+    static void name()
+
+// Runs with --benchmark only, prints its own timings
+#define BENCHMARK(name) \
+    static void name(); \
+    static TestRegistrar name##_registrar_(#name, name, true); \
+    static void name()
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) \
+            throw TestFailure(std::string(__FILE__) + ":" + std::to_string(__LINE__) + ": CHECK(" #condition ") failed"); \
+    } while (0)
+
+#endif
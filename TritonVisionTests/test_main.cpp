@@ -0,0 +1,38 @@
+﻿// Copyright © 2024 Sony Semiconductor Solutions Corporation. All rights reserved.
+
+/*
+* @file test_main.cpp
+* @brief Runs the tests, or the benchmarks with --benchmark. Returns 1 when a test fails.
+* @date 2026/10
+*/
+
+#include <cstdio>
+#include <cstring>
+
+#include "./test.h"
+
+std::vector<TestCase>& GetTestCases() {
+    static std::vector<TestCase> test_cases;
+    return test_cases;
+}
+
+int main(int argc, char** argv) {
+    bool is_benchmark = (argc > 1 && strcmp(argv[1], "--benchmark") == 0);
+    int failed = 0;
+    int passed = 0;
+    for (const TestCase& test_case : GetTestCases()) {
+        if (test_case.is_benchmark != is_benchmark)
+            continue;
+        try {
+            test_case.run();
+            passed++;
+            printf("[  OK  ] %s\n", test_case.name);
+        }
+        catch (std::exception& ex) {
+            failed++;
+            printf("[FAILED] %s\n  %s\n", test_case.name, ex.what());
+        }
+    }
+    printf("%d passed, %d failed\n", passed, failed);
+    return (failed == 0) ? 0 : 1;
+}